@@ -120,16 +120,22 @@ bool EmulatorWindow::Initialize() {
         GpuClearCaches();
       } break;
       case 0x76: {  // VK_F7
-        // Save to file
+        // Save to file, shift for an incremental state against the full one.
         // TODO: Choose path based on user input, or from options
         // TODO: Spawn a new thread to do this.
-        emulator()->SaveToFile(L"test.sav");
+        if (e->is_shift_pressed()) {
+          emulator()->SaveToFile(L"test_incremental.sav", true);
+        } else {
+          emulator()->SaveToFile(L"test.sav");
+        }
       } break;
       case 0x77: {  // VK_F8
         // Restore from file
         // TODO: Choose path from user
         // TODO: Spawn a new thread to do this.
-        emulator()->RestoreFromFile(L"test.sav");
+        emulator()->RestoreFromFile(e->is_shift_pressed()
+                                        ? L"test_incremental.sav"
+                                        : L"test.sav");
       } break;
       case 0x7A: {  // VK_F11
         ToggleFullscreen();
@@ -12,6 +12,11 @@
 
 #include <algorithm>
 
+DEFINE_bool(huge_pages, false,
+            "Ask the host to back guest memory and generated code with "
+            "transparent huge pages where they're enabled (Linux only).",
+            "Memory");
+
 namespace xe {
 
 // TODO(benvanik): fancy AVX versions.
@@ -17,6 +17,9 @@
 
 #include "xenia/base/assert.h"
 #include "xenia/base/byte_order.h"
+#include "xenia/base/cvar.h"
+
+DECLARE_bool(huge_pages);
 
 namespace xe {
 namespace memory {
@@ -70,6 +73,14 @@ bool Protect(void* base_address, size_t length, PageAccess access,
 // the region.
 bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out);
 
+// Asks the system to back the given block of memory with huge pages where it
+// can, to cut down on TLB misses. Protect still works on single pages of the
+// block, at the cost of the huge pages involved being split again.
+// Returns false if the system doesn't support huge pages or has them
+// disabled. Returning true only means the advice was taken: the system still
+// decides which parts of the block get huge pages, and when.
+bool AdviseHugePages(void* base_address, size_t length);
+
 // Allocates a block of memory for a type with the given alignment.
 // The memory must be freed with AlignedFree.
 template <typename T>
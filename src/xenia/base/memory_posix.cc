@@ -13,6 +13,8 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <cstdio>
+#include <cstring>
 
 namespace xe {
 namespace memory {
@@ -61,6 +63,43 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return false;
 }
 
+// Whether madvise(MADV_HUGEPAGE) has any effect on private anonymous memory.
+// It succeeds even when transparent huge pages are disabled.
+static bool AreTransparentHugePagesAdvisable() {
+  FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (!file) {
+    return false;
+  }
+  // Like "always [madvise] never", with the active mode in brackets.
+  char modes[128];
+  bool advisable = false;
+  if (fgets(modes, sizeof(modes), file)) {
+    advisable =
+        std::strstr(modes, "[always]") || std::strstr(modes, "[madvise]");
+  }
+  fclose(file);
+  return advisable;
+}
+
+bool AdviseHugePages(void* base_address, size_t length) {
+#ifdef MADV_HUGEPAGE
+  // Transparent huge pages rather than hugetlbfs: they need no reserved pool
+  // and mprotect of a single page just splits the huge page it's in.
+  // MapFileView passes MAP_ANONYMOUS, which makes mmap ignore the shm_open
+  // descriptor, so views are private anonymous memory. The policy for that is
+  // transparent_hugepage/enabled. If views are ever mapped MAP_SHARED from the
+  // descriptor, transparent_hugepage/shmem_enabled applies instead, and it's
+  // "never" by default.
+  static const bool advisable = AreTransparentHugePagesAdvisable();
+  if (!advisable) {
+    return false;
+  }
+  return madvise(base_address, length, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif  // MADV_HUGEPAGE
+}
+
 FileMappingHandle CreateFileMappingHandle(std::wstring path, size_t length,
                                           PageAccess access, bool commit) {
   int oflag;
@@ -142,6 +142,12 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return true;
 }
 
+bool AdviseHugePages(void* base_address, size_t length) {
+  // Large pages need SeLockMemoryPrivilege, must be committed up front and
+  // can't be protected at 4 KB granularity, so they're not used here.
+  return false;
+}
+
 FileMappingHandle CreateFileMappingHandle(std::wstring path, size_t length,
                                           PageAccess access, bool commit) {
   DWORD protect =
@@ -0,0 +1,363 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/range_bit_map.h"
+
+#include <algorithm>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/math.h"
+
+namespace xe {
+
+namespace {
+
+// Unlike xe::round_up, keeps 0 as 0.
+uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t ReverseBits(uint64_t value) {
+  value = ((value >> 1) & 0x5555555555555555ull) |
+          ((value & 0x5555555555555555ull) << 1);
+  value = ((value >> 2) & 0x3333333333333333ull) |
+          ((value & 0x3333333333333333ull) << 2);
+  value = ((value >> 4) & 0x0F0F0F0F0F0F0F0Full) |
+          ((value & 0x0F0F0F0F0F0F0F0Full) << 4);
+  value = ((value >> 8) & 0x00FF00FF00FF00FFull) |
+          ((value & 0x00FF00FF00FF00FFull) << 8);
+  value = ((value >> 16) & 0x0000FFFF0000FFFFull) |
+          ((value & 0x0000FFFF0000FFFFull) << 16);
+  return (value >> 32) | (value << 32);
+}
+
+// Length of the run of set bits beginning at bit start.
+uint32_t RunLength(uint64_t bits, uint32_t start) {
+  uint64_t unset = ~(bits >> start);
+  return unset ? std::min(uint32_t(xe::tzcnt(unset)), 64 - start) : 64;
+}
+
+uint32_t LongestRun(uint64_t bits) {
+  uint32_t longest = 0;
+  uint32_t bit = 0;
+  while (bit < 64 && (bits >> bit)) {
+    uint32_t start = bit + xe::tzcnt(bits >> bit);
+    uint32_t length = RunLength(bits, start);
+    longest = std::max(longest, length);
+    bit = start + length;
+  }
+  return longest;
+}
+
+// Scans the runs of set bits from bit 0 upwards, continuing a run of *carry
+// set bits right before bit 0. Returns true and the bit the first run of at
+// least count bits begins at (negative if it begins in the carried run).
+// Otherwise sets *carry to the length of the run reaching bit 63.
+bool FindRunInWord(uint64_t bits, uint32_t count, uint32_t* carry,
+                   int64_t* out_start) {
+  uint32_t run = *carry;
+  uint32_t bit = 0;
+  while (bit < 64) {
+    if (!(bits >> bit)) {
+      run = 0;
+      break;
+    }
+    uint32_t start = bit + xe::tzcnt(bits >> bit);
+    if (start != bit) {
+      run = 0;
+    }
+    uint32_t length = RunLength(bits, start);
+    if (run + length >= count) {
+      *out_start = int64_t(start) - run;
+      return true;
+    }
+    run += length;
+    bit = start + length;
+  }
+  *carry = run;
+  return false;
+}
+
+}  // namespace
+
+RangeBitMap::RangeBitMap() = default;
+
+RangeBitMap::RangeBitMap(uint32_t entry_count) { Resize(entry_count); }
+
+void RangeBitMap::Resize(uint32_t entry_count) {
+  entry_count_ = entry_count;
+  used_.resize((size_t(entry_count) + 63) >> 6);
+  leaf_count_ = 1;
+  while (leaf_count_ < used_.size()) {
+    leaf_count_ <<= 1;
+  }
+  nodes_.resize(leaf_count_ * 2);
+  Reset();
+}
+
+void RangeBitMap::Reset() {
+  std::fill(used_.begin(), used_.end(), 0);
+  // Entries past the end must never be found.
+  if (entry_count_ & 63) {
+    used_.back() |= ~uint64_t(0) << (entry_count_ & 63);
+  }
+  for (uint32_t i = 0; i < leaf_count_; ++i) {
+    if (i < used_.size()) {
+      UpdateLeaf(i);
+    } else {
+      nodes_[leaf_count_ + i] = {0, 0, 0};
+    }
+  }
+  for (uint32_t level_first = leaf_count_ >> 1, child_length = 64;
+       level_first; level_first >>= 1, child_length <<= 1) {
+    for (uint32_t i = level_first; i < level_first * 2; ++i) {
+      UpdateParent(i, child_length);
+    }
+  }
+}
+
+void RangeBitMap::Mark(uint32_t first_index, uint32_t count, bool used) {
+  if (!count) {
+    return;
+  }
+  assert_true(first_index + count <= entry_count_);
+  uint32_t last_index = first_index + count - 1;
+  uint32_t first_word = first_index >> 6;
+  uint32_t last_word = last_index >> 6;
+  for (uint32_t i = first_word; i <= last_word; ++i) {
+    uint64_t mask = ~uint64_t(0);
+    if (i == first_word) {
+      mask &= ~uint64_t(0) << (first_index & 63);
+    }
+    if (i == last_word) {
+      mask &= ~uint64_t(0) >> (63 - (last_index & 63));
+    }
+    if (used) {
+      used_[i] |= mask;
+    } else {
+      used_[i] &= ~mask;
+    }
+    UpdateLeaf(i);
+  }
+  uint32_t first_node = (leaf_count_ + first_word) >> 1;
+  uint32_t last_node = (leaf_count_ + last_word) >> 1;
+  for (uint32_t child_length = 64; first_node;
+       first_node >>= 1, last_node >>= 1, child_length <<= 1) {
+    for (uint32_t i = first_node; i <= last_node; ++i) {
+      UpdateParent(i, child_length);
+    }
+  }
+}
+
+void RangeBitMap::UpdateLeaf(uint32_t word_index) {
+  uint64_t used = used_[word_index];
+  Node& node = nodes_[leaf_count_ + word_index];
+  node.prefix = xe::tzcnt(used);
+  node.suffix = xe::lzcnt(used);
+  node.longest = LongestRun(~used);
+}
+
+void RangeBitMap::UpdateParent(uint32_t node_index, uint32_t child_length) {
+  const Node& low = nodes_[node_index * 2];
+  const Node& high = nodes_[node_index * 2 + 1];
+  Node& node = nodes_[node_index];
+  node.prefix =
+      low.prefix == child_length ? child_length + high.prefix : low.prefix;
+  node.suffix =
+      high.suffix == child_length ? child_length + low.suffix : high.suffix;
+  node.longest =
+      std::max(std::max(low.longest, high.longest), low.suffix + high.prefix);
+}
+
+uint32_t RangeBitMap::FindFirstRun(uint32_t node_index, uint32_t node_first,
+                                   uint32_t node_length, uint32_t index,
+                                   uint32_t count, uint32_t* carry) const {
+  uint32_t node_last = node_first + (node_length - 1);
+  if (node_last < index) {
+    return kInvalidIndex;
+  }
+  const Node& node = nodes_[node_index];
+  if (node_first >= index) {
+    if (*carry + node.prefix >= count) {
+      return node_first - *carry;
+    }
+    if (node.longest < count) {
+      // Nothing fits in here, skip the whole subtree.
+      *carry = node.prefix == node_length ? *carry + node_length : node.suffix;
+      return kInvalidIndex;
+    }
+  }
+  if (node_index >= leaf_count_) {
+    uint64_t free = ~used_[node_index - leaf_count_];
+    if (index > node_first) {
+      free &= ~uint64_t(0) << (index - node_first);
+    }
+    int64_t start;
+    if (FindRunInWord(free, count, carry, &start)) {
+      return uint32_t(int64_t(node_first) + start);
+    }
+    return kInvalidIndex;
+  }
+  uint32_t child_length = node_length >> 1;
+  uint32_t result = FindFirstRun(node_index * 2, node_first, child_length,
+                                 index, count, carry);
+  if (result != kInvalidIndex) {
+    return result;
+  }
+  return FindFirstRun(node_index * 2 + 1, node_first + child_length,
+                      child_length, index, count, carry);
+}
+
+uint32_t RangeBitMap::FindLastRun(uint32_t node_index, uint32_t node_first,
+                                  uint32_t node_length, uint32_t index,
+                                  uint32_t count, uint32_t* carry) const {
+  if (node_first > index) {
+    return kInvalidIndex;
+  }
+  uint32_t node_last = node_first + (node_length - 1);
+  const Node& node = nodes_[node_index];
+  if (node_last <= index) {
+    if (*carry + node.suffix >= count) {
+      return node_last + *carry;
+    }
+    if (node.longest < count) {
+      // Nothing fits in here, skip the whole subtree.
+      *carry = node.suffix == node_length ? *carry + node_length : node.prefix;
+      return kInvalidIndex;
+    }
+  }
+  if (node_index >= leaf_count_) {
+    uint64_t free = ~used_[node_index - leaf_count_];
+    if (index < node_last) {
+      free &= ~uint64_t(0) >> (node_last - index);
+    }
+    // Scan from the top bit down.
+    int64_t end;
+    if (FindRunInWord(ReverseBits(free), count, carry, &end)) {
+      return uint32_t(int64_t(node_last) - end);
+    }
+    return kInvalidIndex;
+  }
+  uint32_t child_length = node_length >> 1;
+  uint32_t result = FindLastRun(node_index * 2 + 1, node_first + child_length,
+                                child_length, index, count, carry);
+  if (result != kInvalidIndex) {
+    return result;
+  }
+  return FindLastRun(node_index * 2, node_first, child_length, index, count,
+                     carry);
+}
+
+uint32_t RangeBitMap::FindFirst(bool used, uint32_t low_index,
+                                uint32_t high_index) const {
+  if (low_index > high_index || low_index >= entry_count_) {
+    return kInvalidIndex;
+  }
+  high_index = std::min(high_index, entry_count_ - 1);
+  uint32_t word_index = low_index >> 6;
+  uint64_t bits = used ? used_[word_index] : ~used_[word_index];
+  bits &= ~uint64_t(0) << (low_index & 63);
+  while (!bits) {
+    if (++word_index > (high_index >> 6)) {
+      return kInvalidIndex;
+    }
+    bits = used ? used_[word_index] : ~used_[word_index];
+  }
+  uint32_t index = (word_index << 6) + xe::tzcnt(bits);
+  return index <= high_index ? index : kInvalidIndex;
+}
+
+uint32_t RangeBitMap::FindLast(bool used, uint32_t low_index,
+                               uint32_t high_index) const {
+  if (low_index > high_index || low_index >= entry_count_) {
+    return kInvalidIndex;
+  }
+  high_index = std::min(high_index, entry_count_ - 1);
+  uint32_t word_index = high_index >> 6;
+  uint64_t bits = used ? used_[word_index] : ~used_[word_index];
+  bits &= ~uint64_t(0) >> (63 - (high_index & 63));
+  while (!bits) {
+    if (word_index-- <= (low_index >> 6)) {
+      return kInvalidIndex;
+    }
+    bits = used ? used_[word_index] : ~used_[word_index];
+  }
+  uint32_t index = (word_index << 6) + (63 - xe::lzcnt(bits));
+  return index >= low_index ? index : kInvalidIndex;
+}
+
+uint32_t RangeBitMap::FindFreeRange(uint32_t low_index, uint32_t high_index,
+                                    uint32_t count, uint32_t alignment,
+                                    bool top_down) const {
+  if (!count || !entry_count_) {
+    return kInvalidIndex;
+  }
+  high_index = std::min(high_index, entry_count_ - 1);
+  alignment = std::max(alignment, 1u);
+  low_index = AlignUp(low_index, alignment);
+  if (low_index > high_index || high_index - low_index + 1 < count) {
+    return kInvalidIndex;
+  }
+  // Highest base that still fits.
+  uint32_t max_base = high_index - (count - 1);
+  max_base -= max_base % alignment;
+  if (max_base < low_index) {
+    return kInvalidIndex;
+  }
+
+  // The tree gives the first/last unaligned run that is long enough. If the
+  // aligned range within it isn't free, the run is too short with alignment
+  // and the search continues past the used entry that got in the way.
+  uint32_t tree_length = leaf_count_ << 6;
+  if (top_down) {
+    uint32_t end_index = max_base + (count - 1);
+    while (true) {
+      uint32_t carry = 0;
+      uint32_t run_end =
+          FindLastRun(1, 0, tree_length, end_index, count, &carry);
+      if (run_end == kInvalidIndex) {
+        return kInvalidIndex;
+      }
+      uint32_t base = run_end - (count - 1);
+      base -= base % alignment;
+      if (base < low_index) {
+        return kInvalidIndex;
+      }
+      uint32_t used_index = FindLast(true, base, base + (count - 1));
+      if (used_index == kInvalidIndex) {
+        return base;
+      }
+      if (!used_index) {
+        return kInvalidIndex;
+      }
+      end_index = used_index - 1;
+    }
+  } else {
+    uint32_t start_index = low_index;
+    while (true) {
+      uint32_t carry = 0;
+      uint32_t run_start =
+          FindFirstRun(1, 0, tree_length, start_index, count, &carry);
+      if (run_start == kInvalidIndex) {
+        return kInvalidIndex;
+      }
+      uint32_t base = AlignUp(run_start, alignment);
+      if (base > max_base) {
+        return kInvalidIndex;
+      }
+      uint32_t used_index = FindFirst(true, base, base + (count - 1));
+      if (used_index == kInvalidIndex) {
+        return base;
+      }
+      start_index = used_index + 1;
+    }
+  }
+}
+
+}  // namespace xe
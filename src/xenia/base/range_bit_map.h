@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_BASE_RANGE_BIT_MAP_H_
+#define XENIA_BASE_RANGE_BIT_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xe {
+
+// Range Bit Map: Tracks used/free entries and finds aligned ranges of free
+// entries without walking them one by one.
+// A segment tree over the 64-entry words of the bit map keeps the longest
+// free run in every subtree (and the free runs touching its ends), so searches
+// descend straight to the first (or last) run long enough for the request in
+// logarithmic time, skipping fragmented areas where nothing would fit.
+// Not threadsafe.
+class RangeBitMap {
+ public:
+  static const uint32_t kInvalidIndex = UINT32_MAX;
+
+  RangeBitMap();
+  explicit RangeBitMap(uint32_t entry_count);
+
+  uint32_t entry_count() const { return entry_count_; }
+
+  // Resizes the bit map and sets all entries to free.
+  void Resize(uint32_t entry_count);
+
+  // Sets all entries to free.
+  void Reset();
+
+  bool IsUsed(uint32_t index) const {
+    return (used_[index >> 6] >> (index & 63)) & 1;
+  }
+
+  void MarkUsed(uint32_t first_index, uint32_t count) {
+    Mark(first_index, count, true);
+  }
+  void MarkFree(uint32_t first_index, uint32_t count) {
+    Mark(first_index, count, false);
+  }
+
+  // Finds count contiguous free entries beginning at a multiple of alignment
+  // and lying entirely within [low_index, high_index]. Returns the lowest such
+  // range, or the highest one if top_down is set, or kInvalidIndex if there is
+  // none.
+  uint32_t FindFreeRange(uint32_t low_index, uint32_t high_index,
+                         uint32_t count, uint32_t alignment,
+                         bool top_down) const;
+
+  // First/last entry with the given state in [low_index, high_index], or
+  // kInvalidIndex. Linear in the distance to the entry.
+  uint32_t FindFirst(bool used, uint32_t low_index, uint32_t high_index) const;
+  uint32_t FindLast(bool used, uint32_t low_index, uint32_t high_index) const;
+
+ private:
+  // Free runs within the entries covered by a tree node.
+  struct Node {
+    // Free entries at the beginning.
+    uint32_t prefix;
+    // Free entries at the end.
+    uint32_t suffix;
+    // Longest free run anywhere.
+    uint32_t longest;
+  };
+
+  void Mark(uint32_t first_index, uint32_t count, bool used);
+  void UpdateLeaf(uint32_t word_index);
+  void UpdateParent(uint32_t node_index, uint32_t child_length);
+  // Start of the first run of count free entries at or after index, or
+  // kInvalidIndex. carry is the length of the free run ending right before
+  // the node.
+  uint32_t FindFirstRun(uint32_t node_index, uint32_t node_first,
+                        uint32_t node_length, uint32_t index, uint32_t count,
+                        uint32_t* carry) const;
+  // End of the last run of count free entries at or before index, or
+  // kInvalidIndex. carry is the length of the free run beginning right after
+  // the node.
+  uint32_t FindLastRun(uint32_t node_index, uint32_t node_first,
+                       uint32_t node_length, uint32_t index, uint32_t count,
+                       uint32_t* carry) const;
+
+  uint32_t entry_count_ = 0;
+  // Bit per entry, set if used. Bits past entry_count_ are always set.
+  std::vector<uint64_t> used_;
+  // Implicit binary tree, root at 1, leaf for word i at leaf_count_ + i.
+  // Leaves past the end of used_ are entirely used.
+  std::vector<Node> nodes_;
+  uint32_t leaf_count_ = 0;
+};
+
+}  // namespace xe
+
+#endif  // XENIA_BASE_RANGE_BIT_MAP_H_
@@ -9,6 +9,13 @@
 
 #include "xenia/base/memory.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
 #include "third_party/catch/include/catch.hpp"
 
 namespace xe {
@@ -414,6 +421,58 @@ TEST_CASE("copy_and_swap_16_in_32_unaligned", "Copy and Swap") {
   REQUIRE(true == true);
 }
 
+// Hidden by default, run with "[.benchmark]" or "[huge_pages_benchmark]".
+// Follows a random cycle through every 4 KB page of a block the size of the
+// guest physical memory, so nearly every load misses the data TLB, with and
+// without AdviseHugePages.
+TEST_CASE("HUGE_PAGES_BENCHMARK", "[.benchmark][huge_pages_benchmark]") {
+  const size_t kLength = 512 * 1024 * 1024;
+  const size_t kPageSize = 4096;
+  const size_t kPageCount = kLength / kPageSize;
+  const size_t kLoadCount = 16 * 1024 * 1024;
+
+  std::vector<uint32_t> order(kPageCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin() + 1, order.end(), std::mt19937(0x360));
+
+  for (bool huge_pages : {false, true}) {
+    auto base = reinterpret_cast<uint8_t*>(memory::AllocFixed(
+        nullptr, kLength, memory::AllocationType::kReserveCommit,
+        memory::PageAccess::kReadWrite));
+    REQUIRE(base);
+    bool advised = huge_pages && memory::AdviseHugePages(base, kLength);
+    if (huge_pages && !advised) {
+      std::printf("huge pages: not available on this host\n");
+      memory::DeallocFixed(base, kLength, memory::DeallocationType::kRelease);
+      continue;
+    }
+    // Each page links to the next one in the cycle, at a varying offset so the
+    // loads don't all hit the same cache sets.
+    for (size_t i = 0; i < kPageCount; ++i) {
+      size_t page = order[i];
+      size_t next_page = order[(i + 1) % kPageCount];
+      *reinterpret_cast<uint32_t*>(base + page * kPageSize +
+                                   (page & 63) * 64) =
+          uint32_t(next_page * kPageSize + (next_page & 63) * 64);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t first_offset = uint32_t((order[0] & 63) * 64);
+    uint32_t offset = first_offset;
+    for (size_t i = 0; i < kLoadCount; ++i) {
+      offset = *reinterpret_cast<const uint32_t*>(base + offset);
+    }
+    auto time = std::chrono::steady_clock::now() - start;
+    // Whole laps around the cycle.
+    REQUIRE(offset == first_offset);
+    std::printf("%s: %.2f ns/load\n",
+                huge_pages ? "huge pages" : "normal pages",
+                std::chrono::duration<double, std::nano>(time).count() /
+                    kLoadCount);
+    memory::DeallocFixed(base, kLength, memory::DeallocationType::kRelease);
+  }
+}
+
 }  // namespace test
 }  // namespace base
 }  // namespace xe
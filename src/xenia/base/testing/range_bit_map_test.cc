@@ -0,0 +1,183 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "xenia/base/range_bit_map.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace base {
+namespace test {
+
+namespace {
+
+// Page by page search like BaseHeap::AllocRange used to do.
+uint32_t FindFreeRangeLinear(const std::vector<bool>& used, uint32_t low_index,
+                             uint32_t high_index, uint32_t count,
+                             uint32_t alignment, bool top_down) {
+  low_index = (low_index + alignment - 1) / alignment * alignment;
+  high_index = std::min(high_index, uint32_t(used.size()) - 1);
+  if (low_index > high_index || high_index - low_index + 1 < count) {
+    return RangeBitMap::kInvalidIndex;
+  }
+  uint32_t max_base = high_index - (count - 1);
+  max_base -= max_base % alignment;
+  auto is_free = [&](uint32_t base) {
+    for (uint32_t i = base; i < base + count; ++i) {
+      if (used[i]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (top_down) {
+    for (int64_t base = max_base; base >= low_index; base -= alignment) {
+      if (is_free(uint32_t(base))) {
+        return uint32_t(base);
+      }
+    }
+  } else {
+    for (uint32_t base = low_index; base <= max_base; base += alignment) {
+      if (is_free(base)) {
+        return base;
+      }
+    }
+  }
+  return RangeBitMap::kInvalidIndex;
+}
+
+}  // namespace
+
+TEST_CASE("RANGE_BIT_MAP_BASIC", "[range_bit_map]") {
+  RangeBitMap bit_map(200);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 200, 1, false) == 0);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 201, 1, false) ==
+          RangeBitMap::kInvalidIndex);
+  bit_map.MarkUsed(60, 10);
+  REQUIRE(bit_map.IsUsed(60));
+  REQUIRE(bit_map.IsUsed(69));
+  REQUIRE(!bit_map.IsUsed(70));
+  REQUIRE(bit_map.FindFreeRange(0, 199, 61, 1, false) == 70);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 60, 1, false) == 0);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 61, 16, false) == 80);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 60, 1, true) == 140);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 131, 1, true) ==
+          RangeBitMap::kInvalidIndex);
+  REQUIRE(bit_map.FindFreeRange(0, 139, 60, 1, true) == 80);
+  REQUIRE(bit_map.FindFreeRange(0, 128, 60, 1, true) == 0);
+  bit_map.MarkFree(60, 10);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 200, 1, true) == 0);
+  bit_map.MarkUsed(0, 200);
+  REQUIRE(bit_map.FindFreeRange(0, 199, 1, 1, true) ==
+          RangeBitMap::kInvalidIndex);
+  bit_map.Reset();
+  REQUIRE(bit_map.FindFreeRange(0, 199, 1, 1, true) == 199);
+}
+
+TEST_CASE("RANGE_BIT_MAP_MATCHES_LINEAR", "[range_bit_map]") {
+  const uint32_t kEntryCount = 20000;
+  std::mt19937 random(0x360);
+  RangeBitMap bit_map(kEntryCount);
+  std::vector<bool> used(kEntryCount, false);
+  for (uint32_t i = 0; i < 4000; ++i) {
+    uint32_t first = random() % kEntryCount;
+    uint32_t count =
+        std::min(uint32_t(random() % 300) + 1, kEntryCount - first);
+    bool mark_used = (random() % 3) != 0;
+    if (mark_used) {
+      bit_map.MarkUsed(first, count);
+    } else {
+      bit_map.MarkFree(first, count);
+    }
+    for (uint32_t j = first; j < first + count; ++j) {
+      used[j] = mark_used;
+    }
+
+    uint32_t low = random() % kEntryCount;
+    uint32_t high = low + random() % (kEntryCount - low);
+    uint32_t find_count = random() % 64 + 1;
+    uint32_t alignment = 1u << (random() % 5);
+    bool top_down = (random() & 1) != 0;
+    REQUIRE(bit_map.FindFreeRange(low, high, find_count, alignment,
+                                  top_down) ==
+            FindFreeRangeLinear(used, low, high, find_count, alignment,
+                                top_down));
+  }
+}
+
+// Hidden by default, run with "[.benchmark]" or "[range_bit_map_benchmark]".
+TEST_CASE("RANGE_BIT_MAP_FRAGMENTED_ALLOC",
+          "[.benchmark][range_bit_map_benchmark]") {
+  // 512 MB of 4 KB pages, like the 0x40000000 virtual heap.
+  const uint32_t kPageCount = 0x20000000 / 4096;
+  const uint32_t kAllocCount = 2000;
+  std::mt19937 random(0x360);
+
+  // Fill everything with small allocations separated by holes too small for
+  // any of the requests, leaving space for them only in the middle.
+  RangeBitMap bit_map(kPageCount);
+  std::vector<bool> used(kPageCount, false);
+  for (uint32_t i = 0; i < kPageCount;) {
+    uint32_t count = std::min(uint32_t(random() % 4) + 1, kPageCount - i);
+    bit_map.MarkUsed(i, count);
+    for (uint32_t j = i; j < i + count; ++j) {
+      used[j] = true;
+    }
+    i += count + random() % 8;
+  }
+  bit_map.MarkFree(kPageCount / 2, 8192);
+  for (uint32_t j = kPageCount / 2; j < kPageCount / 2 + 8192; ++j) {
+    used[j] = false;
+  }
+
+  for (bool top_down : {false, true}) {
+    std::vector<uint32_t> counts(kAllocCount);
+    for (auto& count : counts) {
+      count = random() % 16 + 8;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t checksum_linear = 0;
+    for (uint32_t count : counts) {
+      checksum_linear += FindFreeRangeLinear(used, 0, kPageCount - 1, count,
+                                             16, top_down);
+    }
+    auto linear_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    uint64_t checksum_bit_map = 0;
+    for (uint32_t count : counts) {
+      checksum_bit_map +=
+          bit_map.FindFreeRange(0, kPageCount - 1, count, 16, top_down);
+    }
+    auto bit_map_time = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(checksum_linear == checksum_bit_map);
+    double linear_us =
+        std::chrono::duration<double, std::micro>(linear_time).count() /
+        kAllocCount;
+    double bit_map_us =
+        std::chrono::duration<double, std::micro>(bit_map_time).count() /
+        kAllocCount;
+    std::printf(
+        "%s: linear scan %.2f us/alloc, range bit map %.2f us/alloc "
+        "(%.1fx)\n",
+        top_down ? "top-down" : "bottom-up", linear_us, bit_map_us,
+        linear_us / bit_map_us);
+  }
+}
+
+}  // namespace test
+}  // namespace base
+}  // namespace xe
@@ -11,12 +11,16 @@
 #define XENIA_CPU_BACKEND_BACKEND_H_
 
 #include <memory>
+#include <string>
 
 #include "xenia/cpu/backend/machine_info.h"
 #include "xenia/cpu/thread_debug_info.h"
 
 namespace xe {
 namespace cpu {
+namespace compiler {
+class CompilerStats;
+}  // namespace compiler
 class Breakpoint;
 class Function;
 class GuestFunction;
@@ -54,12 +58,26 @@ class Backend {
   virtual std::unique_ptr<GuestFunction> CreateGuestFunction(
       Module* module, uint32_t address) = 0;
 
+  // Opens the persistent storage of generated code for the module with the
+  // given hash, if supported and enabled.
+  virtual bool InitializeCodeStorage(const std::wstring& storage_root,
+                                     uint32_t title_id, uint64_t module_hash) {
+    return false;
+  }
+  virtual void ShutdownCodeStorage() {}
+  // Sets up the function with code from the storage instead of translating it.
+  // The function must already be scanned so that its extents are known.
+  virtual bool RestoreFunction(GuestFunction* function) { return false; }
+
   // Calculates the next host instruction based on the current thread state and
   // current PC. This will look for branches and other control flow
   // instructions.
   virtual uint64_t CalculateNextHostInstruction(ThreadDebugInfo* thread_info,
                                                 uint64_t current_pc) = 0;
 
+  // Adds statistics gathered by generated code to the JIT statistics.
+  virtual void ReportStats(compiler::CompilerStats* stats) {}
+
   virtual void InstallBreakpoint(Breakpoint* breakpoint) {}
   virtual void InstallBreakpoint(Breakpoint* breakpoint, Function* fn) {}
   virtual void UninstallBreakpoint(Breakpoint* breakpoint) {}
@@ -18,6 +18,20 @@ namespace xe {
 namespace cpu {
 namespace backend {
 
+// Frame of a piece of generated code, for hosts where the code cache doesn't
+// register platform unwind tables. Generated code allocates its whole frame
+// with one stack adjustment in the prolog and frees it at the start of the
+// epilog, so this is enough to step over it.
+struct CodeFrameLayout {
+  uint64_t code_address;
+  uint32_t code_size;
+  // Offset of the first instruction after the stack allocation.
+  uint32_t prolog_stack_alloc_offset;
+  // Offset of the instruction freeing the frame.
+  uint32_t epilog_offset;
+  uint32_t stack_size;
+};
+
 class CodeCache {
  public:
   CodeCache() = default;
@@ -32,6 +46,7 @@ class CodeCache {
   virtual GuestFunction* LookupFunction(uint64_t host_pc) = 0;
 
   // Finds platform-specific function unwind info for the given host PC.
+  // This is a RUNTIME_FUNCTION on Windows and a CodeFrameLayout elsewhere.
   virtual void* LookupUnwindInfo(uint64_t host_pc) = 0;
 };
 
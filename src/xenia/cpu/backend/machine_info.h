@@ -29,6 +29,9 @@ struct MachineInfo {
     char name[4];
     uint32_t types;
     uint32_t count;
+    // Registers not preserved across calls to host functions. Values that are
+    // live across such calls are kept in other registers when possible.
+    uint32_t volatile_mask;
   } register_sets[8];
 };
 
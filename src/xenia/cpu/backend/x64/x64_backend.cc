@@ -10,12 +10,16 @@
 #include "xenia/cpu/backend/x64/x64_backend.h"
 
 #include <stddef.h>
+#include <cstring>
 
 #include "third_party/capstone/include/capstone/capstone.h"
 #include "third_party/capstone/include/capstone/x86.h"
+#include "third_party/xxhash/xxhash.h"
 
+#include "build/version.h"
 #include "xenia/base/exception_handler.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/mutex.h"
 #include "xenia/cpu/backend/x64/x64_assembler.h"
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 #include "xenia/cpu/backend/x64/x64_emitter.h"
@@ -23,6 +27,8 @@
 #include "xenia/cpu/backend/x64/x64_sequences.h"
 #include "xenia/cpu/backend/x64/x64_stack_layout.h"
 #include "xenia/cpu/breakpoint.h"
+#include "xenia/cpu/compiler/compiler_stats.h"
+#include "xenia/cpu/cpu_flags.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/cpu/stack_walker.h"
 
@@ -30,6 +36,17 @@ DEFINE_bool(
     use_haswell_instructions, true,
     "Uses the AVX2/FMA/etc instructions on Haswell processors when available.",
     "CPU");
+DEFINE_bool(use_avx512_instructions, true,
+            "Uses AVX-512 instructions on xmm registers when available (only "
+            "if use_haswell_instructions is enabled).",
+            "CPU");
+DEFINE_bool(store_generated_code, false,
+            "Store generated x64 code on disk so it can be reused instead of "
+            "recompiling functions when the same title is launched again.",
+            "CPU");
+
+DECLARE_bool(emit_source_annotations);
+DECLARE_bool(store_all_context_values);
 
 namespace xe {
 namespace cpu {
@@ -64,6 +81,8 @@ X64Backend::X64Backend() : Backend(), code_cache_(nullptr) {
 }
 
 X64Backend::~X64Backend() {
+  ShutdownCodeStorage();
+
   if (capstone_handle_) {
     cs_close(&capstone_handle_);
   }
@@ -96,6 +115,8 @@ bool X64Backend::Initialize(Processor* processor) {
   std::strcpy(gprs.name, "gpr");
   gprs.types = MachineInfo::RegisterSet::INT_TYPES;
   gprs.count = X64Emitter::GPR_COUNT;
+  // The host call thunk saves r10 and r11, the rest are nonvolatile.
+  gprs.volatile_mask = 0;
 
   auto& xmms = machine_info_.register_sets[1];
   xmms.id = 1;
@@ -103,6 +124,15 @@ bool X64Backend::Initialize(Processor* processor) {
   xmms.types = MachineInfo::RegisterSet::FLOAT_TYPES |
                MachineInfo::RegisterSet::VEC_TYPES;
   xmms.count = X64Emitter::XMM_COUNT;
+#if XE_PLATFORM_WIN32
+  // The host call thunk saves xmm4 and xmm5, the rest are nonvolatile.
+  xmms.volatile_mask = 0;
+#else
+  // SysV has no nonvolatile XMM registers and the host call thunk only saves
+  // xmm4 and xmm5, so xmm6-xmm15 are lost. Mask bits index xmm_reg_map_,
+  // which starts at xmm4.
+  xmms.volatile_mask = 0xFFC;
+#endif  // XE_PLATFORM_WIN32
 
   code_cache_ = X64CodeCache::Create();
   Backend::code_cache_ = code_cache_.get();
@@ -116,6 +146,7 @@ bool X64Backend::Initialize(Processor* processor) {
   host_to_guest_thunk_ = thunk_emitter.EmitHostToGuestThunk();
   guest_to_host_thunk_ = thunk_emitter.EmitGuestToHostThunk();
   resolve_function_thunk_ = thunk_emitter.EmitResolveFunctionThunk();
+  emitter_feature_flags_ = thunk_emitter.feature_flags();
 
   // Set the code cache to use the ResolveFunction thunk for default
   // indirections.
@@ -254,6 +285,166 @@ bool TestCapstoneEflags(uint32_t eflags, uint32_t insn) {
   }
 }
 
+bool X64Backend::InitializeCodeStorage(const std::wstring& storage_root,
+                                       uint32_t title_id,
+                                       uint64_t module_hash) {
+  ShutdownCodeStorage();
+  if (!cvars::store_generated_code || !code_cache_->has_indirection_table()) {
+    return false;
+  }
+  return code_cache_->InitializeStorage(
+      storage_root, title_id, module_hash,
+      CalculateCodeStorageConfigurationHash());
+}
+
+void X64Backend::ShutdownCodeStorage() {
+  if (!code_cache_ || !code_cache_->has_storage()) {
+    return;
+  }
+  XELOGI("Generated code storage: %u hits, %u misses, %u outdated",
+         code_storage_hits_.load(), code_storage_misses_.load(),
+         code_storage_stale_.load());
+  code_cache_->ShutdownStorage();
+  code_storage_hits_ = 0;
+  code_storage_misses_ = 0;
+  code_storage_stale_ = 0;
+}
+
+uint64_t X64Backend::CalculateCodeStorageConfigurationHash() const {
+  struct {
+    uint32_t feature_flags;
+    uint32_t supports_extended_load_store;
+    uint64_t host_to_guest_thunk;
+    uint64_t guest_to_host_thunk;
+    uint64_t resolve_function_thunk;
+    uint64_t emitter_data;
+    uint64_t break_on_instruction;
+    uint32_t disable_global_lock;
+    uint32_t store_all_context_values;
+    uint32_t emit_source_annotations;
+    uint32_t reserved;
+  } configuration = {};
+  configuration.feature_flags = emitter_feature_flags_;
+  configuration.supports_extended_load_store =
+      machine_info_.supports_extended_load_store ? 1 : 0;
+  // Thunks and constants are referenced by absolute addresses, which are the
+  // same in every execution unless something else has taken their place.
+  configuration.host_to_guest_thunk = uint64_t(host_to_guest_thunk_);
+  configuration.guest_to_host_thunk = uint64_t(guest_to_host_thunk_);
+  configuration.resolve_function_thunk = uint64_t(resolve_function_thunk_);
+  configuration.emitter_data = uint64_t(emitter_data_);
+  configuration.break_on_instruction = cvars::break_on_instruction;
+  configuration.disable_global_lock = cvars::disable_global_lock ? 1 : 0;
+  configuration.store_all_context_values =
+      cvars::store_all_context_values ? 1 : 0;
+  configuration.emit_source_annotations =
+      cvars::emit_source_annotations ? 1 : 0;
+
+  // The emitter and the passes may change in any commit.
+  XXH64_state_t hash_state;
+  XXH64_reset(&hash_state, 0);
+  XXH64_update(&hash_state, XE_BUILD_COMMIT, std::strlen(XE_BUILD_COMMIT));
+  XXH64_update(&hash_state, &configuration, sizeof(configuration));
+  return XXH64_digest(&hash_state);
+}
+
+uint64_t X64Backend::HashGuestCode(uint32_t address,
+                                   uint32_t end_address) const {
+  return XXH64(processor()->memory()->TranslateVirtual(address),
+               end_address + 4 - address, 0);
+}
+
+bool X64Backend::RestoreFunction(GuestFunction* function) {
+  if (!code_cache_->has_storage()) {
+    return false;
+  }
+  auto stored = code_cache_->LookupStoredFunction(function->address());
+  if (!stored) {
+    ++code_storage_misses_;
+    return false;
+  }
+  // The guest code may have been patched or scanned differently.
+  if (stored->guest_end_address != function->end_address() ||
+      stored->guest_code_hash !=
+          HashGuestCode(function->address(), function->end_address())) {
+    ++code_storage_stale_;
+    return false;
+  }
+
+  std::vector<uint8_t> machine_code(stored->machine_code);
+  for (auto& relocation : stored->relocations) {
+    uint64_t value;
+    switch (relocation.type) {
+      case CodeRelocation::Type::kHostImage:
+        value = X64Emitter::HostImageAnchor() + relocation.value;
+        break;
+      case CodeRelocation::Type::kBuiltinArg0:
+      case CodeRelocation::Type::kBuiltinArg1: {
+        auto builtin = processor()->LookupFunction(
+            processor()->builtin_module(), uint32_t(relocation.value));
+        if (!builtin || builtin->behavior() != Function::Behavior::kBuiltin) {
+          ++code_storage_stale_;
+          return false;
+        }
+        auto builtin_function = static_cast<BuiltinFunction*>(builtin);
+        value = reinterpret_cast<uint64_t>(
+            relocation.type == CodeRelocation::Type::kBuiltinArg0
+                ? builtin_function->arg0()
+                : builtin_function->arg1());
+      } break;
+      default:
+        ++code_storage_stale_;
+        return false;
+    }
+    std::memcpy(machine_code.data() + relocation.code_offset, &value,
+                sizeof(value));
+  }
+
+  void* code_address = code_cache_->PlaceGuestCode(
+      function->address(), machine_code.data(), stored->func_info, function);
+  {
+    // See X64Assembler::Assemble.
+    auto global_lock = global_critical_region::AcquireDirect();
+    function->source_map() = stored->source_map;
+    static_cast<X64Function*>(function)->Setup(
+        reinterpret_cast<uint8_t*>(code_address), machine_code.size());
+  }
+  code_cache_->AddIndirection(
+      function->address(),
+      static_cast<uint32_t>(reinterpret_cast<uint64_t>(code_address)));
+  ++code_storage_hits_;
+  return true;
+}
+
+void X64Backend::StoreFunction(GuestFunction* function,
+                               const void* machine_code,
+                               const EmitFunctionInfo& func_info,
+                               const std::vector<CodeRelocation>& relocations,
+                               const std::vector<SourceMapEntry>& source_map) {
+  code_cache_->StoreFunction(
+      function->address(), function->end_address(),
+      HashGuestCode(function->address(), function->end_address()),
+      machine_code, func_info, relocations, source_map);
+}
+
+void X64Backend::ReportStats(compiler::CompilerStats* stats) {
+  std::vector<compiler::CompilerStats::IndirectCallSiteStats> site_stats;
+  for (auto site : code_cache_->inline_cache_sites()) {
+    compiler::CompilerStats::IndirectCallSiteStats site_stat;
+    site_stat.address = site->guest_address;
+    site_stat.cached_target_count = 0;
+    for (auto imm32 : site->guest_target_imm32s) {
+      if (imm32 && *reinterpret_cast<const uint32_t*>(imm32)) {
+        ++site_stat.cached_target_count;
+      }
+    }
+    site_stat.call_count = site->call_count;
+    site_stat.miss_count = site->miss_count;
+    site_stats.push_back(site_stat);
+  }
+  stats->AddIndirectCallSites(site_stats);
+}
+
 uint64_t X64Backend::CalculateNextHostInstruction(ThreadDebugInfo* thread_info,
                                                   uint64_t current_pc) {
   auto machine_code_ptr = reinterpret_cast<const uint8_t*>(current_pc);
@@ -271,6 +462,10 @@ uint64_t X64Backend::CalculateNextHostInstruction(ThreadDebugInfo* thread_info,
       return current_pc + insn.size;
     case X86_INS_CALL: {
       assert_true(detail.op_count == 1);
+      if (detail.operands[0].type == X86_OP_IMM) {
+        // Linked guest call.
+        return static_cast<uint64_t>(detail.operands[0].imm);
+      }
       assert_true(detail.operands[0].type == X86_OP_REG);
       uint64_t target_pc =
           ReadCapstoneReg(&thread_info->host_context, detail.operands[0].reg);
@@ -10,12 +10,17 @@
 #ifndef XENIA_CPU_BACKEND_X64_X64_BACKEND_H_
 #define XENIA_CPU_BACKEND_X64_X64_BACKEND_H_
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "xenia/base/cvar.h"
 #include "xenia/cpu/backend/backend.h"
+#include "xenia/cpu/function.h"
 
 DECLARE_bool(use_haswell_instructions);
+DECLARE_bool(use_avx512_instructions);
 
 namespace xe {
 class Exception;
@@ -26,6 +31,8 @@ namespace backend {
 namespace x64 {
 
 class X64CodeCache;
+struct CodeRelocation;
+struct EmitFunctionInfo;
 
 #define XENIA_HAS_X64_BACKEND 1
 
@@ -61,6 +68,18 @@ class X64Backend : public Backend {
   std::unique_ptr<GuestFunction> CreateGuestFunction(Module* module,
                                                      uint32_t address) override;
 
+  bool InitializeCodeStorage(const std::wstring& storage_root,
+                             uint32_t title_id, uint64_t module_hash) override;
+  void ShutdownCodeStorage() override;
+  bool RestoreFunction(GuestFunction* function) override;
+  // Writes code placed by the emitter to the storage.
+  void StoreFunction(GuestFunction* function, const void* machine_code,
+                     const EmitFunctionInfo& func_info,
+                     const std::vector<CodeRelocation>& relocations,
+                     const std::vector<SourceMapEntry>& source_map);
+
+  void ReportStats(compiler::CompilerStats* stats) override;
+
   uint64_t CalculateNextHostInstruction(ThreadDebugInfo* thread_info,
                                         uint64_t current_pc) override;
 
@@ -72,14 +91,24 @@ class X64Backend : public Backend {
   static bool ExceptionCallbackThunk(Exception* ex, void* data);
   bool ExceptionCallback(Exception* ex);
 
+  // Hash of everything other than the guest code that affects the generated
+  // code, to invalidate the code storage.
+  uint64_t CalculateCodeStorageConfigurationHash() const;
+  uint64_t HashGuestCode(uint32_t address, uint32_t end_address) const;
+
   uintptr_t capstone_handle_ = 0;
 
   std::unique_ptr<X64CodeCache> code_cache_;
   uintptr_t emitter_data_ = 0;
+  uint32_t emitter_feature_flags_ = 0;
 
   HostToGuestThunk host_to_guest_thunk_;
   GuestToHostThunk guest_to_host_thunk_;
   ResolveFunctionThunk resolve_function_thunk_;
+
+  std::atomic<uint32_t> code_storage_hits_ = {0};
+  std::atomic<uint32_t> code_storage_misses_ = {0};
+  std::atomic<uint32_t> code_storage_stale_ = {0};
 };
 
 }  // namespace x64
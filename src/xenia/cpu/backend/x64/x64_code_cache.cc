@@ -9,6 +9,7 @@
 
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 
+#include <cinttypes>
 #include <cstdlib>
 #include <cstring>
 
@@ -17,11 +18,14 @@
 #pragma comment(lib, "../third_party/vtune/lib64/jitprofiling.lib")
 #endif
 
+#include "third_party/xxhash/xxhash.h"
 #include "xenia/base/assert.h"
 #include "xenia/base/clock.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/string.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/module.h"
 
@@ -33,6 +37,8 @@ namespace x64 {
 X64CodeCache::X64CodeCache() = default;
 
 X64CodeCache::~X64CodeCache() {
+  ShutdownStorage();
+
   if (indirection_table_base_) {
     xe::memory::DeallocFixed(indirection_table_base_, 0,
                              xe::memory::DeallocationType::kRelease);
@@ -83,6 +89,10 @@ bool X64CodeCache::Initialize() {
         kGeneratedCodeBase, kGeneratedCodeBase + kGeneratedCodeSize);
     return false;
   }
+  if (cvars::huge_pages &&
+      !xe::memory::AdviseHugePages(generated_code_base_, kGeneratedCodeSize)) {
+    XELOGW("Unable to advise huge pages for the code cache");
+  }
 
   // Preallocate the function map to a large, reasonable size.
   generated_code_map_.reserve(kMaximumFunctionCount);
@@ -102,7 +112,89 @@ void X64CodeCache::AddIndirection(uint32_t guest_address,
 
   uint32_t* indirection_slot = reinterpret_cast<uint32_t*>(
       indirection_table_base_ + (guest_address - kIndirectionTableBase));
+
+  auto global_lock = global_critical_region_.Acquire();
   *indirection_slot = host_address;
+  auto it = call_sites_.find(guest_address);
+  if (it != call_sites_.end()) {
+    for (auto rel32_address : it->second) {
+      PatchCallSite(rel32_address, host_address);
+    }
+  }
+}
+
+void X64CodeCache::AddCallSite(uint32_t guest_address,
+                               uint8_t* rel32_address) {
+  assert_not_null(indirection_table_base_);
+  uint32_t* indirection_slot = reinterpret_cast<uint32_t*>(
+      indirection_table_base_ + (guest_address - kIndirectionTableBase));
+
+  auto global_lock = global_critical_region_.Acquire();
+  call_sites_[guest_address].push_back(rel32_address);
+  // The function may have been compiled since the call was emitted.
+  if (*indirection_slot != indirection_default_value_) {
+    PatchCallSite(rel32_address, *indirection_slot);
+  }
+}
+
+InlineCacheSite* X64CodeCache::AddInlineCacheSite(
+    const InlineCacheSite& site) {
+  auto global_lock = global_critical_region_.Acquire();
+  inline_cache_sites_.push_back(site);
+  return &inline_cache_sites_.back();
+}
+
+void X64CodeCache::AddInlineCacheTarget(InlineCacheSite* site,
+                                        uint32_t guest_address) {
+  uint32_t* indirection_slot = reinterpret_cast<uint32_t*>(
+      indirection_table_base_ + (guest_address - kIndirectionTableBase));
+
+  auto global_lock = global_critical_region_.Acquire();
+  uint32_t host_address = *indirection_slot;
+  if (host_address == indirection_default_value_ || !guest_address) {
+    // Not compiled yet - the fallback is about to compile it.
+    return;
+  }
+  for (size_t i = 0; i < InlineCacheSite::kEntryCount; ++i) {
+    auto imm32 = reinterpret_cast<std::atomic<uint32_t>*>(
+        site->guest_target_imm32s[i]);
+    uint32_t cached_address = imm32->load(std::memory_order_relaxed);
+    if (cached_address == guest_address) {
+      // Another thread got here first.
+      return;
+    }
+    if (!cached_address) {
+      // The call is pointed at the code before the compare can match, and
+      // until then it goes to the fallback, so either order of observing the
+      // two stores is correct.
+      PatchCallSite(site->host_target_rel32s[i], host_address);
+      call_sites_[guest_address].push_back(site->host_target_rel32s[i]);
+      imm32->store(guest_address, std::memory_order_release);
+      return;
+    }
+  }
+}
+
+std::vector<const InlineCacheSite*> X64CodeCache::inline_cache_sites() {
+  auto global_lock = global_critical_region_.Acquire();
+  std::vector<const InlineCacheSite*> sites;
+  for (auto& site : inline_cache_sites_) {
+    sites.push_back(&site);
+  }
+  return sites;
+}
+
+void X64CodeCache::PatchCallSite(uint8_t* rel32_address,
+                                 uint32_t host_address) {
+  // Other threads may be executing the call while it's patched. The rel32 is
+  // aligned, so the store is atomic and instruction fetch sees either the old
+  // or the new target, both of which are valid.
+  assert_zero(uintptr_t(rel32_address) & 3);
+  int64_t rel32 =
+      int64_t(host_address) - int64_t(uintptr_t(rel32_address) + 4);
+  assert_true(rel32 == int32_t(rel32));
+  reinterpret_cast<std::atomic<int32_t>*>(rel32_address)
+      ->store(int32_t(rel32), std::memory_order_release);
 }
 
 void X64CodeCache::CommitExecutableRange(uint32_t guest_low,
@@ -222,15 +314,8 @@ void* X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
   }
 #endif
 
-  // Now that everything is ready, fix up the indirection table.
-  // Note that we do support code that doesn't have an indirection fixup, so
-  // ignore those when we see them.
-  if (guest_address && indirection_table_base_) {
-    uint32_t* indirection_slot = reinterpret_cast<uint32_t*>(
-        indirection_table_base_ + (guest_address - kIndirectionTableBase));
-    *indirection_slot = uint32_t(reinterpret_cast<uint64_t>(code_address));
-  }
-
+  // The code isn't relocated yet, so it's up to the caller to install it in
+  // the indirection table with AddIndirection once it's ready to run.
   return code_address;
 }
 
@@ -297,6 +382,221 @@ GuestFunction* X64CodeCache::LookupFunction(uint64_t host_pc) {
   }
 }
 
+namespace {
+struct StorageFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t module_hash;
+  uint64_t configuration_hash;
+};
+// 'XECC'.
+const uint32_t kStorageMagic = 0x43434558;
+}  // namespace
+
+bool X64CodeCache::InitializeStorage(const std::wstring& storage_root,
+                                     uint32_t title_id, uint64_t module_hash,
+                                     uint64_t configuration_hash) {
+  ShutdownStorage();
+
+  auto code_storage_root = xe::join_paths(storage_root, L"code");
+  if (!xe::filesystem::CreateFolder(code_storage_root)) {
+    return false;
+  }
+
+  uint64_t initialization_start = xe::Clock::QueryHostTickCount();
+  FILE* file = xe::filesystem::OpenFile(
+      xe::join_paths(code_storage_root,
+                     xe::format_string(L"%.8X_%.16" PRIX64 L".xcc", title_id,
+                                       module_hash)),
+      "a+b");
+  if (!file) {
+    XELOGE("Unable to open the generated code storage");
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  storage_file_ = file;
+  stored_function_write_count_ = 0;
+
+  StorageFileHeader file_header;
+  uint64_t valid_bytes = 0;
+  size_t superseded_count = 0;
+  if (fread(&file_header, sizeof(file_header), 1, storage_file_) &&
+      file_header.magic == kStorageMagic &&
+      file_header.version == StoredFunctionHeader::kVersion &&
+      file_header.module_hash == module_hash &&
+      file_header.configuration_hash == configuration_hash) {
+    valid_bytes = sizeof(file_header);
+    LoadStorage(&valid_bytes, &superseded_count);
+  }
+
+  if (!valid_bytes) {
+    // New file, or written by a different configuration.
+    stored_functions_.clear();
+    xe::filesystem::TruncateStdioFile(storage_file_, 0);
+    file_header.magic = kStorageMagic;
+    file_header.version = StoredFunctionHeader::kVersion;
+    file_header.module_hash = module_hash;
+    file_header.configuration_hash = configuration_hash;
+    fwrite(&file_header, sizeof(file_header), 1, storage_file_);
+  } else if (superseded_count > stored_functions_.size()) {
+    // Mostly outdated records - rewrite with only the latest ones.
+    xe::filesystem::TruncateStdioFile(storage_file_, sizeof(file_header));
+    for (auto& it : stored_functions_) {
+      WriteStoredFunction(it.first, *it.second);
+    }
+  } else {
+    // Drop the corrupted tail, if any.
+    xe::filesystem::TruncateStdioFile(storage_file_, valid_bytes);
+  }
+  fflush(storage_file_);
+
+  XELOGI("Loaded %zu functions from the generated code storage in %" PRIu64
+         " milliseconds",
+         stored_functions_.size(),
+         (xe::Clock::QueryHostTickCount() - initialization_start) * 1000 /
+             xe::Clock::QueryHostTickFrequency());
+  return true;
+}
+
+void X64CodeCache::LoadStorage(uint64_t* out_valid_bytes,
+                               size_t* out_superseded_count) {
+  StoredFunctionHeader header;
+  std::vector<uint8_t> data;
+  while (fread(&header, sizeof(header), 1, storage_file_)) {
+    size_t code_size = header.code_size;
+    size_t relocations_size = header.relocation_count * sizeof(CodeRelocation);
+    size_t source_map_size = header.source_map_count * sizeof(SourceMapEntry);
+    size_t data_size = code_size + relocations_size + source_map_size;
+    if (!code_size || code_size > kGeneratedCodeSize ||
+        data_size > kGeneratedCodeSize) {
+      break;
+    }
+    data.resize(data_size);
+    if (!fread(data.data(), data_size, 1, storage_file_) ||
+        XXH64(data.data(), data_size, 0) != header.data_hash) {
+      // Validation failed.
+      break;
+    }
+    bool relocations_valid = true;
+    StoredFunction stored;
+    stored.guest_end_address = header.guest_end_address;
+    stored.guest_code_hash = header.guest_code_hash;
+    stored.func_info.code_size.total = code_size;
+    stored.func_info.code_size.prolog = header.prolog_size;
+    stored.func_info.code_size.body = header.body_size;
+    stored.func_info.code_size.epilog = header.epilog_size;
+    stored.func_info.code_size.tail = header.tail_size;
+    stored.func_info.prolog_stack_alloc_offset =
+        header.prolog_stack_alloc_offset;
+    stored.func_info.stack_size = header.stack_size;
+    stored.machine_code.assign(data.data(), data.data() + code_size);
+    stored.relocations.resize(header.relocation_count);
+    std::memcpy(stored.relocations.data(), data.data() + code_size,
+                relocations_size);
+    for (auto& relocation : stored.relocations) {
+      if (relocation.code_offset + sizeof(uint64_t) > code_size) {
+        relocations_valid = false;
+        break;
+      }
+    }
+    if (!relocations_valid) {
+      break;
+    }
+    stored.source_map.resize(header.source_map_count);
+    std::memcpy(stored.source_map.data(),
+                data.data() + code_size + relocations_size, source_map_size);
+    // Later records replace the earlier ones for the same function.
+    if (stored_functions_.count(header.guest_address)) {
+      ++(*out_superseded_count);
+    }
+    stored_functions_[header.guest_address] =
+        std::make_shared<const StoredFunction>(std::move(stored));
+    *out_valid_bytes += sizeof(header) + data_size;
+  }
+}
+
+void X64CodeCache::ShutdownStorage() {
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  if (storage_file_) {
+    XELOGI("Wrote %zu functions to the generated code storage",
+           stored_function_write_count_);
+    fclose(storage_file_);
+    storage_file_ = nullptr;
+  }
+  stored_functions_.clear();
+  stored_function_write_count_ = 0;
+}
+
+std::shared_ptr<const StoredFunction> X64CodeCache::LookupStoredFunction(
+    uint32_t guest_address) {
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  auto it = stored_functions_.find(guest_address);
+  return it != stored_functions_.end() ? it->second : nullptr;
+}
+
+void X64CodeCache::StoreFunction(
+    uint32_t guest_address, uint32_t guest_end_address,
+    uint64_t guest_code_hash, const void* machine_code,
+    const EmitFunctionInfo& func_info,
+    const std::vector<CodeRelocation>& relocations,
+    const std::vector<SourceMapEntry>& source_map) {
+  StoredFunction stored;
+  stored.guest_end_address = guest_end_address;
+  stored.guest_code_hash = guest_code_hash;
+  stored.func_info = func_info;
+  auto code = reinterpret_cast<const uint8_t*>(machine_code);
+  stored.machine_code.assign(code, code + func_info.code_size.total);
+  stored.relocations = relocations;
+  stored.source_map = source_map;
+
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  if (!storage_file_) {
+    return;
+  }
+  WriteStoredFunction(guest_address, stored);
+  fflush(storage_file_);
+  ++stored_function_write_count_;
+}
+
+void X64CodeCache::WriteStoredFunction(uint32_t guest_address,
+                                       const StoredFunction& stored) {
+  size_t code_size = stored.machine_code.size();
+  size_t relocations_size = stored.relocations.size() * sizeof(CodeRelocation);
+  size_t source_map_size = stored.source_map.size() * sizeof(SourceMapEntry);
+
+  StoredFunctionHeader header = {};
+  header.guest_address = guest_address;
+  header.guest_end_address = stored.guest_end_address;
+  header.guest_code_hash = stored.guest_code_hash;
+  header.code_size = uint32_t(code_size);
+  header.relocation_count = uint32_t(stored.relocations.size());
+  header.source_map_count = uint32_t(stored.source_map.size());
+  header.stack_size = uint32_t(stored.func_info.stack_size);
+  header.prolog_size = uint32_t(stored.func_info.code_size.prolog);
+  header.body_size = uint32_t(stored.func_info.code_size.body);
+  header.epilog_size = uint32_t(stored.func_info.code_size.epilog);
+  header.tail_size = uint32_t(stored.func_info.code_size.tail);
+  header.prolog_stack_alloc_offset =
+      uint32_t(stored.func_info.prolog_stack_alloc_offset);
+
+  XXH64_state_t hash_state;
+  XXH64_reset(&hash_state, 0);
+  XXH64_update(&hash_state, stored.machine_code.data(), code_size);
+  XXH64_update(&hash_state, stored.relocations.data(), relocations_size);
+  XXH64_update(&hash_state, stored.source_map.data(), source_map_size);
+  header.data_hash = XXH64_digest(&hash_state);
+
+  fwrite(&header, sizeof(header), 1, storage_file_);
+  fwrite(stored.machine_code.data(), code_size, 1, storage_file_);
+  if (relocations_size) {
+    fwrite(stored.relocations.data(), relocations_size, 1, storage_file_);
+  }
+  if (source_map_size) {
+    fwrite(stored.source_map.data(), source_map_size, 1, storage_file_);
+  }
+}
+
 }  // namespace x64
 }  // namespace backend
 }  // namespace cpu
@@ -11,8 +11,12 @@
 #define XENIA_CPU_BACKEND_X64_X64_CODE_CACHE_H_
 
 #include <atomic>
+#include <cstdio>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -37,6 +41,53 @@ struct EmitFunctionInfo {
   size_t stack_size;
 };
 
+// A 64-bit immediate in generated code that holds a host address that is not
+// stable between executions and must be patched when code is reloaded from the
+// storage.
+struct CodeRelocation {
+  enum class Type : uint32_t {
+    // Address within the host executable image. Value is the offset from
+    // X64Emitter::HostImageAnchor().
+    kHostImage,
+    // arg0/arg1 of the builtin function at the guest address in the value.
+    kBuiltinArg0,
+    kBuiltinArg1,
+  };
+  Type type;
+  // Offset of the imm64 from the start of the function.
+  uint32_t code_offset;
+  int64_t value;
+};
+static_assert(sizeof(CodeRelocation) == 16, "Stored on disk");
+
+// Generated code loaded from the storage, not placed yet.
+struct StoredFunction {
+  uint32_t guest_end_address;
+  uint64_t guest_code_hash;
+  EmitFunctionInfo func_info;
+  std::vector<uint8_t> machine_code;
+  std::vector<CodeRelocation> relocations;
+  std::vector<SourceMapEntry> source_map;
+};
+
+// Inline cache of an indirect guest call. The generated code compares the
+// target against up to kEntryCount guest addresses and calls the code cached
+// for them directly, falling back to the indirection table.
+struct InlineCacheSite {
+  static const size_t kEntryCount = 2;
+  // Guest address of the branch.
+  uint32_t guest_address;
+  // Entries in generated code: the imm32 of the compare against the guest
+  // target (0 while unused) and the rel32 of the call or jump to its code.
+  // Each entry is filled in once by X64CodeCache::AddInlineCacheTarget.
+  // Known when the site is added, before its code can run.
+  uint8_t* guest_target_imm32s[kEntryCount];
+  uint8_t* host_target_rel32s[kEntryCount];
+  // Only counted when JIT statistics are enabled.
+  uint64_t call_count;
+  uint64_t miss_count;
+};
+
 class X64CodeCache : public CodeCache {
  public:
   ~X64CodeCache() override;
@@ -49,13 +100,23 @@ class X64CodeCache : public CodeCache {
   uint32_t base_address() const override { return kGeneratedCodeBase; }
   uint32_t total_size() const override { return kGeneratedCodeSize; }
 
-  // TODO(benvanik): ELF serialization/etc
   // TODO(benvanik): keep track of code blocks
   // TODO(benvanik): padding/guards/etc
 
   bool has_indirection_table() { return indirection_table_base_ != nullptr; }
   void set_indirection_default(uint32_t default_value);
   void AddIndirection(uint32_t guest_address, uint32_t host_address);
+  // Registers the rel32 of a direct call or jump to the guest function in
+  // generated code. It's pointed at the current code of the function, and
+  // repointed whenever the indirection of the function changes.
+  void AddCallSite(uint32_t guest_address, uint8_t* rel32_address);
+  // Adds a copy of the site, with the code it points into placed and
+  // relocated but not reachable yet. Sites live until the code cache is
+  // destroyed.
+  InlineCacheSite* AddInlineCacheSite(const InlineCacheSite& site);
+  // Fills a free entry of the site with the target, if it's compiled.
+  void AddInlineCacheTarget(InlineCacheSite* site, uint32_t guest_address);
+  std::vector<const InlineCacheSite*> inline_cache_sites();
 
   void CommitExecutableRange(uint32_t guest_low, uint32_t guest_high);
 
@@ -68,6 +129,25 @@ class X64CodeCache : public CodeCache {
 
   GuestFunction* LookupFunction(uint64_t host_pc) override;
 
+  // Opens (or creates) the persistent storage of generated guest code for the
+  // module with the given hash. Records written with a different
+  // configuration_hash (emitter version, host features, etc) are discarded.
+  bool InitializeStorage(const std::wstring& storage_root, uint32_t title_id,
+                         uint64_t module_hash, uint64_t configuration_hash);
+  void ShutdownStorage();
+  bool has_storage() const { return storage_file_ != nullptr; }
+  // Returns the stored code for the function, or nullptr if none was stored.
+  // The record stays valid after ShutdownStorage.
+  std::shared_ptr<const StoredFunction> LookupStoredFunction(
+      uint32_t guest_address);
+  // Appends the placed code of the function to the storage. The imm64 values
+  // at the relocation offsets are ignored on load.
+  void StoreFunction(uint32_t guest_address, uint32_t guest_end_address,
+                     uint64_t guest_code_hash, const void* machine_code,
+                     const EmitFunctionInfo& func_info,
+                     const std::vector<CodeRelocation>& relocations,
+                     const std::vector<SourceMapEntry>& source_map);
+
  protected:
   // All executable code falls within 0x80000000 to 0x9FFFFFFF, so we can
   // only map enough for lookups within that range.
@@ -99,9 +179,48 @@ class X64CodeCache : public CodeCache {
                          const EmitFunctionInfo& func_info, void* code_address,
                          UnwindReservation unwind_reservation) {}
 
+  void PatchCallSite(uint8_t* rel32_address, uint32_t host_address);
+
+  // On-disk layout of a stored function. Followed by the machine code,
+  // relocations and source map entries.
+  struct StoredFunctionHeader {
+    uint32_t guest_address;
+    uint32_t guest_end_address;
+    uint64_t guest_code_hash;
+    uint32_t code_size;
+    uint32_t relocation_count;
+    uint32_t source_map_count;
+    uint32_t stack_size;
+    uint32_t prolog_size;
+    uint32_t body_size;
+    uint32_t epilog_size;
+    uint32_t tail_size;
+    uint32_t prolog_stack_alloc_offset;
+    uint32_t reserved;
+    // XXH64 of everything following the header.
+    uint64_t data_hash;
+
+    // Increment when changing the record layout or the generated code in a way
+    // that is not covered by the configuration hash.
+    static constexpr uint32_t kVersion = 0x20200401;
+  };
+  static_assert(sizeof(StoredFunctionHeader) == 64, "Stored on disk");
+
+  void LoadStorage(uint64_t* out_valid_bytes, size_t* out_superseded_count);
+  void WriteStoredFunction(uint32_t guest_address,
+                           const StoredFunction& stored);
+
   std::wstring file_name_;
   xe::memory::FileMappingHandle mapping_ = nullptr;
 
+  // Persistent code storage. The map is only filled during initialization,
+  // but it's cleared on shutdown while functions may still be looked up.
+  std::mutex storage_mutex_;
+  FILE* storage_file_ = nullptr;
+  std::unordered_map<uint32_t, std::shared_ptr<const StoredFunction>>
+      stored_functions_;
+  size_t stored_function_write_count_ = 0;
+
   // NOTE: the global critical region must be held when manipulating the offsets
   // or counts of anything, to keep the tables consistent and ordered.
   xe::global_critical_region global_critical_region_;
@@ -109,6 +228,11 @@ class X64CodeCache : public CodeCache {
   // Value that the indirection table will be initialized with upon commit.
   uint32_t indirection_default_value_ = 0xFEEDF00D;
 
+  // Linked call sites by target guest address. Guarded by the global lock.
+  std::unordered_map<uint32_t, std::vector<uint8_t*>> call_sites_;
+  // Guarded by the global lock.
+  std::deque<InlineCacheSite> inline_cache_sites_;
+
   // Fixed at kIndirectionTableBase in host space, holding 4 byte pointers into
   // the generated code table that correspond to the PPC functions in guest
   // space.
@@ -9,6 +9,12 @@
 
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 
+#include <cstdlib>
+#include <vector>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+
 namespace xe {
 namespace cpu {
 namespace backend {
@@ -21,19 +27,21 @@ class PosixX64CodeCache : public X64CodeCache {
 
   bool Initialize() override;
 
-  void* LookupUnwindInfo(uint64_t host_pc) override { return nullptr; }
+  void* LookupUnwindInfo(uint64_t host_pc) override;
 
  private:
-  /*
   UnwindReservation RequestUnwindReservation(uint8_t* entry_address) override;
-  void PlaceCode(uint32_t guest_address, void* machine_code, size_t code_size,
-                 size_t stack_size, void* code_address,
+  void PlaceCode(uint32_t guest_address, void* machine_code,
+                 const EmitFunctionInfo& func_info, void* code_address,
                  UnwindReservation unwind_reservation) override;
 
-  void InitializeUnwindEntry(uint8_t* unwind_entry_address,
-                             size_t unwind_table_slot, void* code_address,
-                             size_t code_size, size_t stack_size);
-  */
+  // Frame layouts of all placed code, in code order. Entries are only written
+  // under the global lock, before the count is bumped. When it's full, code is
+  // still placed, but the profiler can't step over its frames.
+  std::vector<CodeFrameLayout> frame_table_;
+  std::atomic<uint32_t> frame_table_count_ = {0};
+  uint32_t next_frame_table_slot_ = 0;
+  bool frame_table_full_ = false;
 };
 
 std::unique_ptr<X64CodeCache> X64CodeCache::Create() {
@@ -43,7 +51,67 @@ std::unique_ptr<X64CodeCache> X64CodeCache::Create() {
 PosixX64CodeCache::PosixX64CodeCache() = default;
 PosixX64CodeCache::~PosixX64CodeCache() = default;
 
-bool PosixX64CodeCache::Initialize() { return X64CodeCache::Initialize(); }
+bool PosixX64CodeCache::Initialize() {
+  if (!X64CodeCache::Initialize()) {
+    return false;
+  }
+  frame_table_.resize(kMaximumFunctionCount);
+  return true;
+}
+
+X64CodeCache::UnwindReservation PosixX64CodeCache::RequestUnwindReservation(
+    uint8_t* entry_address) {
+  UnwindReservation unwind_reservation;
+  unwind_reservation.entry_address = entry_address;
+  if (next_frame_table_slot_ >= frame_table_.size()) {
+    if (!frame_table_full_) {
+      XELOGW("Code frame table full, frames of further code can't be walked");
+      frame_table_full_ = true;
+    }
+    unwind_reservation.table_slot = frame_table_.size();
+    return unwind_reservation;
+  }
+  unwind_reservation.table_slot = next_frame_table_slot_++;
+  return unwind_reservation;
+}
+
+void PosixX64CodeCache::PlaceCode(uint32_t guest_address, void* machine_code,
+                                  const EmitFunctionInfo& func_info,
+                                  void* code_address,
+                                  UnwindReservation unwind_reservation) {
+  if (unwind_reservation.table_slot >= frame_table_.size()) {
+    return;
+  }
+  auto& layout = frame_table_[unwind_reservation.table_slot];
+  layout.code_address = reinterpret_cast<uint64_t>(code_address);
+  layout.code_size = uint32_t(func_info.code_size.total);
+  layout.prolog_stack_alloc_offset =
+      uint32_t(func_info.prolog_stack_alloc_offset);
+  layout.epilog_offset =
+      uint32_t(func_info.code_size.prolog + func_info.code_size.body);
+  layout.stack_size = uint32_t(func_info.stack_size);
+  // Placement happens in slot order under the global lock.
+  frame_table_count_ = uint32_t(unwind_reservation.table_slot + 1);
+}
+
+void* PosixX64CodeCache::LookupUnwindInfo(uint64_t host_pc) {
+  // May be called from a profiler with the owning thread stopped, so this
+  // must not lock or allocate.
+  return std::bsearch(
+      &host_pc, frame_table_.data(), frame_table_count_,
+      sizeof(CodeFrameLayout),
+      [](const void* key_ptr, const void* element_ptr) {
+        auto key = *reinterpret_cast<const uint64_t*>(key_ptr);
+        auto element = reinterpret_cast<const CodeFrameLayout*>(element_ptr);
+        if (key < element->code_address) {
+          return -1;
+        } else if (key >= element->code_address + element->code_size) {
+          return 1;
+        } else {
+          return 0;
+        }
+      });
+}
 
 }  // namespace x64
 }  // namespace backend
@@ -40,6 +40,20 @@ DEFINE_bool(ignore_undefined_externs, true,
 DEFINE_bool(emit_source_annotations, false,
             "Add extra movs and nops to make disassembly easier to read.",
             "CPU");
+DEFINE_bool(link_guest_calls, true,
+            "Emit direct guest to guest calls as rel32 calls that are patched "
+            "to the callee once it's compiled, instead of calling through the "
+            "indirection table. Not used with the code storage.",
+            "CPU");
+DEFINE_bool(inline_cache_indirect_calls, true,
+            "Compare the targets of indirect guest calls against the last "
+            "ones seen at the call site and call their code directly. Not "
+            "used with the code storage.",
+            "CPU");
+DEFINE_bool(vector_constant_pool, true,
+            "Load float and vector constants from a pool placed after the "
+            "function instead of building them on the stack.",
+            "CPU");
 
 namespace xe {
 namespace cpu {
@@ -77,6 +91,14 @@ X64Emitter::X64Emitter(X64Backend* backend, XbyakAllocator* allocator)
     feature_flags_ |= cpu_.has(Xbyak::util::Cpu::tBMI2) ? kX64EmitBMI2 : 0;
     feature_flags_ |= cpu_.has(Xbyak::util::Cpu::tF16C) ? kX64EmitF16C : 0;
     feature_flags_ |= cpu_.has(Xbyak::util::Cpu::tMOVBE) ? kX64EmitMovbe : 0;
+    if (cvars::use_avx512_instructions) {
+      feature_flags_ |=
+          cpu_.has(Xbyak::util::Cpu::tAVX512F) ? kX64EmitAVX512F : 0;
+      feature_flags_ |=
+          cpu_.has(Xbyak::util::Cpu::tAVX512VL) ? kX64EmitAVX512VL : 0;
+      feature_flags_ |=
+          cpu_.has(Xbyak::util::Cpu::tAVX512BW) ? kX64EmitAVX512BW : 0;
+    }
   }
 
   if (!cpu_.has(Xbyak::util::Cpu::tAVX)) {
@@ -99,7 +121,14 @@ bool X64Emitter::Emit(GuestFunction* function, HIRBuilder* builder,
   debug_info_ = debug_info;
   debug_info_flags_ = debug_info_flags;
   trace_data_ = &function->trace_data();
+  tier_up_function_ =
+      function->tier() == GuestFunction::Tier::kBaseline ? function : nullptr;
   source_map_arena_.Reset();
+  relocations_.clear();
+  call_sites_.clear();
+  inline_cache_sites_.clear();
+  current_guest_address_ = function->address();
+  storable_ = true;
 
   // Fill the generator with code.
   EmitFunctionInfo func_info = {};
@@ -114,6 +143,12 @@ bool X64Emitter::Emit(GuestFunction* function, HIRBuilder* builder,
   // Stash source map.
   source_map_arena_.CloneContents(out_source_map);
 
+  // Persist for later executions. Debug info may embed trace data pointers.
+  if (storable_ && !debug_info_flags_ && code_cache_->has_storage()) {
+    backend_->StoreFunction(function, *out_code_address, func_info,
+                            relocations_, *out_source_map);
+  }
+
   return true;
 }
 
@@ -136,12 +171,48 @@ void* X64Emitter::Emplace(const EmitFunctionInfo& func_info,
   ready();
   top_ = old_address;
   reset();
+
+  // After ready(), which resolves the calls to the thunk.
+  for (auto& call_site : call_sites_) {
+    code_cache_->AddCallSite(
+        call_site.guest_address,
+        reinterpret_cast<uint8_t*>(new_address) + call_site.rel32_offset);
+  }
+  // The code isn't reachable until the caller installs it, so the sites are
+  // complete by the time a miss can update them.
+  for (auto& pending_site : inline_cache_sites_) {
+    InlineCacheSite site = {};
+    site.guest_address = pending_site.guest_address;
+    for (size_t i = 0; i < InlineCacheSite::kEntryCount; ++i) {
+      site.guest_target_imm32s[i] = reinterpret_cast<uint8_t*>(new_address) +
+                                    pending_site.imm32_offsets[i];
+      site.host_target_rel32s[i] = reinterpret_cast<uint8_t*>(new_address) +
+                                   pending_site.rel32_offsets[i];
+    }
+    auto site_ptr = code_cache_->AddInlineCacheSite(site);
+    std::memcpy(reinterpret_cast<uint8_t*>(new_address) +
+                    pending_site.site_offset,
+                &site_ptr, sizeof(site_ptr));
+  }
   return new_address;
 }
 
+// Called by baseline code once its entry counter runs out.
+uint64_t RequestTierUp(void* raw_context, uint64_t function_ptr) {
+  auto thread_state = *reinterpret_cast<ThreadState**>(raw_context);
+  thread_state->processor()->RequestTierUp(
+      reinterpret_cast<GuestFunction*>(function_ptr));
+  return 0;
+}
+
 bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
   Xbyak::Label epilog_label;
   epilog_label_ = &epilog_label;
+  Xbyak::Label constant_pool_label;
+  constant_pool_label_ =
+      cvars::vector_constant_pool ? &constant_pool_label : nullptr;
+  constant_pool_.clear();
+  constant_pool_indices_.clear();
 
   // Calculate stack size. We need to align things to their natural sizes.
   // This could be much better (sort by type/etc).
@@ -224,6 +295,19 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
   mov(GetMembaseReg(),
       qword[GetContextReg() + offsetof(ppc::PPCContext, virtual_membase)]);
 
+  if (tier_up_function_) {
+    // Baseline code. Ask for the optimized tier once entered often enough.
+    Xbyak::Label counting_label;
+    mov(rax, reinterpret_cast<uint64_t>(tier_up_function_->tier_up_counter()));
+    dec(dword[rax]);
+    jnz(counting_label, CodeGenerator::T_NEAR);
+    mov(GetNativeParam(0), reinterpret_cast<uint64_t>(tier_up_function_));
+    CallNativeSafe(reinterpret_cast<void*>(RequestTierUp));
+    L(counting_label);
+    // Points at the function object.
+    storable_ = false;
+  }
+
   // Body.
   auto block = builder->first_block();
   while (block) {
@@ -273,6 +357,8 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
     nop();
   }
 
+  EmitConstantPool();
+
   assert_zero(code_offsets.prolog);
   func_info.code_size.total = getSize();
   func_info.code_size.prolog = code_offsets.body - code_offsets.prolog;
@@ -290,6 +376,7 @@ void X64Emitter::MarkSourceOffset(const Instr* i) {
   entry->guest_address = static_cast<uint32_t>(i->src1.offset);
   entry->hir_offset = uint32_t(i->block->ordinal << 16) | i->ordinal;
   entry->code_offset = static_cast<uint32_t>(getSize());
+  current_guest_address_ = entry->guest_address;
 
   if (cvars::emit_source_annotations) {
     nop();
@@ -393,10 +480,18 @@ extern "C" uint64_t ResolveFunction(void* raw_context,
 void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   assert_not_null(function);
   auto fn = static_cast<X64Function*>(function);
+  if (cvars::link_guest_calls && code_cache_->has_indirection_table() &&
+      !code_cache_->has_storage()) {
+    CallLinked(instr, fn);
+    return;
+  }
   // Resolve address to the function to call and store in rax.
-  if (fn->machine_code()) {
+  if (fn->machine_code() && !code_cache_->has_storage() &&
+      !cvars::tiered_compilation) {
     // TODO(benvanik): is it worth it to do this? It removes the need for
     // a ResolveFunction call, but makes the table less useful.
+    // Not done with the code storage as code addresses differ between runs,
+    // or with tiered compilation as the code is replaced when promoted.
     assert_zero(uint64_t(fn->machine_code()) & 0xFFFFFFFF00000000);
     mov(eax, uint32_t(uint64_t(fn->machine_code())));
   } else if (code_cache_->has_indirection_table()) {
@@ -430,6 +525,39 @@ void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   }
 }
 
+void X64Emitter::CallLinked(const hir::Instr* instr, GuestFunction* function) {
+  // Calls or jumps straight to the code of the function. Until it's compiled
+  // the target is the ResolveFunction thunk, which compiles it and patches
+  // this and all other linked call sites through the code cache.
+  void* target = function->machine_code();
+  if (!target) {
+    target = reinterpret_cast<void*>(backend()->resolve_function_thunk());
+  }
+  // The thunk takes the guest address in ebx.
+  mov(ebx, function->address());
+
+  if (instr->flags & hir::CALL_TAIL) {
+    // Since we skip the prolog we need to mark the return here.
+    EmitTraceUserCallReturn();
+
+    // Pass the callers return address over.
+    mov(rcx, qword[rsp + StackLayout::GUEST_RET_ADDR]);
+
+    add(rsp, static_cast<uint32_t>(stack_size()));
+    // Align the rel32 so it can be patched atomically.
+    nop((4 - ((getSize() + 1) & 3)) & 3);
+    jmp(target, CodeGenerator::T_NEAR);
+  } else {
+    // Return address is from the previous SET_RETURN_ADDRESS.
+    mov(rcx, qword[rsp + StackLayout::GUEST_CALL_RET_ADDR]);
+
+    nop((4 - ((getSize() + 1) & 3)) & 3);
+    call(target);
+  }
+  call_sites_.push_back(
+      {static_cast<uint32_t>(getSize() - 4), function->address()});
+}
+
 void X64Emitter::CallIndirect(const hir::Instr* instr,
                               const Xbyak::Reg64& reg) {
   // Check if return.
@@ -438,6 +566,12 @@ void X64Emitter::CallIndirect(const hir::Instr* instr,
     je(epilog_label(), CodeGenerator::T_NEAR);
   }
 
+  if (cvars::inline_cache_indirect_calls &&
+      code_cache_->has_indirection_table() && !code_cache_->has_storage()) {
+    CallIndirectCached(instr, reg);
+    return;
+  }
+
   // Load the pointer to the indirection table maintained in X64CodeCache.
   // The target dword will either contain the address of the generated code
   // or a thunk to ResolveAddress.
@@ -473,6 +607,122 @@ void X64Emitter::CallIndirect(const hir::Instr* instr,
   }
 }
 
+// Called on inline cache misses until all entries of the site are used.
+uint64_t UpdateInlineCache(void* raw_context, uint64_t site_ptr,
+                           uint64_t target_address) {
+  auto thread_state = *reinterpret_cast<ThreadState**>(raw_context);
+  auto backend =
+      static_cast<X64Backend*>(thread_state->processor()->backend());
+  backend->code_cache()->AddInlineCacheTarget(
+      reinterpret_cast<InlineCacheSite*>(site_ptr),
+      static_cast<uint32_t>(target_address));
+  return 0;
+}
+
+void X64Emitter::CallIndirectCached(const hir::Instr* instr,
+                                    const Xbyak::Reg64& reg) {
+  // Targets are compared against the guest addresses cached in the imm32s
+  // below, and hits go straight to the code through a rel32 like linked
+  // calls. Entries start out as 0, which never matches, and are filled in by
+  // the code cache from misses once their target is compiled.
+  // The InlineCacheSite is only created by Emplace, so its pointer is loaded
+  // from a slot in the code.
+  PendingInlineCacheSite pending_site;
+  pending_site.guest_address = current_guest_address_;
+  Xbyak::Label site_label;
+
+  // The fallback and the ResolveFunction thunk take the guest address in ebx.
+  if (reg.cvt32() != ebx) {
+    mov(ebx, reg.cvt32());
+  }
+  bool count_calls = cvars::log_jit_stats || !cvars::jit_stats_path.empty();
+  if (count_calls) {
+    // Not locked - the counts are only statistics.
+    mov(rax, qword[rip + site_label]);
+    inc(qword[rax + offsetof(InlineCacheSite, call_count)]);
+  }
+
+  Xbyak::Label hit_labels[InlineCacheSite::kEntryCount];
+  Xbyak::Label last_entry_label;
+  Xbyak::Label fallback_label;
+  Xbyak::Label fallback_jump_label;
+  Xbyak::Label done_label;
+  for (size_t i = 0; i < InlineCacheSite::kEntryCount; ++i) {
+    // cmp ebx, imm32, with the imm32 aligned so it can be patched atomically.
+    nop((4 - ((getSize() + 2) & 3)) & 3);
+    db(0x81);
+    db(0xFB);
+    if (i == InlineCacheSite::kEntryCount - 1) {
+      L(last_entry_label);
+    }
+    pending_site.imm32_offsets[i] = static_cast<uint32_t>(getSize());
+    dd(0);
+    je(hit_labels[i], CodeGenerator::T_NEAR);
+  }
+
+  // Miss. Ask the code cache to take the target while entries are free.
+  if (count_calls) {
+    inc(qword[rax + offsetof(InlineCacheSite, miss_count)]);
+  }
+  cmp(dword[rip + last_entry_label], 0);
+  jne(fallback_label, CodeGenerator::T_NEAR);
+  mov(GetNativeParam(0), qword[rip + site_label]);
+  mov(GetNativeParam(1).cvt32(), ebx);
+  CallNativeSafe(reinterpret_cast<void*>(UpdateInlineCache));
+
+  // Call or jump through the indirection table as usual. This also compiles
+  // the target if needed.
+  L(fallback_label);
+  mov(eax, dword[ebx]);
+  if (instr->flags & hir::CALL_TAIL) {
+    // Since we skip the prolog we need to mark the return here.
+    EmitTraceUserCallReturn();
+
+    // Pass the callers return address over.
+    mov(rcx, qword[rsp + StackLayout::GUEST_RET_ADDR]);
+
+    add(rsp, static_cast<uint32_t>(stack_size()));
+    jmp(rax);
+  } else {
+    // Return address is from the previous SET_RETURN_ADDRESS.
+    mov(rcx, qword[rsp + StackLayout::GUEST_CALL_RET_ADDR]);
+
+    call(rax);
+    jmp(done_label, CodeGenerator::T_NEAR);
+  }
+
+  // Hits, with the rel32s initially going to the fallback jump.
+  for (size_t i = 0; i < InlineCacheSite::kEntryCount; ++i) {
+    L(hit_labels[i]);
+    if (instr->flags & hir::CALL_TAIL) {
+      EmitTraceUserCallReturn();
+      mov(rcx, qword[rsp + StackLayout::GUEST_RET_ADDR]);
+      add(rsp, static_cast<uint32_t>(stack_size()));
+      nop((4 - ((getSize() + 1) & 3)) & 3);
+      jmp(fallback_jump_label, CodeGenerator::T_NEAR);
+    } else {
+      mov(rcx, qword[rsp + StackLayout::GUEST_CALL_RET_ADDR]);
+      nop((4 - ((getSize() + 1) & 3)) & 3);
+      call(fallback_jump_label);
+    }
+    pending_site.rel32_offsets[i] = static_cast<uint32_t>(getSize() - 4);
+    if (!(instr->flags & hir::CALL_TAIL)) {
+      jmp(done_label, CodeGenerator::T_NEAR);
+    }
+  }
+
+  L(fallback_jump_label);
+  mov(eax, dword[ebx]);
+  jmp(rax);
+
+  L(site_label);
+  pending_site.site_offset = static_cast<uint32_t>(getSize());
+  dq(0);
+
+  L(done_label);
+  inline_cache_sites_.push_back(pending_site);
+}
+
 uint64_t UndefinedCallExtern(void* raw_context, uint64_t function_ptr) {
   auto function = reinterpret_cast<Function*>(function_ptr);
   if (!cvars::ignore_undefined_externs) {
@@ -496,9 +746,16 @@ void X64Emitter::CallExtern(const hir::Instr* instr, const Function* function) {
       // r9  = arg2
       auto thunk = backend()->guest_to_host_thunk();
       mov(rax, reinterpret_cast<uint64_t>(thunk));
-      mov(rcx, reinterpret_cast<uint64_t>(builtin_function->handler()));
-      mov(rdx, reinterpret_cast<uint64_t>(builtin_function->arg0()));
-      mov(r8, reinterpret_cast<uint64_t>(builtin_function->arg1()));
+      MovHostImageAddress(rcx,
+                          reinterpret_cast<void*>(builtin_function->handler()));
+      MovRelocatableImm64(rdx,
+                          reinterpret_cast<uint64_t>(builtin_function->arg0()),
+                          CodeRelocation::Type::kBuiltinArg0,
+                          builtin_function->address());
+      MovRelocatableImm64(r8,
+                          reinterpret_cast<uint64_t>(builtin_function->arg1()),
+                          CodeRelocation::Type::kBuiltinArg1,
+                          builtin_function->address());
       call(rax);
       // rax = host return
     }
@@ -512,7 +769,8 @@ void X64Emitter::CallExtern(const hir::Instr* instr, const Function* function) {
       // r9  = arg2
       auto thunk = backend()->guest_to_host_thunk();
       mov(rax, reinterpret_cast<uint64_t>(thunk));
-      mov(rcx, reinterpret_cast<uint64_t>(extern_function->extern_handler()));
+      MovHostImageAddress(
+          rcx, reinterpret_cast<void*>(extern_function->extern_handler()));
       mov(rdx,
           qword[GetContextReg() + offsetof(ppc::PPCContext, kernel_state)]);
       call(rax);
@@ -520,6 +778,7 @@ void X64Emitter::CallExtern(const hir::Instr* instr, const Function* function) {
     }
   }
   if (undefined) {
+    MarkNotStorable();
     CallNative(UndefinedCallExtern, reinterpret_cast<uint64_t>(function));
   }
 }
@@ -547,7 +806,7 @@ void X64Emitter::CallNativeSafe(void* fn) {
   // r9  = arg2
   auto thunk = backend()->guest_to_host_thunk();
   mov(rax, reinterpret_cast<uint64_t>(thunk));
-  mov(rcx, reinterpret_cast<uint64_t>(fn));
+  MovHostImageAddress(rcx, fn);
   call(rax);
   // rax = host return
 }
@@ -569,6 +828,28 @@ Xbyak::Reg64 X64Emitter::GetNativeParam(uint32_t param) {
   return r9;
 }
 
+uint64_t X64Emitter::HostImageAnchor() {
+  return reinterpret_cast<uint64_t>(&ResolveFunction);
+}
+
+void X64Emitter::MovHostImageAddress(const Xbyak::Reg64& dest,
+                                     const void* address) {
+  uint64_t value = reinterpret_cast<uint64_t>(address);
+  MovRelocatableImm64(dest, value, CodeRelocation::Type::kHostImage,
+                      int64_t(value - HostImageAnchor()));
+}
+
+void X64Emitter::MovRelocatableImm64(const Xbyak::Reg64& dest, uint64_t value,
+                                     CodeRelocation::Type type,
+                                     int64_t relocation_value) {
+  // REX.W (+ REX.B for r8-r15), B8+r, imm64.
+  db(0x48 | (dest.getIdx() >= 8 ? 0x01 : 0x00));
+  db(0xB8 | (dest.getIdx() & 0x07));
+  relocations_.push_back(
+      {type, static_cast<uint32_t>(getSize()), relocation_value});
+  dq(value);
+}
+
 // Important: If you change these, you must update the thunks in x64_backend.cc!
 Xbyak::Reg64 X64Emitter::GetContextReg() { return rsi; }
 Xbyak::Reg64 X64Emitter::GetMembaseReg() { return rdi; }
@@ -738,6 +1019,27 @@ static const vec128_t xmm_consts[] = {
     /* XMMIntMaxPD            */ vec128d(INT_MAX),
     /* XMMPosIntMinPS         */ vec128f((float)0x80000000u),
     /* XMMQNaN                */ vec128i(0x7FC00000u),
+    /* XMMShiftMaskI8         */ vec128b(0x07),
+    /* XMMShiftMaskI16        */ vec128i(0x000F000Fu),
+    /* XMMLowByteMaskI16      */ vec128i(0x00FF00FFu),
+    /* XMMHighByteMaskI16     */ vec128i(0xFF00FF00u),
+    /* XMMPI16                */ vec128i(0x00100010u),
+    /* XMMShlMultipliersI8    */
+    vec128i(0x08040201u, 0x80402010u, 0x00000000u, 0x00000000u),
+    /* XMMShrMultipliersI8    */
+    vec128i(0x10204080u, 0x01020408u, 0x00000000u, 0x00000000u),
+    /* XMMShlMultiplierIndexI16 */ vec128i(0x08000800u),
+    /* XMMPackFLOAT16_DenormScale */ vec128f(16777216.0f),
+    /* XMMPackFLOAT16_NormalBias */ vec128i(0x0001C000u),
+    /* XMMPackFLOAT16_MinNormal */ vec128i(0x387FFFFFu),
+    /* XMMPackFLOAT16_MaxUnpacked */ vec128i(0x477FFFFFu),
+    /* XMMPackFLOAT16_Max     */ vec128i(0x00007BFFu),
+    /* XMMPackFLOAT16_InfNaNBias */ vec128i(0x00038000u),
+    /* XMMPackFLOAT16_InfNaNMin */ vec128i(0x7F7FFFFFu),
+    /* XMMPackFLOAT16_QuietNaN */ vec128i(0x00000200u),
+    /* XMMUnpackFLOAT16_AbsMask */ vec128i(0x00007FFFu),
+    /* XMMUnpackFLOAT16_Scale */ vec128i(0x77800000u),
+    /* XMMUnpackFLOAT16_InfNaN */ vec128i(0x7F800000u),
 };
 
 // First location to try and place constants.
@@ -794,9 +1096,10 @@ void X64Emitter::LoadConstantXmm(Xbyak::Xmm dest, const vec128_t& v) {
   } else if (v.low == ~0ull && v.high == ~0ull) {
     // 1111...
     vpcmpeqb(dest, dest);
+  } else if (has_constant_pool()) {
+    vmovdqa(dest, GetConstantPoolPtr(v));
   } else {
     // TODO(benvanik): see what other common values are.
-    // TODO(benvanik): build constant table - 99% are reused.
     MovMem64(rsp + kStashOffset, v.low);
     MovMem64(rsp + kStashOffset + 8, v.high);
     vmovdqa(dest, ptr[rsp + kStashOffset]);
@@ -841,6 +1144,53 @@ void X64Emitter::LoadConstantXmm(Xbyak::Xmm dest, double v) {
   }
 }
 
+Xbyak::Address X64Emitter::GetConstantPoolPtr(float v) {
+  union {
+    float f;
+    uint32_t i;
+  } x = {v};
+  return GetConstantPoolPtr(vec128q(x.i, 0));
+}
+
+Xbyak::Address X64Emitter::GetConstantPoolPtr(double v) {
+  union {
+    double d;
+    uint64_t i;
+  } x = {v};
+  return GetConstantPoolPtr(vec128q(x.i, 0));
+}
+
+Xbyak::Address X64Emitter::GetConstantPoolPtr(const vec128_t& v) {
+  assert_not_null(constant_pool_label_);
+  auto key = std::make_pair(v.low, v.high);
+  auto it = constant_pool_indices_.find(key);
+  uint32_t index;
+  if (it != constant_pool_indices_.end()) {
+    index = it->second;
+  } else {
+    index = uint32_t(constant_pool_.size());
+    constant_pool_.push_back(v);
+    constant_pool_indices_.emplace(key, index);
+  }
+  return ptr[rip + *constant_pool_label_ + int(index * sizeof(vec128_t))];
+}
+
+void X64Emitter::EmitConstantPool() {
+  if (!constant_pool_.empty()) {
+    // Code is placed at 16b aligned addresses, so aligning the offset in the
+    // function is enough. Nothing executes the padding.
+    while (getSize() & 15) {
+      db(0xCC);
+    }
+    L(*constant_pool_label_);
+    for (const vec128_t& v : constant_pool_) {
+      dq(v.low);
+      dq(v.high);
+    }
+  }
+  constant_pool_label_ = nullptr;
+}
+
 Xbyak::Address X64Emitter::StashXmm(int index, const Xbyak::Xmm& r) {
   auto addr = ptr[rsp + kStashOffset + (index * 16)];
   vmovups(addr, r);
@@ -848,6 +1198,9 @@ Xbyak::Address X64Emitter::StashXmm(int index, const Xbyak::Xmm& r) {
 }
 
 Xbyak::Address X64Emitter::StashConstantXmm(int index, float v) {
+  if (has_constant_pool()) {
+    return GetConstantPoolPtr(v);
+  }
   union {
     float f;
     uint32_t i;
@@ -859,6 +1212,9 @@ Xbyak::Address X64Emitter::StashConstantXmm(int index, float v) {
 }
 
 Xbyak::Address X64Emitter::StashConstantXmm(int index, double v) {
+  if (has_constant_pool()) {
+    return GetConstantPoolPtr(v);
+  }
   union {
     double d;
     uint64_t i;
@@ -870,6 +1226,10 @@ Xbyak::Address X64Emitter::StashConstantXmm(int index, double v) {
 }
 
 Xbyak::Address X64Emitter::StashConstantXmm(int index, const vec128_t& v) {
+  if (has_constant_pool()) {
+    // Only ever read through the address, so no need for a copy.
+    return GetConstantPoolPtr(v);
+  }
   auto addr = rsp + kStashOffset + (index * 16);
   MovMem64(addr, v.low);
   MovMem64(addr + 8, v.high);
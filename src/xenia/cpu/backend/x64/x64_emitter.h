@@ -10,9 +10,12 @@
 #ifndef XENIA_CPU_BACKEND_X64_X64_EMITTER_H_
 #define XENIA_CPU_BACKEND_X64_X64_EMITTER_H_
 
+#include <map>
+#include <utility>
 #include <vector>
 
 #include "xenia/base/arena.h"
+#include "xenia/cpu/backend/x64/x64_code_cache.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/function_trace_data.h"
 #include "xenia/cpu/hir/hir_builder.h"
@@ -37,9 +40,6 @@ namespace backend {
 namespace x64 {
 
 class X64Backend;
-class X64CodeCache;
-
-struct EmitFunctionInfo;
 
 enum RegisterFlags {
   REG_DEST = (1 << 0),
@@ -114,6 +114,25 @@ enum XmmConst {
   XMMIntMaxPD,
   XMMPosIntMinPS,
   XMMQNaN,
+  XMMShiftMaskI8,
+  XMMShiftMaskI16,
+  XMMLowByteMaskI16,
+  XMMHighByteMaskI16,
+  XMMPI16,
+  XMMShlMultipliersI8,
+  XMMShrMultipliersI8,
+  XMMShlMultiplierIndexI16,
+  XMMPackFLOAT16_DenormScale,
+  XMMPackFLOAT16_NormalBias,
+  XMMPackFLOAT16_MinNormal,
+  XMMPackFLOAT16_MaxUnpacked,
+  XMMPackFLOAT16_Max,
+  XMMPackFLOAT16_InfNaNBias,
+  XMMPackFLOAT16_InfNaNMin,
+  XMMPackFLOAT16_QuietNaN,
+  XMMUnpackFLOAT16_AbsMask,
+  XMMUnpackFLOAT16_Scale,
+  XMMUnpackFLOAT16_InfNaN,
 };
 
 // Unfortunately due to the design of xbyak we have to pass this to the ctor.
@@ -129,6 +148,13 @@ enum X64EmitterFeatureFlags {
   kX64EmitBMI2 = 1 << 4,
   kX64EmitF16C = 1 << 5,
   kX64EmitMovbe = 1 << 6,
+  kX64EmitAVX512F = 1 << 7,
+  kX64EmitAVX512VL = 1 << 8,
+  kX64EmitAVX512BW = 1 << 9,
+
+  // AVX-512 instructions on xmm registers.
+  kX64EmitAVX512Ortho = kX64EmitAVX512F | kX64EmitAVX512VL,
+  kX64EmitAVX512OrthoBW = kX64EmitAVX512Ortho | kX64EmitAVX512BW,
 };
 
 class X64Emitter : public Xbyak::CodeGenerator {
@@ -186,7 +212,9 @@ class X64Emitter : public Xbyak::CodeGenerator {
   void UnimplementedInstr(const hir::Instr* i);
 
   void Call(const hir::Instr* instr, GuestFunction* function);
+  void CallLinked(const hir::Instr* instr, GuestFunction* function);
   void CallIndirect(const hir::Instr* instr, const Xbyak::Reg64& reg);
+  void CallIndirectCached(const hir::Instr* instr, const Xbyak::Reg64& reg);
   void CallExtern(const hir::Instr* instr, const Function* function);
   void CallNative(void* fn);
   void CallNative(uint64_t (*fn)(void* raw_context));
@@ -217,11 +245,35 @@ class X64Emitter : public Xbyak::CodeGenerator {
   Xbyak::Address StashConstantXmm(int index, float v);
   Xbyak::Address StashConstantXmm(int index, double v);
   Xbyak::Address StashConstantXmm(int index, const vec128_t& v);
-
+  // RIP-relative operand referencing a 16-byte aligned copy of the constant in
+  // the pool placed after the body of the function being emitted. Scalars are
+  // zero-extended to 128 bits. Only valid while emitting a guest function.
+  Xbyak::Address GetConstantPoolPtr(float v);
+  Xbyak::Address GetConstantPoolPtr(double v);
+  Xbyak::Address GetConstantPoolPtr(const vec128_t& v);
+  bool has_constant_pool() const { return constant_pool_label_ != nullptr; }
+
+  // True if all of the given features are enabled.
   bool IsFeatureEnabled(uint32_t feature_flag) const {
-    return (feature_flags_ & feature_flag) != 0;
+    return (feature_flags_ & feature_flag) == feature_flag;
   }
 
+  uint32_t feature_flags() const { return feature_flags_; }
+
+  // Host image addresses are stored relative to this so that code loaded from
+  // the storage can be relocated if the executable is loaded elsewhere.
+  static uint64_t HostImageAnchor();
+  // Moves the address of a function or static data of the host executable
+  // into the register, recording a relocation for the code storage.
+  void MovHostImageAddress(const Xbyak::Reg64& dest, const void* address);
+  // Always emits the 10-byte mov r64, imm64 form so the immediate can be
+  // patched when the code is restored.
+  void MovRelocatableImm64(const Xbyak::Reg64& dest, uint64_t value,
+                           CodeRelocation::Type type, int64_t relocation_value);
+  // The function being emitted references host state that can't be
+  // relocated, so it must not be written to the code storage.
+  void MarkNotStorable() { storable_ = false; }
+
   FunctionDebugInfo* debug_info() const { return debug_info_; }
 
   size_t stack_size() const { return stack_size_; }
@@ -232,6 +284,7 @@ class X64Emitter : public Xbyak::CodeGenerator {
   bool Emit(hir::HIRBuilder* builder, EmitFunctionInfo& func_info);
   void EmitGetCurrentThreadId();
   void EmitTraceUserCallReturn();
+  void EmitConstantPool();
 
  protected:
   Processor* processor_ = nullptr;
@@ -243,15 +296,43 @@ class X64Emitter : public Xbyak::CodeGenerator {
 
   Xbyak::Label* epilog_label_ = nullptr;
 
+  Xbyak::Label* constant_pool_label_ = nullptr;
+  // Deduplicated constants of the function, in pool order.
+  std::vector<vec128_t> constant_pool_;
+  std::map<std::pair<uint64_t, uint64_t>, uint32_t> constant_pool_indices_;
+
   hir::Instr* current_instr_ = nullptr;
 
   FunctionDebugInfo* debug_info_ = nullptr;
   uint32_t debug_info_flags_ = 0;
   FunctionTraceData* trace_data_ = nullptr;
+  // Baseline function being emitted, counting its entries.
+  GuestFunction* tier_up_function_ = nullptr;
   Arena source_map_arena_;
 
   size_t stack_size_ = 0;
 
+  std::vector<CodeRelocation> relocations_;
+  bool storable_ = true;
+
+  // Direct calls to guest functions, linked by the code cache once placed.
+  struct CallSite {
+    uint32_t rel32_offset;
+    uint32_t guest_address;
+  };
+  std::vector<CallSite> call_sites_;
+  // Inline caches of indirect calls, pointed at their code once placed.
+  struct PendingInlineCacheSite {
+    uint32_t guest_address;
+    // Where the code loads the InlineCacheSite pointer from.
+    uint32_t site_offset;
+    uint32_t imm32_offsets[InlineCacheSite::kEntryCount];
+    uint32_t rel32_offsets[InlineCacheSite::kEntryCount];
+  };
+  std::vector<PendingInlineCacheSite> inline_cache_sites_;
+  // Guest address of the instruction being emitted.
+  uint32_t current_guest_address_ = 0;
+
   static const uint32_t gpr_reg_map_[GPR_COUNT];
   static const uint32_t xmm_reg_map_[XMM_COUNT];
 };
@@ -565,6 +565,24 @@ struct Sequence {
     }
   }
 
+  // Like EmitAssociativeBinaryXmmOp, but a constant src2 is passed to fn as a
+  // memory operand (in the function's constant pool, or stashed on the stack
+  // without one) instead of being loaded into a register first, so fn must
+  // take a const Xbyak::Operand& src2.
+  template <typename FN>
+  static void EmitBinaryXmmMemOp(X64Emitter& e, const EmitArgType& i,
+                                 const FN& fn) {
+    if (i.src1.is_constant) {
+      assert_true(!i.src2.is_constant);
+      e.LoadConstantXmm(e.xmm0, i.src1.constant());
+      fn(e, i.dest, e.xmm0, i.src2);
+    } else if (i.src2.is_constant) {
+      fn(e, i.dest, i.src1, e.StashConstantXmm(0, i.src2.constant()));
+    } else {
+      fn(e, i.dest, i.src1, i.src2);
+    }
+  }
+
   template <typename REG_REG_FN, typename REG_CONST_FN>
   static void EmitCommutativeCompareOp(X64Emitter& e, const EmitArgType& i,
                                        const REG_REG_FN& reg_reg_fn,
@@ -103,6 +103,102 @@ RegExp ComputeMemoryAddress(X64Emitter& e, const T& guest) {
   }
 }
 
+// Loads a value narrower than dest and zero or sign extends it, as specified by
+// the LoadStoreFlags of the instruction.
+void EmitLoadExtend(X64Emitter& e, const Xbyak::Reg& dest, const RegExp& addr,
+                    uint16_t flags) {
+  bool swap = (flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) != 0;
+  bool sign = (flags & LoadStoreFlags::LOAD_SIGN_EXTEND) != 0;
+  // Writing the 32-bit register clears the upper half, only sign extension to
+  // 64 bits needs the full register.
+  Xbyak::Reg wide_dest =
+      sign && dest.getBit() == 64 ? Xbyak::Reg(dest) : dest.cvt32();
+  switch (flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I8:
+      if (sign) {
+        e.movsx(wide_dest, e.byte[addr]);
+      } else {
+        e.movzx(wide_dest, e.byte[addr]);
+      }
+      break;
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I16:
+      if (swap) {
+        if (e.IsFeatureEnabled(kX64EmitMovbe)) {
+          e.movbe(dest.cvt16(), e.word[addr]);
+        } else {
+          e.mov(dest.cvt16(), e.word[addr]);
+          e.ror(dest.cvt16(), 8);
+        }
+        if (sign) {
+          e.movsx(wide_dest, dest.cvt16());
+        } else {
+          e.movzx(wide_dest, dest.cvt16());
+        }
+      } else {
+        if (sign) {
+          e.movsx(wide_dest, e.word[addr]);
+        } else {
+          e.movzx(wide_dest, e.word[addr]);
+        }
+      }
+      break;
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I32:
+      assert_true(dest.getBit() == 64);
+      if (swap) {
+        if (e.IsFeatureEnabled(kX64EmitMovbe)) {
+          e.movbe(dest.cvt32(), e.dword[addr]);
+        } else {
+          e.mov(dest.cvt32(), e.dword[addr]);
+          e.bswap(dest.cvt32());
+        }
+        if (sign) {
+          e.movsxd(dest.cvt64(), dest.cvt32());
+        }
+      } else {
+        if (sign) {
+          e.movsxd(dest.cvt64(), e.dword[addr]);
+        } else {
+          e.mov(dest.cvt32(), e.dword[addr]);
+        }
+      }
+      break;
+    default:
+      assert_unhandled_case(flags);
+      break;
+  }
+}
+
+// Stores the low part of src, as specified by the LoadStoreFlags of the
+// instruction.
+void EmitStoreTruncate(X64Emitter& e, const RegExp& addr,
+                       const Xbyak::Reg& src, uint16_t flags) {
+  bool swap = (flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) != 0;
+  switch (flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I8:
+      e.mov(e.byte[addr], src.cvt8());
+      break;
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I16:
+      if (swap) {
+        assert_true(e.IsFeatureEnabled(kX64EmitMovbe));
+        e.movbe(e.word[addr], src.cvt16());
+      } else {
+        e.mov(e.word[addr], src.cvt16());
+      }
+      break;
+    case LoadStoreFlags::LOAD_STORE_MEMORY_I32:
+      if (swap) {
+        assert_true(e.IsFeatureEnabled(kX64EmitMovbe));
+        e.movbe(e.dword[addr], src.cvt32());
+      } else {
+        e.mov(e.dword[addr], src.cvt32());
+      }
+      break;
+    default:
+      assert_unhandled_case(flags);
+      break;
+  }
+}
+
 // ============================================================================
 // OPCODE_ATOMIC_EXCHANGE
 // ============================================================================
@@ -556,6 +652,8 @@ struct LOAD_MMIO_I32
     // uint64_t (context, addr)
     auto mmio_range = reinterpret_cast<MMIORange*>(i.src1.value);
     auto read_address = uint32_t(i.src2.value);
+    // The callback context is owned by the MMIO handler.
+    e.MarkNotStorable();
     e.mov(e.GetNativeParam(0), uint64_t(mmio_range->callback_context));
     e.mov(e.GetNativeParam(1).cvt32(), read_address);
     e.CallNativeSafe(reinterpret_cast<void*>(mmio_range->read));
@@ -581,6 +679,8 @@ struct STORE_MMIO_I32
     // void (context, addr, value)
     auto mmio_range = reinterpret_cast<MMIORange*>(i.src1.value);
     auto write_address = uint32_t(i.src2.value);
+    // The callback context is owned by the MMIO handler.
+    e.MarkNotStorable();
     e.mov(e.GetNativeParam(0), uint64_t(mmio_range->callback_context));
     e.mov(e.GetNativeParam(1).cvt32(), write_address);
     if (i.src3.is_constant) {
@@ -618,7 +718,9 @@ struct LOAD_OFFSET_I16
     : Sequence<LOAD_OFFSET_I16, I<OPCODE_LOAD_OFFSET, I16Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.word[addr]);
       } else {
@@ -635,7 +737,9 @@ struct LOAD_OFFSET_I32
     : Sequence<LOAD_OFFSET_I32, I<OPCODE_LOAD_OFFSET, I32Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.dword[addr]);
       } else {
@@ -652,7 +756,9 @@ struct LOAD_OFFSET_I64
     : Sequence<LOAD_OFFSET_I64, I<OPCODE_LOAD_OFFSET, I64Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.qword[addr]);
       } else {
@@ -688,7 +794,10 @@ struct STORE_OFFSET_I16
                I<OPCODE_STORE_OFFSET, VoidOp, I64Op, I64Op, I16Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src3.is_constant);
+      EmitStoreTruncate(e, addr, i.src3, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src3.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.word[addr], i.src3);
@@ -710,7 +819,10 @@ struct STORE_OFFSET_I32
                I<OPCODE_STORE_OFFSET, VoidOp, I64Op, I64Op, I32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src3.is_constant);
+      EmitStoreTruncate(e, addr, i.src3, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src3.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.dword[addr], i.src3);
@@ -732,7 +844,10 @@ struct STORE_OFFSET_I64
                I<OPCODE_STORE_OFFSET, VoidOp, I64Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddressOffset(e, i.src1, i.src2);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src3.is_constant);
+      EmitStoreTruncate(e, addr, i.src3, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src3.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.qword[addr], i.src3);
@@ -768,7 +883,9 @@ struct LOAD_I8 : Sequence<LOAD_I8, I<OPCODE_LOAD, I8Op, I64Op>> {
 struct LOAD_I16 : Sequence<LOAD_I16, I<OPCODE_LOAD, I16Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.word[addr]);
       } else {
@@ -788,7 +905,9 @@ struct LOAD_I16 : Sequence<LOAD_I16, I<OPCODE_LOAD, I16Op, I64Op>> {
 struct LOAD_I32 : Sequence<LOAD_I32, I<OPCODE_LOAD, I32Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.dword[addr]);
       } else {
@@ -808,7 +927,9 @@ struct LOAD_I32 : Sequence<LOAD_I32, I<OPCODE_LOAD, I32Op, I64Op>> {
 struct LOAD_I64 : Sequence<LOAD_I64, I<OPCODE_LOAD, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      EmitLoadExtend(e, i.dest, addr, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(i.dest, e.qword[addr]);
       } else {
@@ -895,7 +1016,10 @@ struct STORE_I8 : Sequence<STORE_I8, I<OPCODE_STORE, VoidOp, I64Op, I8Op>> {
 struct STORE_I16 : Sequence<STORE_I16, I<OPCODE_STORE, VoidOp, I64Op, I16Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src2.is_constant);
+      EmitStoreTruncate(e, addr, i.src2, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src2.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.word[addr], i.src2);
@@ -920,7 +1044,10 @@ struct STORE_I16 : Sequence<STORE_I16, I<OPCODE_STORE, VoidOp, I64Op, I16Op>> {
 struct STORE_I32 : Sequence<STORE_I32, I<OPCODE_STORE, VoidOp, I64Op, I32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src2.is_constant);
+      EmitStoreTruncate(e, addr, i.src2, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src2.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.dword[addr], i.src2);
@@ -945,7 +1072,10 @@ struct STORE_I32 : Sequence<STORE_I32, I<OPCODE_STORE, VoidOp, I64Op, I32Op>> {
 struct STORE_I64 : Sequence<STORE_I64, I<OPCODE_STORE, VoidOp, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     auto addr = ComputeMemoryAddress(e, i.src1);
-    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
+    if (i.instr->flags & LoadStoreFlags::LOAD_STORE_MEMORY_TYPE_MASK) {
+      assert_false(i.src2.is_constant);
+      EmitStoreTruncate(e, addr, i.src2, i.instr->flags);
+    } else if (i.instr->flags & LoadStoreFlags::LOAD_STORE_BYTE_SWAP) {
       assert_false(i.src2.is_constant);
       if (e.IsFeatureEnabled(kX64EmitMovbe)) {
         e.movbe(e.qword[addr], i.src2);
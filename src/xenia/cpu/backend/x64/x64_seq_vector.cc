@@ -14,9 +14,6 @@
 
 #include "xenia/cpu/backend/x64/x64_op.h"
 
-// For OPCODE_PACK/OPCODE_UNPACK
-#include "third_party/half/include/half.hpp"
-
 namespace xe {
 namespace cpu {
 namespace backend {
@@ -132,14 +129,14 @@ struct LOAD_VECTOR_SHL_I8
     if (i.src1.is_constant) {
       auto sh = i.src1.constant();
       assert_true(sh < xe::countof(lvsl_table));
-      e.mov(e.rax, (uintptr_t)&lvsl_table[sh]);
+      e.MovHostImageAddress(e.rax, &lvsl_table[sh]);
       e.vmovaps(i.dest, e.ptr[e.rax]);
     } else {
       // TODO(benvanik): find a cheaper way of doing this.
       e.movzx(e.rdx, i.src1);
       e.and_(e.dx, 0xF);
       e.shl(e.dx, 4);
-      e.mov(e.rax, (uintptr_t)lvsl_table);
+      e.MovHostImageAddress(e.rax, lvsl_table);
       e.vmovaps(i.dest, e.ptr[e.rax + e.rdx]);
     }
   }
@@ -173,14 +170,14 @@ struct LOAD_VECTOR_SHR_I8
     if (i.src1.is_constant) {
       auto sh = i.src1.constant();
       assert_true(sh < xe::countof(lvsr_table));
-      e.mov(e.rax, (uintptr_t)&lvsr_table[sh]);
+      e.MovHostImageAddress(e.rax, &lvsr_table[sh]);
       e.vmovaps(i.dest, e.ptr[e.rax]);
     } else {
       // TODO(benvanik): find a cheaper way of doing this.
       e.movzx(e.rdx, i.src1);
       e.and_(e.dx, 0xF);
       e.shl(e.dx, 4);
-      e.mov(e.rax, (uintptr_t)lvsr_table);
+      e.MovHostImageAddress(e.rax, lvsr_table);
       e.vmovaps(i.dest, e.ptr[e.rax + e.rdx]);
     }
   }
@@ -284,8 +281,8 @@ struct VECTOR_COMPARE_EQ_V128
     : Sequence<VECTOR_COMPARE_EQ_V128,
                I<OPCODE_VECTOR_COMPARE_EQ, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(
-        e, i, [&i](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
+    EmitBinaryXmmMemOp(
+        e, i, [&i](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
           switch (i.instr->flags) {
             case INT8_TYPE:
               e.vpcmpeqb(dest, src1, src2);
@@ -312,8 +309,8 @@ struct VECTOR_COMPARE_SGT_V128
     : Sequence<VECTOR_COMPARE_SGT_V128,
                I<OPCODE_VECTOR_COMPARE_SGT, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitAssociativeBinaryXmmOp(
-        e, i, [&i](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
+    EmitBinaryXmmMemOp(
+        e, i, [&i](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
           switch (i.instr->flags) {
             case INT8_TYPE:
               e.vpcmpgtb(dest, src1, src2);
@@ -687,6 +684,76 @@ static __m128i EmulateVectorShl(void*, __m128i src1, __m128i src2) {
   return _mm_load_si128(reinterpret_cast<__m128i*>(value));
 }
 
+// Returns the register holding the value to shift, loading it into xmm3 if
+// it's constant.
+static Xmm GetVectorShiftSrc1(X64Emitter& e, const V128Op& src1) {
+  if (src1.is_constant) {
+    e.LoadConstantXmm(e.xmm3, src1.constant());
+    return e.xmm3;
+  }
+  return src1;
+}
+
+// Loads the shift amounts masked to the lane width into xmm0.
+static void LoadVectorShiftAmounts(X64Emitter& e, const V128Op& src2,
+                                   XmmConst mask) {
+  if (src2.is_constant) {
+    e.LoadConstantXmm(e.xmm0, src2.constant());
+    e.vpand(e.xmm0, e.GetXmmConstPtr(mask));
+  } else {
+    e.vpand(e.xmm0, src2, e.GetXmmConstPtr(mask));
+  }
+}
+
+// Byte shifts without variable byte shift instructions, with the masked shift
+// amounts in xmm0. The bytes are widened to 16 bits and multiplied by powers
+// of two looked up with vpshufb, separately for even and odd bytes.
+static void EmitVectorShlInt8(X64Emitter& e, Xmm dest, Xmm src1) {
+  // The low byte of x * (1 << n) is x << n, and the high byte of the
+  // multiplier for the even byte doesn't affect it.
+  e.vmovdqa(e.xmm1, e.GetXmmConstPtr(XMMShlMultipliersI8));
+  e.vpshufb(e.xmm0, e.xmm1, e.xmm0);
+  e.vpmullw(e.xmm1, src1, e.xmm0);
+  e.vpand(e.xmm1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+  e.vpsrlw(e.xmm0, e.xmm0, 8);
+  e.vpand(e.xmm2, src1, e.GetXmmConstPtr(XMMHighByteMaskI16));
+  e.vpmullw(e.xmm0, e.xmm2, e.xmm0);
+  e.vpor(dest, e.xmm1, e.xmm0);
+}
+
+static void EmitVectorShrInt8(X64Emitter& e, Xmm dest, Xmm src1,
+                              bool is_arithmetic) {
+  // x >> n is (x * (1 << (7 - n))) >> 7 with x widened to 16 bits.
+  e.vmovdqa(e.xmm1, e.GetXmmConstPtr(XMMShrMultipliersI8));
+  e.vpshufb(e.xmm0, e.xmm1, e.xmm0);
+  // Even bytes.
+  if (is_arithmetic) {
+    e.vpsllw(e.xmm2, src1, 8);
+    e.vpsraw(e.xmm2, e.xmm2, 8);
+  } else {
+    e.vpand(e.xmm2, src1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+  }
+  e.vpand(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMLowByteMaskI16));
+  e.vpmullw(e.xmm2, e.xmm2, e.xmm1);
+  if (is_arithmetic) {
+    e.vpsraw(e.xmm2, e.xmm2, 7);
+    e.vpand(e.xmm2, e.GetXmmConstPtr(XMMLowByteMaskI16));
+  } else {
+    e.vpsrlw(e.xmm2, e.xmm2, 7);
+  }
+  // Odd bytes, shifting the product right by 7 and back left by 8.
+  e.vpsrlw(e.xmm0, e.xmm0, 8);
+  if (is_arithmetic) {
+    e.vpsraw(e.xmm1, src1, 8);
+  } else {
+    e.vpsrlw(e.xmm1, src1, 8);
+  }
+  e.vpmullw(e.xmm0, e.xmm1, e.xmm0);
+  e.vpsllw(e.xmm0, e.xmm0, 1);
+  e.vpand(e.xmm0, e.GetXmmConstPtr(XMMHighByteMaskI16));
+  e.vpor(dest, e.xmm2, e.xmm0);
+}
+
 struct VECTOR_SHL_V128
     : Sequence<VECTOR_SHL_V128, I<OPCODE_VECTOR_SHL, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
@@ -707,25 +774,13 @@ struct VECTOR_SHL_V128
   }
 
   static void EmitInt8(X64Emitter& e, const EmitArgType& i) {
-    // TODO(benvanik): native version (with shift magic).
-    if (i.src2.is_constant) {
-      e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-    } else {
-      e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-    }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-    e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShl<uint8_t>));
-    e.vmovaps(i.dest, e.xmm0);
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI8);
+    EmitVectorShlInt8(e, i.dest, src1);
   }
 
   static void EmitInt16(X64Emitter& e, const EmitArgType& i) {
-    Xmm src1;
-    if (i.src1.is_constant) {
-      src1 = e.xmm2;
-      e.LoadConstantXmm(src1, i.src1.constant());
-    } else {
-      src1 = i.src1;
-    }
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
 
     if (i.src2.is_constant) {
       const auto& shamt = i.src2.constant();
@@ -743,38 +798,19 @@ struct VECTOR_SHL_V128
       }
     }
 
-    // Shift 8 words in src1 by amount specified in src2.
-    Xbyak::Label emu, end;
-
-    // Only bother with this check if shift amt isn't constant.
-    if (!i.src2.is_constant) {
-      // See if the shift is equal first for a shortcut.
-      e.vpshuflw(e.xmm0, i.src2, 0b00000000);
-      e.vpshufd(e.xmm0, e.xmm0, 0b00000000);
-      e.vpxor(e.xmm1, e.xmm0, i.src2);
-      e.vptest(e.xmm1, e.xmm1);
-      e.jnz(emu);
-
-      // Equal. Shift using vpsllw.
-      e.mov(e.rax, 0xF);
-      e.vmovq(e.xmm1, e.rax);
-      e.vpand(e.xmm0, e.xmm0, e.xmm1);
-      e.vpsllw(i.dest, src1, e.xmm0);
-      e.jmp(end);
-    }
-
-    // TODO(benvanik): native version (with shift magic).
-    e.L(emu);
-    if (i.src2.is_constant) {
-      e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-    } else {
-      e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
+    LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+    if (e.IsFeatureEnabled(kX64EmitAVX512OrthoBW)) {
+      e.vpsllvw(i.dest, src1, e.xmm0);
+      return;
     }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
-    e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShl<uint16_t>));
-    e.vmovaps(i.dest, e.xmm0);
-
-    e.L(end);
+    // Multiply by 1 << n, looking up the low byte of the multiplier with n
+    // and the high byte with n ^ 8 in a table of 1 << n for n < 8.
+    e.vpsllw(e.xmm1, e.xmm0, 8);
+    e.vpor(e.xmm0, e.xmm1);
+    e.vpxor(e.xmm0, e.GetXmmConstPtr(XMMShlMultiplierIndexI16));
+    e.vmovdqa(e.xmm1, e.GetXmmConstPtr(XMMShlMultipliersI8));
+    e.vpshufb(e.xmm0, e.xmm1, e.xmm0);
+    e.vpmullw(i.dest, src1, e.xmm0);
   }
 
   static void EmitInt32(X64Emitter& e, const EmitArgType& i) {
@@ -896,18 +932,14 @@ struct VECTOR_SHR_V128
   }
 
   static void EmitInt8(X64Emitter& e, const EmitArgType& i) {
-    // TODO(benvanik): native version (with shift magic).
-    if (i.src2.is_constant) {
-      e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-    } else {
-      e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-    }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-    e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShr<uint8_t>));
-    e.vmovaps(i.dest, e.xmm0);
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI8);
+    EmitVectorShrInt8(e, i.dest, src1, false);
   }
 
   static void EmitInt16(X64Emitter& e, const EmitArgType& i) {
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+
     if (i.src2.is_constant) {
       const auto& shamt = i.src2.constant();
       bool all_same = true;
@@ -919,11 +951,29 @@ struct VECTOR_SHR_V128
       }
       if (all_same) {
         // Every count is the same, so we can use vpsllw.
-        e.vpsrlw(i.dest, i.src1, shamt.u16[0] & 0xF);
+        e.vpsrlw(i.dest, src1, shamt.u16[0] & 0xF);
         return;
       }
     }
 
+    if (e.IsFeatureEnabled(kX64EmitAVX512OrthoBW)) {
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpsrlvw(i.dest, src1, e.xmm0);
+      return;
+    }
+    if (e.IsFeatureEnabled(kX64EmitAVX2)) {
+      // Shift even and odd words as dwords, with the odd words in the high
+      // halves so nothing shifts into them.
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpand(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMMaskEvenPI16));
+      e.vpand(e.xmm2, src1, e.GetXmmConstPtr(XMMMaskEvenPI16));
+      e.vpsrlvd(e.xmm1, e.xmm2, e.xmm1);
+      e.vpsrld(e.xmm0, e.xmm0, 16);
+      e.vpsrlvd(e.xmm0, src1, e.xmm0);
+      e.vpblendw(i.dest, e.xmm1, e.xmm0, 0b10101010);
+      return;
+    }
+
     // Shift 8 words in src1 by amount specified in src2.
     Xbyak::Label emu, end;
 
@@ -940,18 +990,17 @@ struct VECTOR_SHR_V128
       e.mov(e.rax, 0xF);
       e.vmovq(e.xmm1, e.rax);
       e.vpand(e.xmm0, e.xmm0, e.xmm1);
-      e.vpsrlw(i.dest, i.src1, e.xmm0);
+      e.vpsrlw(i.dest, src1, e.xmm0);
       e.jmp(end);
     }
 
-    // TODO(benvanik): native version (with shift magic).
     e.L(emu);
     if (i.src2.is_constant) {
       e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
     } else {
       e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
     }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
+    e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
     e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShr<uint16_t>));
     e.vmovaps(i.dest, e.xmm0);
 
@@ -1060,18 +1109,14 @@ struct VECTOR_SHA_V128
   }
 
   static void EmitInt8(X64Emitter& e, const EmitArgType& i) {
-    // TODO(benvanik): native version (with shift magic).
-    if (i.src2.is_constant) {
-      e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-    } else {
-      e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-    }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-    e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShr<int8_t>));
-    e.vmovaps(i.dest, e.xmm0);
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI8);
+    EmitVectorShrInt8(e, i.dest, src1, true);
   }
 
   static void EmitInt16(X64Emitter& e, const EmitArgType& i) {
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+
     if (i.src2.is_constant) {
       const auto& shamt = i.src2.constant();
       bool all_same = true;
@@ -1083,11 +1128,30 @@ struct VECTOR_SHA_V128
       }
       if (all_same) {
         // Every count is the same, so we can use vpsraw.
-        e.vpsraw(i.dest, i.src1, shamt.u16[0] & 0xF);
+        e.vpsraw(i.dest, src1, shamt.u16[0] & 0xF);
         return;
       }
     }
 
+    if (e.IsFeatureEnabled(kX64EmitAVX512OrthoBW)) {
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpsravw(i.dest, src1, e.xmm0);
+      return;
+    }
+    if (e.IsFeatureEnabled(kX64EmitAVX2)) {
+      // Shift even and odd words as dwords, moving the even words to the
+      // high halves first so their sign bits are shifted in.
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpand(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMMaskEvenPI16));
+      e.vpslld(e.xmm2, src1, 16);
+      e.vpsravd(e.xmm2, e.xmm2, e.xmm1);
+      e.vpsrld(e.xmm2, e.xmm2, 16);
+      e.vpsrld(e.xmm0, e.xmm0, 16);
+      e.vpsravd(e.xmm0, src1, e.xmm0);
+      e.vpblendw(i.dest, e.xmm2, e.xmm0, 0b10101010);
+      return;
+    }
+
     // Shift 8 words in src1 by amount specified in src2.
     Xbyak::Label emu, end;
 
@@ -1104,18 +1168,17 @@ struct VECTOR_SHA_V128
       e.mov(e.rax, 0xF);
       e.vmovq(e.xmm1, e.rax);
       e.vpand(e.xmm0, e.xmm0, e.xmm1);
-      e.vpsraw(i.dest, i.src1, e.xmm0);
+      e.vpsraw(i.dest, src1, e.xmm0);
       e.jmp(end);
     }
 
-    // TODO(benvanik): native version (with shift magic).
     e.L(emu);
     if (i.src2.is_constant) {
       e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
     } else {
       e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
     }
-    e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
+    e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
     e.CallNativeSafe(reinterpret_cast<void*>(EmulateVectorShr<int16_t>));
     e.vmovaps(i.dest, e.xmm0);
 
@@ -1206,101 +1269,135 @@ static __m128i EmulateVectorRotateLeft(void*, __m128i src1, __m128i src2) {
   return _mm_load_si128(reinterpret_cast<__m128i*>(value));
 }
 
-// TODO(benvanik): AVX512 has a native variable rotate (rolv).
 struct VECTOR_ROTATE_LEFT_V128
     : Sequence<VECTOR_ROTATE_LEFT_V128,
                I<OPCODE_VECTOR_ROTATE_LEFT, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     switch (i.instr->flags) {
       case INT8_TYPE:
-        // TODO(benvanik): native version (with shift magic).
-        if (i.src2.is_constant) {
-          e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-        } else {
-          e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-        }
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-        e.CallNativeSafe(
-            reinterpret_cast<void*>(EmulateVectorRotateLeft<uint8_t>));
-        e.vmovaps(i.dest, e.xmm0);
+        EmitInt8(e, i);
         break;
       case INT16_TYPE:
-        // TODO(benvanik): native version (with shift magic).
-        if (i.src2.is_constant) {
-          e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
-        } else {
-          e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-        }
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-        e.CallNativeSafe(
-            reinterpret_cast<void*>(EmulateVectorRotateLeft<uint16_t>));
-        e.vmovaps(i.dest, e.xmm0);
+        EmitInt16(e, i);
         break;
-      case INT32_TYPE: {
-        if (e.IsFeatureEnabled(kX64EmitAVX2)) {
-          Xmm temp = i.dest;
-          if (i.dest == i.src1 || i.dest == i.src2) {
-            temp = e.xmm2;
-          }
-          // Shift left (to get high bits):
-          if (i.src2.is_constant) {
-            e.LoadConstantXmm(temp, i.src2.constant());
-            e.vpand(e.xmm0, temp, e.GetXmmConstPtr(XMMShiftMaskPS));
-          } else {
-            e.vpand(e.xmm0, i.src2, e.GetXmmConstPtr(XMMShiftMaskPS));
-          }
-          e.vpsllvd(e.xmm1, i.src1, e.xmm0);
-          // Shift right (to get low bits):
-          e.vmovaps(temp, e.GetXmmConstPtr(XMMPI32));
-          e.vpsubd(temp, e.xmm0);
-          e.vpsrlvd(i.dest, i.src1, temp);
-          // Merge:
-          e.vpor(i.dest, e.xmm1);
-        } else {
-          // TODO(benvanik): non-AVX2 native version.
-          if (i.src2.is_constant) {
-            e.lea(e.GetNativeParam(1),
-                  e.StashConstantXmm(1, i.src2.constant()));
-          } else {
-            e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-          }
-          e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-          e.CallNativeSafe(
-              reinterpret_cast<void*>(EmulateVectorRotateLeft<uint32_t>));
-          e.vmovaps(i.dest, e.xmm0);
-        }
+      case INT32_TYPE:
+        EmitInt32(e, i);
         break;
-      }
       default:
         assert_always();
         break;
     }
   }
+
+  static void EmitInt8(X64Emitter& e, const EmitArgType& i) {
+    // The 16-bit product of a byte and 1 << n holds x << n in the low byte
+    // and x >> (8 - n) in the high byte, so OR them together.
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI8);
+    e.vmovdqa(e.xmm1, e.GetXmmConstPtr(XMMShlMultipliersI8));
+    e.vpshufb(e.xmm0, e.xmm1, e.xmm0);
+    // Even bytes.
+    e.vpand(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMLowByteMaskI16));
+    e.vpand(e.xmm2, src1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+    e.vpmullw(e.xmm1, e.xmm2, e.xmm1);
+    e.vpsrlw(e.xmm2, e.xmm1, 8);
+    e.vpor(e.xmm1, e.xmm2);
+    e.vpand(e.xmm1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+    // Odd bytes.
+    e.vpsrlw(e.xmm0, e.xmm0, 8);
+    e.vpsrlw(e.xmm2, src1, 8);
+    e.vpmullw(e.xmm0, e.xmm2, e.xmm0);
+    e.vpsllw(e.xmm2, e.xmm0, 8);
+    e.vpor(e.xmm0, e.xmm2);
+    e.vpand(e.xmm0, e.GetXmmConstPtr(XMMHighByteMaskI16));
+    e.vpor(i.dest, e.xmm1, e.xmm0);
+  }
+
+  static void EmitInt16(X64Emitter& e, const EmitArgType& i) {
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    if (e.IsFeatureEnabled(kX64EmitAVX512OrthoBW)) {
+      // Shifts by 16 give 0, so a count of 0 works.
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpsllvw(e.xmm1, src1, e.xmm0);
+      e.vmovdqa(e.xmm2, e.GetXmmConstPtr(XMMPI16));
+      e.vpsubw(e.xmm0, e.xmm2, e.xmm0);
+      e.vpsrlvw(e.xmm0, src1, e.xmm0);
+      e.vpor(i.dest, e.xmm1, e.xmm0);
+    } else if (e.IsFeatureEnabled(kX64EmitAVX2)) {
+      // Shift the zero-extended even and odd words left as dwords and OR the
+      // bits shifted out into the high half back into the low half.
+      LoadVectorShiftAmounts(e, i.src2, XMMShiftMaskI16);
+      e.vpand(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMMaskEvenPI16));
+      e.vpand(e.xmm2, src1, e.GetXmmConstPtr(XMMMaskEvenPI16));
+      e.vpsllvd(e.xmm1, e.xmm2, e.xmm1);
+      e.vpsrld(e.xmm2, e.xmm1, 16);
+      e.vpor(e.xmm1, e.xmm2);
+      e.vpsrld(e.xmm0, e.xmm0, 16);
+      e.vpsrld(e.xmm2, src1, 16);
+      e.vpsllvd(e.xmm0, e.xmm2, e.xmm0);
+      e.vpslld(e.xmm2, e.xmm0, 16);
+      e.vpor(e.xmm0, e.xmm2);
+      e.vpblendw(i.dest, e.xmm1, e.xmm0, 0b10101010);
+    } else {
+      if (i.src2.is_constant) {
+        e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
+      } else {
+        e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
+      }
+      e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
+      e.CallNativeSafe(
+          reinterpret_cast<void*>(EmulateVectorRotateLeft<uint16_t>));
+      e.vmovaps(i.dest, e.xmm0);
+    }
+  }
+
+  static void EmitInt32(X64Emitter& e, const EmitArgType& i) {
+    Xmm src1 = GetVectorShiftSrc1(e, i.src1);
+    if (e.IsFeatureEnabled(kX64EmitAVX512Ortho)) {
+      // vprolvd uses the counts modulo 32.
+      if (i.src2.is_constant) {
+        e.vprolvd(i.dest, src1, e.StashConstantXmm(0, i.src2.constant()));
+      } else {
+        e.vprolvd(i.dest, src1, i.src2);
+      }
+    } else if (e.IsFeatureEnabled(kX64EmitAVX2)) {
+      Xmm temp = i.dest;
+      if (i.dest == src1 || i.dest == i.src2) {
+        temp = e.xmm2;
+      }
+      // Shift left (to get high bits):
+      if (i.src2.is_constant) {
+        e.LoadConstantXmm(temp, i.src2.constant());
+        e.vpand(e.xmm0, temp, e.GetXmmConstPtr(XMMShiftMaskPS));
+      } else {
+        e.vpand(e.xmm0, i.src2, e.GetXmmConstPtr(XMMShiftMaskPS));
+      }
+      e.vpsllvd(e.xmm1, src1, e.xmm0);
+      // Shift right (to get low bits):
+      e.vmovaps(temp, e.GetXmmConstPtr(XMMPI32));
+      e.vpsubd(temp, e.xmm0);
+      e.vpsrlvd(i.dest, src1, temp);
+      // Merge:
+      e.vpor(i.dest, e.xmm1);
+    } else {
+      // TODO(benvanik): non-AVX2 native version.
+      if (i.src2.is_constant) {
+        e.lea(e.GetNativeParam(1), e.StashConstantXmm(1, i.src2.constant()));
+      } else {
+        e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
+      }
+      e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
+      e.CallNativeSafe(
+          reinterpret_cast<void*>(EmulateVectorRotateLeft<uint32_t>));
+      e.vmovaps(i.dest, e.xmm0);
+    }
+  }
 };
 EMITTER_OPCODE_TABLE(OPCODE_VECTOR_ROTATE_LEFT, VECTOR_ROTATE_LEFT_V128);
 
 // ============================================================================
 // OPCODE_VECTOR_AVERAGE
 // ============================================================================
-template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
-static __m128i EmulateVectorAverage(void*, __m128i src1, __m128i src2) {
-  alignas(16) T src1v[16 / sizeof(T)];
-  alignas(16) T src2v[16 / sizeof(T)];
-  alignas(16) T value[16 / sizeof(T)];
-
-  // Load SSE registers into a C array.
-  _mm_store_si128(reinterpret_cast<__m128i*>(src1v), src1);
-  _mm_store_si128(reinterpret_cast<__m128i*>(src2v), src2);
-
-  for (size_t i = 0; i < (16 / sizeof(T)); ++i) {
-    auto t = (uint64_t(src1v[i]) + uint64_t(src2v[i]) + 1) / 2;
-    value[i] = T(t);
-  }
-
-  // Store result and return it.
-  return _mm_load_si128(reinterpret_cast<__m128i*>(value));
-}
-
 struct VECTOR_AVERAGE
     : Sequence<VECTOR_AVERAGE,
                I<OPCODE_VECTOR_AVERAGE, V128Op, V128Op, V128Op>> {
@@ -1328,30 +1425,16 @@ struct VECTOR_AVERAGE
               }
               break;
             case INT32_TYPE:
-              // No 32bit averages in AVX.
+              // No 32bit averages in AVX, but (a + b + 1) >> 1 without
+              // overflow is (a | b) - ((a ^ b) >> 1).
+              e.vpxor(e.xmm1, src1, src2);
               if (is_unsigned) {
-                if (i.src2.is_constant) {
-                  e.lea(e.GetNativeParam(1),
-                        e.StashConstantXmm(1, i.src2.constant()));
-                } else {
-                  e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-                }
-                e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-                e.CallNativeSafe(
-                    reinterpret_cast<void*>(EmulateVectorAverage<uint32_t>));
-                e.vmovaps(i.dest, e.xmm0);
+                e.vpsrld(e.xmm1, e.xmm1, 1);
               } else {
-                if (i.src2.is_constant) {
-                  e.lea(e.GetNativeParam(1),
-                        e.StashConstantXmm(1, i.src2.constant()));
-                } else {
-                  e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-                }
-                e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-                e.CallNativeSafe(
-                    reinterpret_cast<void*>(EmulateVectorAverage<int32_t>));
-                e.vmovaps(i.dest, e.xmm0);
+                e.vpsrad(e.xmm1, e.xmm1, 1);
               }
+              e.vpor(dest, src1, src2);
+              e.vpsubd(dest, dest, e.xmm1);
               break;
             default:
               assert_unhandled_case(part_type);
@@ -1476,7 +1559,7 @@ struct EXTRACT_I32
       e.mov(e.al, i.src2);
       e.and_(e.al, 0x03);
       e.shl(e.al, 4);
-      e.mov(e.rdx, reinterpret_cast<uint64_t>(extract_table_32));
+      e.MovHostImageAddress(e.rdx, extract_table_32);
       e.vmovaps(e.xmm0, e.ptr[e.rdx + e.rax]);
       e.vpshufb(e.xmm0, src1, e.xmm0);
       e.vpextrd(i.dest, e.xmm0, 0);
@@ -1851,83 +1934,78 @@ struct PACK : Sequence<PACK, I<OPCODE_PACK, V128Op, V128Op, V128Op>> {
     //     ((src1.uy & 0xFF) << 8) | (src1.uz & 0xFF)
     e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMPackD3DCOLOR));
   }
-  static __m128i EmulateFLOAT16_2(void*, __m128 src1) {
-    alignas(16) float a[4];
-    alignas(16) uint16_t b[8];
-    _mm_store_ps(a, src1);
-    std::memset(b, 0, sizeof(b));
-
-    for (int i = 0; i < 2; i++) {
-      b[7 - i] = half_float::detail::float2half<std::round_toward_zero>(a[i]);
-    }
-
-    return _mm_load_si128(reinterpret_cast<__m128i*>(b));
+  // Converts 4 floats to halves in the low 64 bits of dest, rounding toward
+  // zero like vcvtps2ph with rounding mode 3, for hosts without F16C.
+  static void EmitFloatToHalf(X64Emitter& e, Xmm dest, Xmm src) {
+    e.vpand(e.xmm0, src, e.GetXmmConstPtr(XMMAbsMaskPS));
+    // Denormals: truncated |x| * 2^24.
+    e.vmulps(e.xmm1, e.xmm0, e.GetXmmConstPtr(XMMPackFLOAT16_DenormScale));
+    e.vcvttps2dq(e.xmm1, e.xmm1);
+    // Normal values: rebias the exponent of the truncated mantissa.
+    e.vpsrld(e.xmm2, e.xmm0, 13);
+    e.vpsubd(e.xmm2, e.GetXmmConstPtr(XMMPackFLOAT16_NormalBias));
+    e.vpcmpgtd(e.xmm3, e.xmm0, e.GetXmmConstPtr(XMMPackFLOAT16_MinNormal));
+    e.vpblendvb(e.xmm1, e.xmm1, e.xmm2, e.xmm3);
+    // Too large values: the largest finite half.
+    e.vpcmpgtd(e.xmm3, e.xmm0, e.GetXmmConstPtr(XMMPackFLOAT16_MaxUnpacked));
+    e.vpblendvb(e.xmm1, e.xmm1, e.GetXmmConstPtr(XMMPackFLOAT16_Max), e.xmm3);
+    // Infinity and NaN: keep the top of the mantissa.
+    e.vpsrld(e.xmm2, e.xmm0, 13);
+    e.vpsubd(e.xmm2, e.GetXmmConstPtr(XMMPackFLOAT16_InfNaNBias));
+    e.vpcmpgtd(e.xmm3, e.xmm0, e.GetXmmConstPtr(XMMPackFLOAT16_InfNaNMin));
+    e.vpblendvb(e.xmm1, e.xmm1, e.xmm2, e.xmm3);
+    // NaN: set the quiet bit like vcvtps2ph does, NaNs with only the low
+    // mantissa bits set would become infinity otherwise.
+    e.vpcmpgtd(e.xmm3, e.xmm0, e.GetXmmConstPtr(XMMUnpackFLOAT16_InfNaN));
+    e.vpand(e.xmm3, e.GetXmmConstPtr(XMMPackFLOAT16_QuietNaN));
+    e.vpor(e.xmm1, e.xmm3);
+    // Sign.
+    e.vpsrld(e.xmm0, src, 16);
+    e.vpand(e.xmm0, e.GetXmmConstPtr(XMMSignMaskI16));
+    e.vpor(e.xmm1, e.xmm0);
+    // 0|0|0|0|W|Z|Y|X like vcvtps2ph, the high half doesn't matter.
+    e.vpackusdw(dest, e.xmm1, e.xmm1);
   }
   static void EmitFLOAT16_2(X64Emitter& e, const EmitArgType& i) {
     assert_true(i.src2.value->IsConstantZero());
     // http://blogs.msdn.com/b/chuckw/archive/2012/09/11/directxmath-f16c-and-fma.aspx
     // dest = [(src1.x | src1.y), 0, 0, 0]
 
+    Xmm src;
+    if (i.src1.is_constant) {
+      src = i.dest;
+      e.LoadConstantXmm(src, i.src1.constant());
+    } else {
+      src = i.src1;
+    }
     if (e.IsFeatureEnabled(kX64EmitF16C)) {
-      Xmm src;
-      if (i.src1.is_constant) {
-        src = i.dest;
-        e.LoadConstantXmm(src, i.src1.constant());
-      } else {
-        src = i.src1;
-      }
       // 0|0|0|0|W|Z|Y|X
       e.vcvtps2ph(i.dest, src, 0b00000011);
-      // Shuffle to X|Y|0|0|0|0|0|0
-      e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMPackFLOAT16_2));
     } else {
-      if (i.src1.is_constant) {
-        e.lea(e.GetNativeParam(0), e.StashConstantXmm(0, i.src1.constant()));
-      } else {
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-      }
-      e.CallNativeSafe(reinterpret_cast<void*>(EmulateFLOAT16_2));
-      e.vmovaps(i.dest, e.xmm0);
+      EmitFloatToHalf(e, i.dest, src);
     }
-  }
-  static __m128i EmulateFLOAT16_4(void*, __m128 src1) {
-    alignas(16) float a[4];
-    alignas(16) uint16_t b[8];
-    _mm_store_ps(a, src1);
-    std::memset(b, 0, sizeof(b));
-
-    for (int i = 0; i < 4; i++) {
-      b[7 - (i ^ 2)] =
-          half_float::detail::float2half<std::round_toward_zero>(a[i]);
-    }
-
-    return _mm_load_si128(reinterpret_cast<__m128i*>(b));
+    // Shuffle to X|Y|0|0|0|0|0|0
+    e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMPackFLOAT16_2));
   }
   static void EmitFLOAT16_4(X64Emitter& e, const EmitArgType& i) {
     assert_true(i.src2.value->IsConstantZero());
     // dest = [(src1.z | src1.w), (src1.x | src1.y), 0, 0]
 
+    Xmm src;
+    if (i.src1.is_constant) {
+      src = i.dest;
+      e.LoadConstantXmm(src, i.src1.constant());
+    } else {
+      src = i.src1;
+    }
     if (e.IsFeatureEnabled(kX64EmitF16C)) {
-      Xmm src;
-      if (i.src1.is_constant) {
-        src = i.dest;
-        e.LoadConstantXmm(src, i.src1.constant());
-      } else {
-        src = i.src1;
-      }
       // 0|0|0|0|W|Z|Y|X
       e.vcvtps2ph(i.dest, src, 0b00000011);
-      // Shuffle to Z|W|X|Y|0|0|0|0
-      e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMPackFLOAT16_4));
     } else {
-      if (i.src1.is_constant) {
-        e.lea(e.GetNativeParam(0), e.StashConstantXmm(0, i.src1.constant()));
-      } else {
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-      }
-      e.CallNativeSafe(reinterpret_cast<void*>(EmulateFLOAT16_4));
-      e.vmovaps(i.dest, e.xmm0);
+      EmitFloatToHalf(e, i.dest, src);
     }
+    // Shuffle to Z|W|X|Y|0|0|0|0
+    e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMPackFLOAT16_4));
   }
   static void EmitSHORT_2(X64Emitter& e, const EmitArgType& i) {
     assert_true(i.src2.value->IsConstantZero());
@@ -2021,56 +2099,31 @@ struct PACK : Sequence<PACK, I<OPCODE_PACK, V128Op, V128Op, V128Op>> {
     // Merge XZ and YW.
     e.vorps(i.dest, e.xmm0);
   }
-  static __m128i EmulatePack8_IN_16_UN_UN_SAT(void*, __m128i src1,
-                                              __m128i src2) {
-    alignas(16) uint16_t a[8];
-    alignas(16) uint16_t b[8];
-    alignas(16) uint8_t c[16];
-    _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
-    _mm_store_si128(reinterpret_cast<__m128i*>(b), src2);
-    for (int i = 0; i < 8; ++i) {
-      c[i] = uint8_t(std::max(uint16_t(0), std::min(uint16_t(255), a[i])));
-      c[i + 8] = uint8_t(std::max(uint16_t(0), std::min(uint16_t(255), b[i])));
-    }
-    return _mm_load_si128(reinterpret_cast<__m128i*>(c));
-  }
-  static __m128i EmulatePack8_IN_16_UN_UN(void*, __m128i src1, __m128i src2) {
-    alignas(16) uint8_t a[16];
-    alignas(16) uint8_t b[16];
-    alignas(16) uint8_t c[16];
-    _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
-    _mm_store_si128(reinterpret_cast<__m128i*>(b), src2);
-    for (int i = 0; i < 8; ++i) {
-      c[i] = a[i * 2];
-      c[i + 8] = b[i * 2];
-    }
-    return _mm_load_si128(reinterpret_cast<__m128i*>(c));
-  }
   static void Emit8_IN_16(X64Emitter& e, const EmitArgType& i, uint32_t flags) {
     // TODO(benvanik): handle src2 (or src1) being constant zero
     if (IsPackInUnsigned(flags)) {
       if (IsPackOutUnsigned(flags)) {
+        Xbyak::Xmm src1 = i.src1.is_constant ? e.xmm0 : i.src1;
+        if (i.src1.is_constant) {
+          e.LoadConstantXmm(src1, i.src1.constant());
+        }
+        Xbyak::Xmm src2 = i.src2.is_constant ? e.xmm1 : i.src2;
+        if (i.src2.is_constant) {
+          e.LoadConstantXmm(src2, i.src2.constant());
+        }
         if (IsPackOutSaturate(flags)) {
           // unsigned -> unsigned + saturate
-          if (i.src2.is_constant) {
-            e.lea(e.GetNativeParam(1),
-                  e.StashConstantXmm(1, i.src2.constant()));
-          } else {
-            e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-          }
-          e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-          e.CallNativeSafe(
-              reinterpret_cast<void*>(EmulatePack8_IN_16_UN_UN_SAT));
-          e.vmovaps(i.dest, e.xmm0);
-          e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMByteOrderMask));
+          // Clamp first, vpackuswb would treat words above 0x7FFF as
+          // negative.
+          e.vpminuw(e.xmm0, src1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+          e.vpminuw(e.xmm1, src2, e.GetXmmConstPtr(XMMLowByteMaskI16));
         } else {
           // unsigned -> unsigned
-          e.lea(e.GetNativeParam(1), e.StashXmm(1, i.src2));
-          e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-          e.CallNativeSafe(reinterpret_cast<void*>(EmulatePack8_IN_16_UN_UN));
-          e.vmovaps(i.dest, e.xmm0);
-          e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMByteOrderMask));
+          e.vpand(e.xmm0, src1, e.GetXmmConstPtr(XMMLowByteMaskI16));
+          e.vpand(e.xmm1, src2, e.GetXmmConstPtr(XMMLowByteMaskI16));
         }
+        e.vpackuswb(i.dest, e.xmm0, e.xmm1);
+        e.vpshufb(i.dest, i.dest, e.GetXmmConstPtr(XMMByteOrderMask));
       } else {
         if (IsPackOutSaturate(flags)) {
           // unsigned -> signed + saturate
@@ -2267,95 +2320,72 @@ struct UNPACK : Sequence<UNPACK, I<OPCODE_UNPACK, V128Op, V128Op>> {
     e.vpor(i.dest, e.GetXmmConstPtr(XMMOne));
     // To convert to 0 to 1, games multiply by 0x47008081 and add 0xC7008081.
   }
-  static __m128 EmulateFLOAT16_2(void*, __m128i src1) {
-    alignas(16) uint16_t a[8];
-    alignas(16) float b[4];
-    _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
-
-    for (int i = 0; i < 2; i++) {
-      b[i] = half_float::detail::half2float(a[VEC128_W(6 + i)]);
-    }
-
-    // Constants, or something
-    b[2] = 0.f;
-    b[3] = 1.f;
-
-    return _mm_load_ps(b);
+  // Converts the halves in the low words of the dwords of src to floats like
+  // vcvtph2ps, for hosts without F16C.
+  // http://fgiesen.wordpress.com/2012/03/28/half-to-float-done-quic/
+  static void EmitHalfToFloat(X64Emitter& e, Xmm dest, Xmm src) {
+    e.vpand(e.xmm0, src, e.GetXmmConstPtr(XMMUnpackFLOAT16_AbsMask));
+    e.vpxor(e.xmm1, src, e.xmm0);
+    // Rebias the exponent with a multiplication, which also normalizes
+    // denormals.
+    e.vpslld(e.xmm2, e.xmm0, 13);
+    e.vmulps(e.xmm2, e.GetXmmConstPtr(XMMUnpackFLOAT16_Scale));
+    // Infinity and NaN need the maximum exponent.
+    e.vpcmpgtd(e.xmm0, e.xmm0, e.GetXmmConstPtr(XMMPackFLOAT16_Max));
+    e.vpand(e.xmm0, e.GetXmmConstPtr(XMMUnpackFLOAT16_InfNaN));
+    e.vpslld(e.xmm1, e.xmm1, 16);
+    e.vpor(e.xmm0, e.xmm1);
+    e.vpor(dest, e.xmm2, e.xmm0);
   }
   static void EmitFLOAT16_2(X64Emitter& e, const EmitArgType& i) {
     // 1 bit sign, 5 bit exponent, 10 bit mantissa
     // D3D10 half float format
-    // TODO(benvanik):
     // http://blogs.msdn.com/b/chuckw/archive/2012/09/11/directxmath-f16c-and-fma.aspx
-    // Use _mm_cvtph_ps -- requires very modern processors (SSE5+)
-    // Unpacking half floats:
-    // http://fgiesen.wordpress.com/2012/03/28/half-to-float-done-quic/
     // Packing half floats: https://gist.github.com/rygorous/2156668
     // Load source, move from tight pack of X16Y16.... to X16...Y16...
     // Also zero out the high end.
     // TODO(benvanik): special case constant unpacks that just get 0/1/etc.
 
+    Xmm src;
+    if (i.src1.is_constant) {
+      src = i.dest;
+      e.LoadConstantXmm(src, i.src1.constant());
+    } else {
+      src = i.src1;
+    }
+    // sx = src.iw >> 16;
+    // sy = src.iw & 0xFFFF;
+    // dest = { XMConvertHalfToFloat(sx),
+    //          XMConvertHalfToFloat(sy),
+    //          0.0,
+    //          1.0 };
+    // Shuffle to 0|0|0|0|0|0|Y|X
+    e.vpshufb(i.dest, src, e.GetXmmConstPtr(XMMUnpackFLOAT16_2));
     if (e.IsFeatureEnabled(kX64EmitF16C)) {
-      Xmm src;
-      if (i.src1.is_constant) {
-        src = i.dest;
-        e.LoadConstantXmm(src, i.src1.constant());
-      } else {
-        src = i.src1;
-      }
-      // sx = src.iw >> 16;
-      // sy = src.iw & 0xFFFF;
-      // dest = { XMConvertHalfToFloat(sx),
-      //          XMConvertHalfToFloat(sy),
-      //          0.0,
-      //          1.0 };
-      // Shuffle to 0|0|0|0|0|0|Y|X
-      e.vpshufb(i.dest, src, e.GetXmmConstPtr(XMMUnpackFLOAT16_2));
       e.vcvtph2ps(i.dest, i.dest);
-      e.vpshufd(i.dest, i.dest, 0b10100100);
-      e.vpor(i.dest, e.GetXmmConstPtr(XMM0001));
     } else {
-      if (i.src1.is_constant) {
-        e.lea(e.GetNativeParam(0), e.StashConstantXmm(0, i.src1.constant()));
-      } else {
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-      }
-      e.CallNativeSafe(reinterpret_cast<void*>(EmulateFLOAT16_2));
-      e.vmovaps(i.dest, e.xmm0);
+      e.vpmovzxwd(i.dest, i.dest);
+      EmitHalfToFloat(e, i.dest, i.dest);
     }
-  }
-  static __m128 EmulateFLOAT16_4(void*, __m128i src1) {
-    alignas(16) uint16_t a[8];
-    alignas(16) float b[4];
-    _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
-
-    for (int i = 0; i < 4; i++) {
-      b[i] = half_float::detail::half2float(a[VEC128_W(4 + i)]);
-    }
-
-    return _mm_load_ps(b);
+    e.vpshufd(i.dest, i.dest, 0b10100100);
+    e.vpor(i.dest, e.GetXmmConstPtr(XMM0001));
   }
   static void EmitFLOAT16_4(X64Emitter& e, const EmitArgType& i) {
     // src = [(dest.x | dest.y), (dest.z | dest.w), 0, 0]
+    Xmm src;
+    if (i.src1.is_constant) {
+      src = i.dest;
+      e.LoadConstantXmm(src, i.src1.constant());
+    } else {
+      src = i.src1;
+    }
+    // Shuffle to 0|0|0|0|W|Z|Y|X
+    e.vpshufb(i.dest, src, e.GetXmmConstPtr(XMMUnpackFLOAT16_4));
     if (e.IsFeatureEnabled(kX64EmitF16C)) {
-      Xmm src;
-      if (i.src1.is_constant) {
-        src = i.dest;
-        e.LoadConstantXmm(src, i.src1.constant());
-      } else {
-        src = i.src1;
-      }
-      // Shuffle to 0|0|0|0|W|Z|Y|X
-      e.vpshufb(i.dest, src, e.GetXmmConstPtr(XMMUnpackFLOAT16_4));
       e.vcvtph2ps(i.dest, i.dest);
     } else {
-      if (i.src1.is_constant) {
-        e.lea(e.GetNativeParam(0), e.StashConstantXmm(0, i.src1.constant()));
-      } else {
-        e.lea(e.GetNativeParam(0), e.StashXmm(0, i.src1));
-      }
-      e.CallNativeSafe(reinterpret_cast<void*>(EmulateFLOAT16_4));
-      e.vmovaps(i.dest, e.xmm0);
+      e.vpmovzxwd(i.dest, i.dest);
+      EmitHalfToFloat(e, i.dest, i.dest);
     }
   }
   static void EmitSHORT_2(X64Emitter& e, const EmitArgType& i) {
@@ -64,6 +64,7 @@ struct COMMENT : Sequence<COMMENT, I<OPCODE_COMMENT, VoidOp, OffsetOp>> {
       // TODO(benvanik): pass through.
       // TODO(benvanik): don't just leak this memory.
       auto str_copy = strdup(str);
+      e.MarkNotStorable();
       e.mov(e.rdx, reinterpret_cast<uint64_t>(str_copy));
       e.CallNative(reinterpret_cast<void*>(TraceString));
     }
@@ -489,26 +490,26 @@ EMITTER_OPCODE_TABLE(OPCODE_CONTEXT_BARRIER, CONTEXT_BARRIER);
 // ============================================================================
 struct MAX_F32 : Sequence<MAX_F32, I<OPCODE_MAX, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmaxss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmaxss(dest, src1, src2);
+        });
   }
 };
 struct MAX_F64 : Sequence<MAX_F64, I<OPCODE_MAX, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmaxsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmaxsd(dest, src1, src2);
+        });
   }
 };
 struct MAX_V128 : Sequence<MAX_V128, I<OPCODE_MAX, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmaxps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmaxps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_MAX, MAX_F32, MAX_F64, MAX_V128);
@@ -578,26 +579,26 @@ struct MIN_I64 : Sequence<MIN_I64, I<OPCODE_MIN, I64Op, I64Op, I64Op>> {
 };
 struct MIN_F32 : Sequence<MIN_F32, I<OPCODE_MIN, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vminss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vminss(dest, src1, src2);
+        });
   }
 };
 struct MIN_F64 : Sequence<MIN_F64, I<OPCODE_MIN, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vminsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vminsd(dest, src1, src2);
+        });
   }
 };
 struct MIN_V128 : Sequence<MIN_V128, I<OPCODE_MIN, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vminps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vminps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_MIN, MIN_I8, MIN_I16, MIN_I32, MIN_I64, MIN_F32,
@@ -1180,26 +1181,26 @@ struct ADD_I64 : Sequence<ADD_I64, I<OPCODE_ADD, I64Op, I64Op, I64Op>> {
 };
 struct ADD_F32 : Sequence<ADD_F32, I<OPCODE_ADD, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vaddss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vaddss(dest, src1, src2);
+        });
   }
 };
 struct ADD_F64 : Sequence<ADD_F64, I<OPCODE_ADD, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vaddsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vaddsd(dest, src1, src2);
+        });
   }
 };
 struct ADD_V128 : Sequence<ADD_V128, I<OPCODE_ADD, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vaddps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vaddps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_ADD, ADD_I8, ADD_I16, ADD_I32, ADD_I64, ADD_F32,
@@ -1303,28 +1304,28 @@ struct SUB_I64 : Sequence<SUB_I64, I<OPCODE_SUB, I64Op, I64Op, I64Op>> {
 struct SUB_F32 : Sequence<SUB_F32, I<OPCODE_SUB, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vsubss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vsubss(dest, src1, src2);
+        });
   }
 };
 struct SUB_F64 : Sequence<SUB_F64, I<OPCODE_SUB, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vsubsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vsubsd(dest, src1, src2);
+        });
   }
 };
 struct SUB_V128 : Sequence<SUB_V128, I<OPCODE_SUB, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vsubps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vsubps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_SUB, SUB_I8, SUB_I16, SUB_I32, SUB_I64, SUB_F32,
@@ -1503,28 +1504,28 @@ struct MUL_I64 : Sequence<MUL_I64, I<OPCODE_MUL, I64Op, I64Op, I64Op>> {
 struct MUL_F32 : Sequence<MUL_F32, I<OPCODE_MUL, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmulss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmulss(dest, src1, src2);
+        });
   }
 };
 struct MUL_F64 : Sequence<MUL_F64, I<OPCODE_MUL, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmulsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmulsd(dest, src1, src2);
+        });
   }
 };
 struct MUL_V128 : Sequence<MUL_V128, I<OPCODE_MUL, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vmulps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vmulps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_MUL, MUL_I8, MUL_I16, MUL_I32, MUL_I64, MUL_F32,
@@ -1913,28 +1914,28 @@ struct DIV_I64 : Sequence<DIV_I64, I<OPCODE_DIV, I64Op, I64Op, I64Op>> {
 struct DIV_F32 : Sequence<DIV_F32, I<OPCODE_DIV, F32Op, F32Op, F32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vdivss(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vdivss(dest, src1, src2);
+        });
   }
 };
 struct DIV_F64 : Sequence<DIV_F64, I<OPCODE_DIV, F64Op, F64Op, F64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vdivsd(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vdivsd(dest, src1, src2);
+        });
   }
 };
 struct DIV_V128 : Sequence<DIV_V128, I<OPCODE_DIV, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     assert_true(!i.instr->flags);
-    EmitAssociativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vdivps(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vdivps(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_DIV, DIV_I8, DIV_I16, DIV_I32, DIV_I64, DIV_F32,
@@ -2607,10 +2608,10 @@ struct AND_I64 : Sequence<AND_I64, I<OPCODE_AND, I64Op, I64Op, I64Op>> {
 };
 struct AND_V128 : Sequence<AND_V128, I<OPCODE_AND, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vpand(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vpand(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_AND, AND_I8, AND_I16, AND_I32, AND_I64, AND_V128);
@@ -2652,10 +2653,10 @@ struct OR_I64 : Sequence<OR_I64, I<OPCODE_OR, I64Op, I64Op, I64Op>> {
 };
 struct OR_V128 : Sequence<OR_V128, I<OPCODE_OR, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vpor(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vpor(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_OR, OR_I8, OR_I16, OR_I32, OR_I64, OR_V128);
@@ -2697,10 +2698,10 @@ struct XOR_I64 : Sequence<XOR_I64, I<OPCODE_XOR, I64Op, I64Op, I64Op>> {
 };
 struct XOR_V128 : Sequence<XOR_V128, I<OPCODE_XOR, V128Op, V128Op, V128Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeBinaryXmmOp(e, i,
-                               [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-                                 e.vpxor(dest, src1, src2);
-                               });
+    EmitBinaryXmmMemOp(
+        e, i, [](X64Emitter& e, Xmm dest, Xmm src1, const Operand& src2) {
+          e.vpxor(dest, src1, src2);
+        });
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_XOR, XOR_I8, XOR_I16, XOR_I32, XOR_I64, XOR_V128);
@@ -3138,7 +3139,7 @@ struct SET_ROUNDING_MODE_I32
   static void Emit(X64Emitter& e, const EmitArgType& i) {
     e.mov(e.rcx, i.src1);
     e.and_(e.rcx, 0x7);
-    e.mov(e.rax, uintptr_t(mxcsr_table));
+    e.MovHostImageAddress(e.rax, mxcsr_table);
     e.vldmxcsr(e.ptr[e.rax + e.rcx * 4]);
   }
 };
@@ -0,0 +1,229 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/background_compiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "xenia/base/clock.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
+#include "xenia/cpu/function.h"
+#include "xenia/cpu/ppc/ppc_frontend.h"
+#include "xenia/cpu/ppc/ppc_scanner.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/cpu/xex_module.h"
+
+DEFINE_bool(background_compilation, false,
+            "Compile guest functions on background threads before they are "
+            "first called.",
+            "CPU");
+DEFINE_int32(background_compilation_threads, 0,
+             "Number of background compilation threads (0 to use half of the "
+             "logical processors).",
+             "CPU");
+
+namespace xe {
+namespace cpu {
+
+thread_local bool is_background_compiler_thread_ = false;
+
+BackgroundCompiler::BackgroundCompiler(Processor* processor)
+    : processor_(processor) {}
+
+BackgroundCompiler::~BackgroundCompiler() { Shutdown(); }
+
+bool BackgroundCompiler::IsWorkerThread() {
+  return is_background_compiler_thread_;
+}
+
+void BackgroundCompiler::Start(XexModule* module, uint32_t entry_point) {
+  Shutdown();
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    module_ = module;
+    scanner_ = std::make_shared<ppc::PPCScanner>(processor_->frontend());
+    shutdown_ = false;
+    next_sequence_ = 0;
+    active_count_ = 0;
+    start_time_ms_ = Clock::QueryHostUptimeMillis();
+    drained_ = false;
+  }
+
+  // Things the game will run first.
+  if (entry_point) {
+    Enqueue(entry_point, kPriorityEntryPoint);
+  }
+
+  // Everything else we know about.
+  std::vector<uint32_t> addresses = module->GetExceptionTableFunctions();
+  module->ForEachFunction([&addresses](Function* function) {
+    if (function->is_guest() &&
+        function->behavior() != Function::Behavior::kExtern) {
+      addresses.push_back(function->address());
+    }
+  });
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+                  addresses.end());
+  for (uint32_t address : addresses) {
+    Enqueue(address, kPriorityKnown);
+  }
+  XELOGI("Background compilation of %zu known functions started",
+         addresses.size());
+
+  uint32_t thread_count =
+      uint32_t(std::max(0, cvars::background_compilation_threads));
+  if (!thread_count) {
+    thread_count = std::max(xe::threading::logical_processor_count() / 2, 1u);
+  }
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    auto thread =
+        xe::threading::Thread::Create({}, [this]() { WorkerThread(); });
+    thread->set_name("Background Compilation");
+    thread->set_priority(xe::threading::ThreadPriority::kBelowNormal);
+    worker_threads_.push_back(std::move(thread));
+  }
+}
+
+void BackgroundCompiler::Shutdown() {
+  // Guest threads may still be running and calling OnFunctionDemanded, they
+  // stop queuing once this is set.
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    shutdown_ = true;
+  }
+  if (!worker_threads_.empty()) {
+    queue_cond_.notify_all();
+    for (auto& thread : worker_threads_) {
+      xe::threading::Wait(thread.get(), false);
+    }
+    worker_threads_.clear();
+    XELOGI("Background compilation stopped: %u functions compiled, %u failed",
+           compiled_count_.load(), failed_count_.load());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_ = std::priority_queue<WorkItem>();
+    queued_priorities_.clear();
+    scanner_.reset();
+    module_ = nullptr;
+  }
+  compiled_count_ = 0;
+  failed_count_ = 0;
+}
+
+void BackgroundCompiler::OnFunctionDemanded(Function* function) {
+  if (!function->is_guest()) {
+    return;
+  }
+  // The guest is executing this function right now, so its callees are what
+  // it's most likely to need next.
+  EnqueueCallees(function, 1);
+}
+
+void BackgroundCompiler::Enqueue(uint32_t address, uint32_t priority) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (shutdown_ || !module_->ContainsAddress(address)) {
+      return;
+    }
+    auto it = queued_priorities_.find(address);
+    if (it != queued_priorities_.end()) {
+      if (it->second <= priority) {
+        return;
+      }
+      // Queued again with a better priority - the old item will be skipped.
+      it->second = priority;
+    } else {
+      queued_priorities_.emplace(address, priority);
+    }
+    queue_.push({priority, next_sequence_++, address});
+  }
+  queue_cond_.notify_one();
+}
+
+void BackgroundCompiler::EnqueueCallees(Function* function,
+                                        uint32_t priority) {
+  std::shared_ptr<ppc::PPCScanner> scanner;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (shutdown_) {
+      return;
+    }
+    scanner = scanner_;
+  }
+  auto callees =
+      scanner->FindCallTargets(static_cast<GuestFunction*>(function));
+  for (uint32_t callee : callees) {
+    if (!processor_->QueryFunction(callee)) {
+      Enqueue(callee, priority);
+    }
+  }
+}
+
+void BackgroundCompiler::WorkerThread() {
+  is_background_compiler_thread_ = true;
+  while (true) {
+    WorkItem item;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cond_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+      if (shutdown_) {
+        break;
+      }
+      item = queue_.top();
+      queue_.pop();
+      ++active_count_;
+    }
+
+    // Already compiled by a guest thread or another worker.
+    if (!processor_->QueryFunction(item.address)) {
+      SCOPE_profile_cpu_i("cpu", "BackgroundCompiler::Compile");
+      Function* function = processor_->ResolveFunction(item.address);
+      if (function) {
+        ++compiled_count_;
+        // Known functions are all queued anyway, only follow calls from the
+        // hot path.
+        if (item.priority < kPriorityKnown - 1) {
+          EnqueueCallees(function, item.priority + 1);
+        }
+      } else {
+        ++failed_count_;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      OnItemDone();
+    }
+  }
+  is_background_compiler_thread_ = false;
+}
+
+void BackgroundCompiler::OnItemDone() {
+  --active_count_;
+  if (drained_ || active_count_ || !queue_.empty()) {
+    return;
+  }
+  drained_ = true;
+  uint64_t elapsed_ms = Clock::QueryHostUptimeMillis() - start_time_ms_;
+  uint32_t compiled_count = compiled_count_.load();
+  XELOGI("Background compilation drained: %u functions compiled, %u failed, "
+         "in %" PRIu64 "ms (%.1f functions/s)",
+         compiled_count, failed_count_.load(), elapsed_ms,
+         elapsed_ms ? compiled_count * 1000.0 / elapsed_ms : 0.0);
+}
+
+}  // namespace cpu
+}  // namespace xe
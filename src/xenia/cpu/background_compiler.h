@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_BACKGROUND_COMPILER_H_
+#define XENIA_CPU_BACKGROUND_COMPILER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/base/threading.h"
+
+namespace xe {
+namespace cpu {
+
+class Function;
+class Processor;
+class XexModule;
+
+namespace ppc {
+class PPCScanner;
+}  // namespace ppc
+
+// Compiles guest functions of a module on worker threads before they are
+// first called, so guest threads don't stall in the translator.
+//
+// Functions are prioritized by how soon they are likely to run: the callees of
+// functions compiled on demand by guest threads come first (closest callees
+// first), followed by the entry point and its callees, then every function
+// known from the module symbols and exception table in address order.
+// Compiled functions are published through Processor::ResolveFunction, so
+// guest threads requesting a function that is being compiled in the
+// background just wait for it like for any other thread.
+class BackgroundCompiler {
+ public:
+  explicit BackgroundCompiler(Processor* processor);
+  ~BackgroundCompiler();
+
+  // Queues all known functions of the module and starts the workers.
+  void Start(XexModule* module, uint32_t entry_point);
+  // Cancels all pending work and waits for the functions currently being
+  // compiled.
+  void Shutdown();
+
+  // Called after a function has been compiled on demand by a guest thread.
+  void OnFunctionDemanded(Function* function);
+
+  // True on the worker threads.
+  static bool IsWorkerThread();
+
+ private:
+  struct WorkItem {
+    // Lower is sooner.
+    uint32_t priority;
+    uint32_t sequence;
+    uint32_t address;
+    bool operator<(const WorkItem& other) const {
+      // std::priority_queue returns the largest.
+      if (priority != other.priority) {
+        return priority > other.priority;
+      }
+      return sequence > other.sequence;
+    }
+  };
+  // Distance from a function being executed.
+  static const uint32_t kPriorityEntryPoint = 16;
+  static const uint32_t kPriorityKnown = 0xFFFFFFFF;
+
+  void Enqueue(uint32_t address, uint32_t priority);
+  void EnqueueCallees(Function* function, uint32_t priority);
+  void WorkerThread();
+  // Called with the queue lock held when a worker is done with an item.
+  void OnItemDone();
+
+  Processor* processor_ = nullptr;
+
+  // Guards everything below up to active_count_, including the module and
+  // the scanner, which guest threads reach through OnFunctionDemanded while
+  // Shutdown releases them.
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  XexModule* module_ = nullptr;
+  // Referenced outside the lock while scanning, so kept alive by the scan.
+  std::shared_ptr<ppc::PPCScanner> scanner_;
+  std::priority_queue<WorkItem> queue_;
+  // Best priority each address has been queued with.
+  std::unordered_map<uint32_t, uint32_t> queued_priorities_;
+  uint32_t next_sequence_ = 0;
+  // Set until Start and from Shutdown on.
+  bool shutdown_ = true;
+  // Items popped but not done yet.
+  uint32_t active_count_ = 0;
+  // Logged once when everything queued on Start has been compiled, so that
+  // translation speed can be compared between builds on the same title.
+  uint64_t start_time_ms_ = 0;
+  bool drained_ = false;
+
+  std::vector<std::unique_ptr<xe::threading::Thread>> worker_threads_;
+
+  std::atomic<uint32_t> compiled_count_ = {0};
+  std::atomic<uint32_t> failed_count_ = {0};
+};
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_BACKGROUND_COMPILER_H_
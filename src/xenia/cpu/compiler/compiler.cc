@@ -9,8 +9,10 @@
 
 #include "xenia/cpu/compiler/compiler.h"
 
+#include "xenia/base/clock.h"
 #include "xenia/base/profiling.h"
 #include "xenia/cpu/compiler/compiler_pass.h"
+#include "xenia/cpu/compiler/compiler_stats.h"
 
 namespace xe {
 namespace cpu {
@@ -18,7 +20,20 @@ namespace compiler {
 
 Compiler::Compiler(Processor* processor) : processor_(processor) {}
 
-Compiler::~Compiler() { Reset(); }
+Compiler::~Compiler() {
+  Reset();
+
+  if (stats_) {
+    std::vector<CompilerPass::Counter> counters;
+    for (auto& pass : passes_) {
+      counters.clear();
+      pass->GetCounters(&counters);
+      if (!counters.empty()) {
+        stats_->AddCounters(pass->name(), counters);
+      }
+    }
+  }
+}
 
 void Compiler::AddPass(std::unique_ptr<CompilerPass> pass) {
   pass->Initialize(this);
@@ -30,10 +45,24 @@ void Compiler::Reset() {}
 bool Compiler::Compile(xe::cpu::hir::HIRBuilder* builder) {
   // TODO(benvanik): sophisticated stuff. Run passes in parallel, run until they
   //                 stop changing things, etc.
+  pass_runs_.clear();
   for (size_t i = 0; i < passes_.size(); ++i) {
     auto& pass = passes_[i];
     scratch_arena_.Reset();
-    if (!pass->Run(builder)) {
+    if (!stats_) {
+      if (!pass->Run(builder)) {
+        return false;
+      }
+      continue;
+    }
+    size_t start_size = builder->arena()->CalculateSize();
+    uint64_t start_ticks = Clock::QueryHostTickCount();
+    bool succeeded = pass->Run(builder);
+    uint64_t ticks = Clock::QueryHostTickCount() - start_ticks;
+    size_t allocated_size = builder->arena()->CalculateSize() - start_size +
+                            scratch_arena_.CalculateSize();
+    pass_runs_.push_back({pass->name(), ticks, allocated_size});
+    if (!succeeded) {
       return false;
     }
   }
@@ -27,6 +27,7 @@ namespace cpu {
 namespace compiler {
 
 class CompilerPass;
+class CompilerStats;
 
 class Compiler {
  public:
@@ -38,6 +39,19 @@ class Compiler {
 
   void AddPass(std::unique_ptr<CompilerPass> pass);
 
+  // Enables collection of pass_runs, pass counters are reported to stats on
+  // destruction.
+  void set_stats(CompilerStats* stats) { stats_ = stats; }
+
+  struct PassRun {
+    const char* name;
+    uint64_t ticks;
+    // HIR and scratch arena bytes allocated by the pass.
+    uint64_t allocated_bytes;
+  };
+  // Passes run by the last Compile, if stats are enabled.
+  const std::vector<PassRun>& pass_runs() const { return pass_runs_; }
+
   void Reset();
 
   bool Compile(hir::HIRBuilder* builder);
@@ -47,6 +61,9 @@ class Compiler {
   Arena scratch_arena_;
 
   std::vector<std::unique_ptr<CompilerPass>> passes_;
+
+  CompilerStats* stats_ = nullptr;
+  std::vector<PassRun> pass_runs_;
 };
 
 }  // namespace compiler
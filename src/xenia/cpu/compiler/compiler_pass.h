@@ -10,6 +10,9 @@
 #ifndef XENIA_CPU_COMPILER_COMPILER_PASS_H_
 #define XENIA_CPU_COMPILER_COMPILER_PASS_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "xenia/base/arena.h"
 #include "xenia/cpu/hir/hir_builder.h"
 
@@ -32,8 +35,19 @@ class CompilerPass {
 
   virtual bool Initialize(Compiler* compiler);
 
+  // Used in compiler pass statistics.
+  virtual const char* name() const = 0;
+
   virtual bool Run(hir::HIRBuilder* builder) = 0;
 
+  // Pass-specific totals, such as the number of spills, reported along with
+  // the pass times.
+  struct Counter {
+    const char* name;
+    uint64_t value;
+  };
+  virtual void GetCounters(std::vector<Counter>* counters) const {}
+
  protected:
   Arena* scratch_arena() const;
 
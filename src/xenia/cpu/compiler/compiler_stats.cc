@@ -0,0 +1,279 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/compiler_stats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#include "xenia/base/clock.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+
+CompilerStats::CompilerStats()
+    : tick_frequency_(Clock::QueryHostTickFrequency()) {}
+
+CompilerStats::~CompilerStats() = default;
+
+void CompilerStats::AddFunction(
+    const FunctionStats& function,
+    const std::vector<Compiler::PassRun>& pass_runs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  functions_.push_back(function);
+  for (auto& pass_run : pass_runs) {
+    auto& totals = GetPassTotals(pass_run.name);
+    ++totals.run_count;
+    totals.ticks += pass_run.ticks;
+    totals.allocated_bytes += pass_run.allocated_bytes;
+  }
+}
+
+void CompilerStats::AddCounters(
+    const char* pass_name, const std::vector<CompilerPass::Counter>& counters) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& totals = GetPassTotals(pass_name);
+  for (auto& counter : counters) {
+    bool found = false;
+    for (auto& total_counter : totals.counters) {
+      if (!std::strcmp(total_counter.name, counter.name)) {
+        total_counter.value += counter.value;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      totals.counters.push_back(counter);
+    }
+  }
+}
+
+void CompilerStats::AddIndirectCallSites(
+    const std::vector<IndirectCallSiteStats>& sites) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  indirect_call_sites_.insert(indirect_call_sites_.end(), sites.begin(),
+                              sites.end());
+}
+
+CompilerStats::PassTotals& CompilerStats::GetPassTotals(const char* name) {
+  // Pipelines are short, and passes that appear more than once (validation,
+  // simplification) are merged by name.
+  for (auto& totals : passes_) {
+    if (!std::strcmp(totals.name, name)) {
+      return totals;
+    }
+  }
+  passes_.emplace_back();
+  passes_.back().name = name;
+  return passes_.back();
+}
+
+void CompilerStats::Histogram::Add(uint64_t value) {
+  size_t bucket = value ? 64 - xe::lzcnt(value) : 0;
+  ++buckets[bucket];
+  bucket_count = std::max(bucket_count, bucket + 1);
+}
+
+std::vector<CompilerStats::Histogram> CompilerStats::BuildHistograms() const {
+  std::vector<Histogram> histograms(5);
+  histograms[0].name = "guest_instr_count";
+  histograms[1].name = "hir_instr_count";
+  histograms[2].name = "hir_value_count";
+  histograms[3].name = "code_size";
+  histograms[4].name = "translation_us";
+  for (auto& function : functions_) {
+    histograms[0].Add(function.guest_instr_count);
+    histograms[1].Add(function.hir_instr_count);
+    histograms[2].Add(function.hir_value_count);
+    histograms[3].Add(function.code_size);
+    histograms[4].Add(TicksToMicroseconds(function.ticks));
+  }
+  return histograms;
+}
+
+uint64_t CompilerStats::TicksToMicroseconds(uint64_t ticks) const {
+  return uint64_t(ticks * 1000000.0 / tick_frequency_);
+}
+
+void CompilerStats::Dump() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (functions_.empty()) {
+    return;
+  }
+
+  uint64_t total_ticks = 0;
+  uint64_t total_guest_instrs = 0;
+  uint64_t total_hir_instrs = 0;
+  uint64_t total_code_size = 0;
+  uint64_t total_inlined_calls = 0;
+  for (auto& function : functions_) {
+    total_ticks += function.ticks;
+    total_guest_instrs += function.guest_instr_count;
+    total_hir_instrs += function.hir_instr_count;
+    total_code_size += function.code_size;
+    total_inlined_calls += function.inlined_call_count;
+  }
+  XELOGI("JIT stats: %zu functions translated in %.3fms", functions_.size(),
+         TicksToMicroseconds(total_ticks) / 1000.0);
+  XELOGI("  %" PRIu64 " guest instructions, %" PRIu64
+         " HIR instructions, %" PRIu64 " bytes of code",
+         total_guest_instrs, total_hir_instrs, total_code_size);
+  XELOGI("  %" PRIu64 " guest calls inlined", total_inlined_calls);
+
+  uint32_t tier_counts[2] = {0, 0};
+  uint64_t tier_ticks[2] = {0, 0};
+  uint32_t promoted_count = 0;
+  for (auto& function : functions_) {
+    ++tier_counts[function.baseline ? 0 : 1];
+    tier_ticks[function.baseline ? 0 : 1] += function.ticks;
+    promoted_count += function.promoted ? 1 : 0;
+  }
+  if (tier_counts[0]) {
+    XELOGI("  baseline tier: %u functions in %.3fms", tier_counts[0],
+           TicksToMicroseconds(tier_ticks[0]) / 1000.0);
+    XELOGI("  optimized tier: %u functions in %.3fms, %u promoted from "
+           "baseline",
+           tier_counts[1], TicksToMicroseconds(tier_ticks[1]) / 1000.0,
+           promoted_count);
+  }
+
+  XELOGI("  %-28s %8s %12s %10s %14s", "pass", "runs", "total ms", "us/run",
+         "alloc bytes");
+  for (auto& totals : passes_) {
+    if (totals.run_count) {
+      double total_us = double(TicksToMicroseconds(totals.ticks));
+      XELOGI("  %-28s %8" PRIu64 " %12.3f %10.3f %14" PRIu64, totals.name,
+             totals.run_count, total_us / 1000.0, total_us / totals.run_count,
+             totals.allocated_bytes);
+    } else {
+      XELOGI("  %-28s", totals.name);
+    }
+    for (auto& counter : totals.counters) {
+      XELOGI("    %-26s %8" PRIu64, counter.name, counter.value);
+    }
+  }
+
+  if (!indirect_call_sites_.empty()) {
+    uint64_t total_calls = 0;
+    uint64_t total_misses = 0;
+    for (auto& site : indirect_call_sites_) {
+      total_calls += site.call_count;
+      total_misses += site.miss_count;
+    }
+    XELOGI("  %zu indirect call sites, ~%" PRIu64
+           " calls, ~%.2f%% cache hits (approximate)",
+           indirect_call_sites_.size(), total_calls,
+           total_calls ? 100.0 * (total_calls - total_misses) / total_calls
+                       : 0.0);
+    std::vector<IndirectCallSiteStats> sites(indirect_call_sites_);
+    std::sort(sites.begin(), sites.end(),
+              [](const IndirectCallSiteStats& a,
+                 const IndirectCallSiteStats& b) {
+                return a.miss_count > b.miss_count;
+              });
+    XELOGI("    %-10s %12s %12s %8s", "address", "calls", "misses", "targets");
+    for (size_t i = 0; i < std::min(sites.size(), size_t(20)); ++i) {
+      if (!sites[i].miss_count) {
+        break;
+      }
+      XELOGI("    %08X   %12" PRIu64 " %12" PRIu64 " %8u", sites[i].address,
+             sites[i].call_count, sites[i].miss_count,
+             sites[i].cached_target_count);
+    }
+  }
+
+  for (auto& histogram : BuildHistograms()) {
+    XELOGI("  %s:", histogram.name);
+    for (size_t n = 0; n < histogram.bucket_count; ++n) {
+      if (!histogram.buckets[n]) {
+        continue;
+      }
+      uint64_t min = n ? uint64_t(1) << (n - 1) : 0;
+      uint64_t max = n ? (uint64_t(1) << (n - 1)) * 2 - 1 : 0;
+      XELOGI("    %10" PRIu64 " - %-10" PRIu64 " %8" PRIu64, min, max,
+             histogram.buckets[n]);
+    }
+  }
+}
+
+bool CompilerStats::WriteJson(const std::wstring& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FILE* file = xe::filesystem::OpenFile(path, "w");
+  if (!file) {
+    XELOGE("Unable to open JIT stats file %S", path.c_str());
+    return false;
+  }
+
+  fprintf(file, "{\n  \"passes\": [");
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    auto& totals = passes_[i];
+    fprintf(file,
+            "%s\n    {\"name\": \"%s\", \"runs\": %" PRIu64
+            ", \"time_us\": %" PRIu64 ", \"allocated_bytes\": %" PRIu64
+            ", \"counters\": {",
+            i ? "," : "", totals.name, totals.run_count,
+            TicksToMicroseconds(totals.ticks), totals.allocated_bytes);
+    for (size_t j = 0; j < totals.counters.size(); ++j) {
+      fprintf(file, "%s\"%s\": %" PRIu64, j ? ", " : "",
+              totals.counters[j].name, totals.counters[j].value);
+    }
+    fprintf(file, "}}");
+  }
+  fprintf(file, "\n  ],\n  \"functions\": [");
+  for (size_t i = 0; i < functions_.size(); ++i) {
+    auto& function = functions_[i];
+    fprintf(file,
+            "%s\n    {\"address\": %u, \"guest_instr_count\": %u, "
+            "\"raw_hir_instr_count\": %u, \"hir_instr_count\": %u, "
+            "\"hir_value_count\": %u, \"hir_block_count\": %u, "
+            "\"inlined_call_count\": %u, \"tier\": \"%s\", "
+            "\"promoted\": %s, \"code_size\": %" PRIu64
+            ", \"time_us\": %" PRIu64 "}",
+            i ? "," : "", function.address, function.guest_instr_count,
+            function.raw_hir_instr_count, function.hir_instr_count,
+            function.hir_value_count, function.hir_block_count,
+            function.inlined_call_count,
+            function.baseline ? "baseline" : "optimized",
+            function.promoted ? "true" : "false", function.code_size,
+            TicksToMicroseconds(function.ticks));
+  }
+  fprintf(file, "\n  ],\n  \"indirect_call_sites\": [");
+  for (size_t i = 0; i < indirect_call_sites_.size(); ++i) {
+    auto& site = indirect_call_sites_[i];
+    fprintf(file,
+            "%s\n    {\"address\": %u, \"calls\": %" PRIu64
+            ", \"misses\": %" PRIu64 ", \"cached_targets\": %u}",
+            i ? "," : "", site.address, site.call_count, site.miss_count,
+            site.cached_target_count);
+  }
+  fprintf(file, "\n  ],\n  \"histograms\": {");
+  auto histograms = BuildHistograms();
+  for (size_t i = 0; i < histograms.size(); ++i) {
+    auto& histogram = histograms[i];
+    // Counts of values in [0, 0], [1, 1], [2, 3], [4, 7] and so on.
+    fprintf(file, "%s\n    \"%s\": [", i ? "," : "", histogram.name);
+    for (size_t n = 0; n < histogram.bucket_count; ++n) {
+      fprintf(file, "%s%" PRIu64, n ? ", " : "", histogram.buckets[n]);
+    }
+    fprintf(file, "]");
+  }
+  fprintf(file, "\n  }\n}\n");
+
+  fclose(file);
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_COMPILER_STATS_H_
+#define XENIA_CPU_COMPILER_COMPILER_STATS_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "xenia/cpu/compiler/compiler.h"
+#include "xenia/cpu/compiler/compiler_pass.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+
+// Translation statistics gathered from all translators when --log_jit_stats
+// or --jit_stats_path is set. Logged and/or written as JSON on shutdown.
+class CompilerStats {
+ public:
+  struct FunctionStats {
+    uint32_t address;
+    uint32_t guest_instr_count;
+    // Instructions in the HIR as emitted by the frontend, before any passes.
+    uint32_t raw_hir_instr_count;
+    // Instructions, values and blocks after all passes.
+    uint32_t hir_instr_count;
+    uint32_t hir_value_count;
+    uint32_t hir_block_count;
+    // Calls emitted as the body of the callee.
+    uint32_t inlined_call_count;
+    // See --tiered_compilation. Promoted functions are recompilations of
+    // baseline ones.
+    bool baseline;
+    bool promoted;
+    uint64_t code_size;
+    // Whole translation, from scanning to assembly.
+    uint64_t ticks;
+  };
+  // Reported by the backend for each indirect call with an inline cache.
+  struct IndirectCallSiteStats {
+    // Guest address of the branch.
+    uint32_t address;
+    uint32_t cached_target_count;
+    // Counted by guest threads without synchronization, so concurrent calls
+    // through the same site may be lost - the counts are approximate.
+    uint64_t call_count;
+    // Calls to targets not in the cache.
+    uint64_t miss_count;
+  };
+
+  CompilerStats();
+  ~CompilerStats();
+
+  // Thread safe.
+  void AddFunction(const FunctionStats& function,
+                   const std::vector<Compiler::PassRun>& pass_runs);
+  void AddCounters(const char* pass_name,
+                   const std::vector<CompilerPass::Counter>& counters);
+  void AddIndirectCallSites(const std::vector<IndirectCallSiteStats>& sites);
+
+  void Dump();
+  bool WriteJson(const std::wstring& path);
+
+ private:
+  struct PassTotals {
+    const char* name;
+    uint64_t run_count = 0;
+    uint64_t ticks = 0;
+    uint64_t allocated_bytes = 0;
+    std::vector<CompilerPass::Counter> counters;
+  };
+  // Power of two buckets, bucket n holding values in [2^(n-1), 2^n).
+  struct Histogram {
+    const char* name;
+    uint64_t buckets[65] = {};
+    size_t bucket_count = 0;
+    void Add(uint64_t value);
+  };
+
+  PassTotals& GetPassTotals(const char* name);
+  std::vector<Histogram> BuildHistograms() const;
+  uint64_t TicksToMicroseconds(uint64_t ticks) const;
+
+  std::mutex mutex_;
+  uint64_t tick_frequency_;
+  // In order of first appearance, which is pipeline order.
+  std::vector<PassTotals> passes_;
+  std::vector<FunctionStats> functions_;
+  std::vector<IndirectCallSiteStats> indirect_call_sites_;
+};
+
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_COMPILER_STATS_H_
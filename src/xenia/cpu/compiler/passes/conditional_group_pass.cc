@@ -73,6 +73,12 @@ bool ConditionalGroupPass::Run(HIRBuilder* builder) {
   return true;
 }
 
+void ConditionalGroupPass::GetCounters(std::vector<Counter>* counters) const {
+  for (auto& pass : passes_) {
+    pass->GetCounters(counters);
+  }
+}
+
 void ConditionalGroupPass::AddPass(std::unique_ptr<CompilerPass> pass) {
   passes_.push_back(std::move(pass));
 }
@@ -27,10 +27,15 @@ class ConditionalGroupPass : public CompilerPass {
   ConditionalGroupPass();
   virtual ~ConditionalGroupPass() override;
 
+  const char* name() const override { return "ConditionalGroup"; }
+
   bool Initialize(Compiler* compiler) override;
 
   bool Run(hir::HIRBuilder* builder) override;
 
+  // The counters of all subpasses.
+  void GetCounters(std::vector<Counter>* counters) const override;
+
   void AddPass(std::unique_ptr<CompilerPass> pass);
 
  private:
@@ -0,0 +1,279 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/context_constant_propagation_pass.h"
+
+#include <algorithm>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/profiling.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::hir::Block;
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+using xe::cpu::hir::Value;
+
+ContextConstantPropagationPass::ContextConstantPropagationPass()
+    : ConditionalGroupSubpass() {}
+
+ContextConstantPropagationPass::~ContextConstantPropagationPass() {}
+
+void ContextConstantPropagationPass::GetCounters(
+    std::vector<Counter>* counters) const {
+  counters->push_back({"context loads replaced", replaced_load_count_});
+}
+
+bool ContextConstantPropagationPass::Run(HIRBuilder* builder, bool& result) {
+  // Example:
+  //   block0:
+  //     store_context +100, 0
+  //     branch block1
+  //   block1:
+  //     v0 = load_context +100  <-- replace with v0 = 0
+  //     ...
+  //     branch_true v1, block1
+  // The store reaches block1 from block0 and from the back edge, and +100 is
+  // not written in the loop, so the load always produces 0.
+  // Exit states start out unknown and only shrink as more predecessors are
+  // visited, so iterating in block order until nothing changes converges.
+  SCOPE_profile_cpu_f("cpu");
+
+  result = false;
+
+  uint16_t block_count = 0;
+  auto block = builder->first_block();
+  while (block) {
+    block->ordinal = block_count++;
+    block = block->next;
+  }
+  block_states_.resize(block_count);
+  for (auto& block_state : block_states_) {
+    block_state.visited = false;
+    block_state.exit.clear();
+  }
+
+  ContextState state;
+  ContextState exit_state;
+  bool changed;
+  do {
+    changed = false;
+    block = builder->first_block();
+    while (block) {
+      auto& block_state = block_states_[block->ordinal];
+      GetEntryState(builder, block, state);
+      PropagateBlock(block, state, false, exit_state);
+      if (!block_state.visited || !Equals(block_state.exit, exit_state)) {
+        block_state.visited = true;
+        block_state.exit.swap(exit_state);
+        changed = true;
+      }
+      block = block->next;
+    }
+  } while (changed);
+
+  block = builder->first_block();
+  while (block) {
+    GetEntryState(builder, block, state);
+    result |= PropagateBlock(block, state, true, exit_state);
+    block = block->next;
+  }
+
+  return true;
+}
+
+void ContextConstantPropagationPass::GetEntryState(HIRBuilder* builder,
+                                                   Block* block,
+                                                   ContextState& state) {
+  state.clear();
+  if (block == builder->first_block()) {
+    // Anything may be in the context on entry, even if the first block is
+    // also a loop header.
+    return;
+  }
+  bool has_predecessor = false;
+  auto add_predecessor = [&](Block* src) {
+    auto& src_state = block_states_[src->ordinal];
+    // Predecessors not visited yet don't constrain anything.
+    if (!src_state.visited) {
+      return;
+    }
+    if (!has_predecessor) {
+      state = src_state.exit;
+      has_predecessor = true;
+    } else {
+      Meet(state, src_state.exit);
+    }
+  };
+  // ControlFlowAnalysisPass only adds edges for branch targets, so the block
+  // falling through into this one has to be checked separately.
+  if (block->prev && FallsThrough(block->prev)) {
+    add_predecessor(block->prev);
+  }
+  auto edge = block->incoming_edge_head;
+  while (edge) {
+    add_predecessor(edge->src);
+    edge = edge->incoming_next;
+  }
+}
+
+bool ContextConstantPropagationPass::FallsThrough(const Block* block) {
+  auto i = block->instr_tail;
+  if (!i) {
+    return true;
+  }
+  if (i->opcode == &OPCODE_CALL_info ||
+      i->opcode == &OPCODE_CALL_INDIRECT_info) {
+    return (i->flags & CALL_TAIL) == 0;
+  }
+  return i->opcode != &OPCODE_BRANCH_info && i->opcode != &OPCODE_RETURN_info;
+}
+
+bool ContextConstantPropagationPass::PropagateBlock(Block* block,
+                                                    ContextState& state,
+                                                    bool replace,
+                                                    ContextState& exit_state) {
+  bool replaced = false;
+
+  Instr* i = block->instr_head;
+  while (i) {
+    if (i->opcode == &OPCODE_BRANCH_TRUE_info ||
+        i->opcode == &OPCODE_BRANCH_FALSE_info) {
+      // Marked volatile to keep them in place, but they don't touch the
+      // context.
+    } else if (i->opcode->flags & OPCODE_FLAG_VOLATILE ||
+               i->opcode == &OPCODE_CONTEXT_BARRIER_info) {
+      // Calls and such may change anything in the context.
+      state.clear();
+    } else if (i->opcode == &OPCODE_LOAD_CONTEXT_info) {
+      uint32_t offset = static_cast<uint32_t>(i->src1.offset);
+      auto context_value = Find(state, offset);
+      if (replace && context_value &&
+          context_value->value->type == i->dest->type) {
+        i->opcode = &hir::OPCODE_ASSIGN_info;
+        i->set_src1(context_value->value);
+        replaced = true;
+        ++replaced_load_count_;
+      }
+    } else if (i->opcode == &OPCODE_STORE_CONTEXT_info) {
+      uint32_t offset = static_cast<uint32_t>(i->src1.offset);
+      Value* value = i->src2.value;
+      if (value->IsConstant()) {
+        Set(state, offset, value);
+      } else {
+        Kill(state, offset, uint32_t(GetTypeSize(value->type)));
+      }
+    }
+    i = i->next;
+  }
+
+  // HIRBuilder ends blocks at branches, so both the branch targets and the
+  // fall-through successor see the state at the end of the block.
+  exit_state = state;
+  return replaced;
+}
+
+const ContextConstantPropagationPass::ContextValue*
+ContextConstantPropagationPass::Find(const ContextState& state,
+                                     uint32_t offset) {
+  auto it = std::lower_bound(
+      state.begin(), state.end(), offset,
+      [](const ContextValue& a, uint32_t b) { return a.offset < b; });
+  if (it == state.end() || it->offset != offset) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+void ContextConstantPropagationPass::Kill(ContextState& state, uint32_t offset,
+                                          uint32_t size) {
+  // Partial overwrites invalidate the whole slot.
+  state.erase(std::remove_if(state.begin(), state.end(),
+                             [offset, size](const ContextValue& a) {
+                               return a.offset < offset + size &&
+                                      offset < a.offset + a.size;
+                             }),
+              state.end());
+}
+
+void ContextConstantPropagationPass::Set(ContextState& state, uint32_t offset,
+                                         Value* value) {
+  uint32_t size = uint32_t(GetTypeSize(value->type));
+  Kill(state, offset, size);
+  auto it = std::lower_bound(
+      state.begin(), state.end(), offset,
+      [](const ContextValue& a, uint32_t b) { return a.offset < b; });
+  state.insert(it, {offset, size, value});
+}
+
+void ContextConstantPropagationPass::Meet(ContextState& state,
+                                          const ContextState& other) {
+  state.erase(std::remove_if(state.begin(), state.end(),
+                             [&other](const ContextValue& a) {
+                               auto b = Find(other, a.offset);
+                               return !b || !IsSameConstant(a.value, b->value);
+                             }),
+              state.end());
+}
+
+bool ContextConstantPropagationPass::Equals(const ContextState& a,
+                                            const ContextState& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t n = 0; n < a.size(); ++n) {
+    if (a[n].offset != b[n].offset ||
+        !IsSameConstant(a[n].value, b[n].value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ContextConstantPropagationPass::IsSameConstant(const Value* a,
+                                                    const Value* b) {
+  if (a == b) {
+    return true;
+  }
+  if (a->type != b->type) {
+    return false;
+  }
+  switch (a->type) {
+    case INT8_TYPE:
+      return a->constant.i8 == b->constant.i8;
+    case INT16_TYPE:
+      return a->constant.i16 == b->constant.i16;
+    case INT32_TYPE:
+      return a->constant.i32 == b->constant.i32;
+    case INT64_TYPE:
+      return a->constant.i64 == b->constant.i64;
+    case FLOAT32_TYPE:
+      // Compare bits so that NaNs and signed zeros are told apart.
+      return a->constant.i32 == b->constant.i32;
+    case FLOAT64_TYPE:
+      return a->constant.i64 == b->constant.i64;
+    case VEC128_TYPE:
+      return a->constant.v128 == b->constant.v128;
+    default:
+      assert_unhandled_case(a->type);
+      return false;
+  }
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
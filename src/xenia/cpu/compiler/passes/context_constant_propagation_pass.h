@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_CONTEXT_CONSTANT_PROPAGATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_CONTEXT_CONSTANT_PROPAGATION_PASS_H_
+
+#include <vector>
+
+#include "xenia/cpu/compiler/passes/conditional_group_subpass.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Forwards constants stored to the context across block boundaries.
+// ContextPromotionPass only sees one block at a time, so a value set up before
+// a loop is reloaded from the context on every iteration. This pass runs a
+// forward data flow over the CFG edges built by ControlFlowAnalysisPass plus
+// fall-through into the next block, and replaces loads of context slots that
+// hold the same constant on every incoming path.
+// Only constants are forwarded: they have no register and can be used from any
+// block, while other values would need to be spilled to locals between blocks
+// by the per-block register allocator, which is no better than reloading them.
+class ContextConstantPropagationPass : public ConditionalGroupSubpass {
+ public:
+  ContextConstantPropagationPass();
+  ~ContextConstantPropagationPass() override;
+
+  const char* name() const override { return "ContextConstantPropagation"; }
+
+  bool Run(hir::HIRBuilder* builder, bool& result) override;
+
+  void GetCounters(std::vector<Counter>* counters) const override;
+
+ private:
+  struct ContextValue {
+    uint32_t offset;
+    uint32_t size;
+    hir::Value* value;
+  };
+  // Constant context slots, sorted by offset.
+  typedef std::vector<ContextValue> ContextState;
+  struct BlockState {
+    bool visited;
+    // Slots known at the end of the block.
+    ContextState exit;
+  };
+
+  void GetEntryState(hir::HIRBuilder* builder, hir::Block* block,
+                     ContextState& state);
+  // Whether execution may continue into block->next.
+  static bool FallsThrough(const hir::Block* block);
+  // Walks the block from the given entry state, optionally replacing loads of
+  // known constants. Returns true if any loads were replaced.
+  bool PropagateBlock(hir::Block* block, ContextState& state, bool replace,
+                      ContextState& exit_state);
+
+  static const ContextValue* Find(const ContextState& state, uint32_t offset);
+  static void Kill(ContextState& state, uint32_t offset, uint32_t size);
+  static void Set(ContextState& state, uint32_t offset, hir::Value* value);
+  static void Meet(ContextState& state, const ContextState& other);
+  static bool Equals(const ContextState& a, const ContextState& b);
+  static bool IsSameConstant(const hir::Value* a, const hir::Value* b);
+
+  std::vector<BlockState> block_states_;
+
+  uint64_t replaced_load_count_ = 0;
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_CONTEXT_CONSTANT_PROPAGATION_PASS_H_
@@ -22,6 +22,8 @@ class ControlFlowSimplificationPass : public CompilerPass {
   ControlFlowSimplificationPass();
   ~ControlFlowSimplificationPass() override;
 
+  const char* name() const override { return "ControlFlowSimplification"; }
+
   bool Run(hir::HIRBuilder* builder) override;
 
  private:
@@ -22,6 +22,8 @@ class DataFlowAnalysisPass : public CompilerPass {
   DataFlowAnalysisPass();
   ~DataFlowAnalysisPass() override;
 
+  const char* name() const override { return "DataFlowAnalysis"; }
+
   bool Run(hir::HIRBuilder* builder) override;
 
  private:
@@ -0,0 +1,162 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/dead_store_elimination_pass.h"
+
+#include "xenia/base/cvar.h"
+#include "xenia/base/profiling.h"
+#include "xenia/cpu/ppc/ppc_context.h"
+
+DECLARE_bool(debug);
+DECLARE_bool(store_all_context_values);
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::hir::Block;
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+
+DeadStoreEliminationPass::DeadStoreEliminationPass() : CompilerPass() {}
+
+DeadStoreEliminationPass::~DeadStoreEliminationPass() {}
+
+void DeadStoreEliminationPass::GetCounters(
+    std::vector<Counter>* counters) const {
+  counters->push_back({"context stores removed", removed_store_count_});
+}
+
+bool DeadStoreEliminationPass::Run(HIRBuilder* builder) {
+  // Example:
+  //   block0:
+  //     store_context +cr6, v0  <-- removed, overwritten in both successors
+  //     branch_true v1, block2
+  //   block1:
+  //     store_context +cr6, v2
+  //     ...
+  //   block2:
+  //     store_context +cr6, v3
+  //     ...
+  // This is a backwards must-analysis over the blocks: a byte of the context
+  // is overwritten at some point if it is overwritten on all paths from there
+  // before anything reads it. Iteration starts with nothing overwritten so
+  // that stores in loops without an exit are kept.
+  //
+  // Removed stores break debugging the same way ContextPromotionPass does.
+  if (cvars::debug || cvars::store_all_context_values) {
+    return true;
+  }
+  SCOPE_profile_cpu_f("cpu");
+
+  uint16_t block_count = 0;
+  auto block = builder->first_block();
+  while (block) {
+    block->ordinal = block_count++;
+    block = block->next;
+  }
+  if (entry_written_.size() < block_count) {
+    entry_written_.resize(block_count);
+  }
+  for (uint16_t n = 0; n < block_count; ++n) {
+    entry_written_[n].clear();
+    entry_written_[n].resize(static_cast<uint32_t>(sizeof(ppc::PPCContext)));
+  }
+
+  llvm::BitVector written;
+  bool changed;
+  do {
+    changed = false;
+    block = builder->last_block();
+    while (block) {
+      AnalyzeBlock(block, false, written);
+      auto& entry_written = entry_written_[block->ordinal];
+      if (written != entry_written) {
+        entry_written = written;
+        changed = true;
+      }
+      block = block->prev;
+    }
+  } while (changed);
+
+  block = builder->first_block();
+  while (block) {
+    AnalyzeBlock(block, true, written);
+    block = block->next;
+  }
+
+  return true;
+}
+
+void DeadStoreEliminationPass::AnalyzeBlock(Block* block, bool remove_stores,
+                                            llvm::BitVector& written) {
+  // This runs before FinalizationPass adds the branches, so a block that
+  // doesn't end in an unconditional branch falls through into the next one.
+  // Returns and tail calls are volatile and reset written on their own.
+  auto tail = block->instr_tail;
+  if (block->next && (!tail || tail->opcode != &OPCODE_BRANCH_info)) {
+    written = GetEntryWritten(block->next);
+  } else {
+    written.clear();
+    written.resize(static_cast<uint32_t>(sizeof(ppc::PPCContext)));
+  }
+
+  Instr* i = block->instr_tail;
+  while (i) {
+    Instr* prev = i->prev;
+    if (i->opcode == &OPCODE_BRANCH_info) {
+      written = GetEntryWritten(i->src1.label->block);
+    } else if (i->opcode == &OPCODE_BRANCH_TRUE_info ||
+               i->opcode == &OPCODE_BRANCH_FALSE_info) {
+      written &= GetEntryWritten(i->src2.label->block);
+    } else if (i->opcode->flags & OPCODE_FLAG_VOLATILE ||
+               i->opcode == &OPCODE_CONTEXT_BARRIER_info) {
+      // Calls, returns and such may read anything in the context.
+      written.reset();
+    } else if (i->opcode == &OPCODE_LOAD_CONTEXT_info) {
+      uint32_t offset = static_cast<uint32_t>(i->src1.offset);
+      uint32_t size = static_cast<uint32_t>(GetTypeSize(i->dest->type));
+      written.reset(offset, offset + size);
+    } else if (i->opcode == &OPCODE_STORE_CONTEXT_info) {
+      uint32_t offset = static_cast<uint32_t>(i->src1.offset);
+      uint32_t size =
+          static_cast<uint32_t>(GetTypeSize(i->src2.value->type));
+      bool dead = true;
+      for (uint32_t n = offset; n < offset + size; ++n) {
+        if (!written.test(n)) {
+          dead = false;
+          break;
+        }
+      }
+      if (dead) {
+        if (remove_stores) {
+          i->Remove();
+          ++removed_store_count_;
+        }
+      } else {
+        written.set(offset, offset + size);
+      }
+    }
+    i = prev;
+  }
+}
+
+const llvm::BitVector& DeadStoreEliminationPass::GetEntryWritten(
+    Block* block) const {
+  return entry_written_[block->ordinal];
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
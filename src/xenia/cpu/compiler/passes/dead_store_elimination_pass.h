@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_DEAD_STORE_ELIMINATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_DEAD_STORE_ELIMINATION_PASS_H_
+
+#include <vector>
+
+#include "xenia/base/platform.h"
+#include "xenia/cpu/compiler/compiler_pass.h"
+
+#if XE_COMPILER_MSVC
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#pragma warning(disable : 4267)
+#include <llvm/ADT/BitVector.h>
+#pragma warning(pop)
+#else
+#include <llvm/ADT/BitVector.h>
+#endif  // XE_COMPILER_MSVC
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Removes context stores that are overwritten on all paths before the context
+// is read, a call is made or the function returns. Mostly catches CR and XER
+// updates that are recomputed by the next compare or carrying instruction
+// in a following block.
+class DeadStoreEliminationPass : public CompilerPass {
+ public:
+  DeadStoreEliminationPass();
+  ~DeadStoreEliminationPass() override;
+
+  const char* name() const override { return "DeadStoreElimination"; }
+
+  bool Run(hir::HIRBuilder* builder) override;
+
+  void GetCounters(std::vector<Counter>* counters) const override;
+
+ private:
+  // Walks the block backwards from its exit, leaving the context bytes
+  // overwritten before being read from its entry in written.
+  void AnalyzeBlock(hir::Block* block, bool remove_stores,
+                    llvm::BitVector& written);
+  const llvm::BitVector& GetEntryWritten(hir::Block* block) const;
+
+  // Context bytes overwritten before being read from the entry of each block.
+  std::vector<llvm::BitVector> entry_written_;
+
+  uint64_t removed_store_count_ = 0;
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_DEAD_STORE_ELIMINATION_PASS_H_
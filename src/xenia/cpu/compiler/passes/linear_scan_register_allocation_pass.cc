@@ -0,0 +1,310 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/linear_scan_register_allocation_pass.h"
+
+#include <algorithm>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/profiling.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::backend::MachineInfo;
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+using xe::cpu::hir::RegAssignment;
+using xe::cpu::hir::TypeName;
+using xe::cpu::hir::Value;
+
+LinearScanRegisterAllocationPass::LinearScanRegisterAllocationPass(
+    const MachineInfo* machine_info)
+    : CompilerPass() {
+  auto mi_sets = machine_info->register_sets;
+  for (size_t n = 0; n < xe::countof(states_) && mi_sets[n].count; ++n) {
+    auto& mi_set = mi_sets[n];
+    assert_true(mi_set.count <= 32);
+    auto& state = states_[n];
+    state.set = &mi_set;
+    state.all_mask =
+        mi_set.count >= 32 ? UINT32_MAX : (uint32_t(1) << mi_set.count) - 1;
+    if (mi_set.types & MachineInfo::RegisterSet::INT_TYPES) {
+      int_state_ = &state;
+    }
+    if (mi_set.types & MachineInfo::RegisterSet::FLOAT_TYPES) {
+      float_state_ = &state;
+    }
+    if (mi_set.types & MachineInfo::RegisterSet::VEC_TYPES) {
+      vec_state_ = &state;
+    }
+  }
+}
+
+LinearScanRegisterAllocationPass::~LinearScanRegisterAllocationPass() =
+    default;
+
+void LinearScanRegisterAllocationPass::GetCounters(
+    std::vector<Counter>* counters) const {
+  counters->push_back({"spills", spill_count_});
+  counters->push_back({"src1 reuses", hinted_count_});
+}
+
+bool LinearScanRegisterAllocationPass::Run(HIRBuilder* builder) {
+  // Values don't live across blocks at this point, so each block is scanned
+  // on its own. The interval of a value runs from its definition to its last
+  // use, both numbered by instruction ordinal. Walking the instructions in
+  // order visits the intervals by start, so there's no separate sort:
+  //   - intervals that ended at or before the current instruction release
+  //     their registers (so the dest may reuse a src dying here, which the
+  //     x64 two-operand forms like),
+  //   - the dest gets a free register, preferring the one of src1 and
+  //     steering values live across calls away from call-clobbered ones,
+  //   - with nothing free, the active interval ending last is split at its
+  //     next use through a local, like RegisterAllocationPass spills.
+  SCOPE_profile_cpu_f("cpu");
+
+  uint16_t block_ordinal = 0;
+  uint32_t instr_ordinal = 0;
+  auto block = builder->first_block();
+  while (block) {
+    block->ordinal = block_ordinal++;
+
+    for (auto& state : states_) {
+      state.free_mask = state.all_mask;
+      state.active.clear();
+    }
+    call_positions_.clear();
+
+    auto instr = block->instr_head;
+    while (instr) {
+      instr->ordinal = instr_ordinal++;
+      if (instr->opcode->flags & OPCODE_FLAG_VOLATILE) {
+        call_positions_.push_back(instr->ordinal);
+      }
+      instr = instr->next;
+    }
+
+    // Spill loads and stores are inserted unnumbered and take the position of
+    // the last numbered instruction before them.
+    uint32_t position = 0;
+    instr = block->instr_head;
+    while (instr) {
+      if (instr->ordinal != UINT32_MAX) {
+        position = instr->ordinal;
+        ExpireIntervals(position);
+      }
+      if (GET_OPCODE_SIG_TYPE_DEST(instr->opcode->signature) ==
+          OPCODE_SIG_TYPE_V) {
+        if (!AllocateValue(builder, instr, position)) {
+          return false;
+        }
+      }
+      instr = instr->next;
+    }
+
+    block = block->next;
+  }
+
+  return true;
+}
+
+void LinearScanRegisterAllocationPass::ExpireIntervals(uint32_t position) {
+  for (auto& state : states_) {
+    auto& active = state.active;
+    auto it = active.begin();
+    while (it != active.end() && it->end <= position) {
+      state.free_mask |= uint32_t(1) << it->value->reg.index;
+      ++it;
+    }
+    active.erase(active.begin(), it);
+  }
+}
+
+bool LinearScanRegisterAllocationPass::AllocateValue(HIRBuilder* builder,
+                                                     Instr* instr,
+                                                     uint32_t position) {
+  Value* value = instr->dest;
+  assert_null(value->reg.set);
+  RegisterSetState* state = StateForType(value->type);
+
+  uint32_t end = position;
+  auto use = value->use_head;
+  while (use) {
+    assert_true(use->instr->block == instr->block);
+    assert_true(use->instr->ordinal != UINT32_MAX);
+    end = std::max(end, use->instr->ordinal);
+    use = use->next;
+  }
+
+  if (!state->free_mask) {
+    if (!SplitInterval(builder, state, position)) {
+      XELOGE("Register allocation failed");
+      assert_always();
+      return false;
+    }
+  }
+
+  uint32_t candidates = state->free_mask;
+  uint32_t volatile_mask = state->set->volatile_mask;
+  if (IsLiveAcrossCall(position, end)) {
+    if (candidates & ~volatile_mask) {
+      candidates &= ~volatile_mask;
+    }
+  } else if (candidates & volatile_mask) {
+    // Leave the preserved registers to values that need them.
+    candidates &= volatile_mask;
+  }
+
+  uint32_t index;
+  Value* src1 = instr->src1.value;
+  if (GET_OPCODE_SIG_TYPE_SRC1(instr->opcode->signature) ==
+          OPCODE_SIG_TYPE_V &&
+      !src1->IsConstant() && src1->reg.set == state->set &&
+      candidates & (uint32_t(1) << src1->reg.index)) {
+    index = uint32_t(src1->reg.index);
+    ++hinted_count_;
+  } else {
+    xe::bit_scan_forward(candidates, &index);
+  }
+
+  value->reg.set = state->set;
+  value->reg.index = int32_t(index);
+  state->free_mask &= ~(uint32_t(1) << index);
+  AddActive(state, value, end);
+  return true;
+}
+
+bool LinearScanRegisterAllocationPass::SplitInterval(HIRBuilder* builder,
+                                                     RegisterSetState* state,
+                                                     uint32_t position) {
+  if (state->active.empty()) {
+    return false;
+  }
+  Interval interval = state->active.back();
+  state->active.pop_back();
+  Value* spill_value = interval.value;
+  uint32_t reg_bit = uint32_t(1) << spill_value->reg.index;
+  if (interval.end <= position) {
+    // Unused past here, nothing to keep.
+    state->free_mask |= reg_bit;
+    return true;
+  }
+
+  // Use lists aren't sorted, find the uses around the split point.
+  Value::Use* prev_use = nullptr;
+  Value::Use* next_use = nullptr;
+  Instr* last_instr = nullptr;
+  rename_instrs_.clear();
+  auto use = spill_value->use_head;
+  while (use) {
+    uint32_t ordinal = use->instr->ordinal;
+    if (ordinal <= position) {
+      if (!prev_use || ordinal > prev_use->instr->ordinal) {
+        prev_use = use;
+      }
+    } else {
+      if (!next_use || ordinal < next_use->instr->ordinal) {
+        next_use = use;
+      }
+      if (!last_instr || ordinal > last_instr->ordinal) {
+        last_instr = use->instr;
+      }
+      rename_instrs_.push_back(use->instr);
+    }
+    use = use->next;
+  }
+  assert_not_null(next_use);
+
+  if (!spill_value->local_slot) {
+    spill_value->local_slot = builder->AllocLocal(spill_value->type);
+    builder->StoreLocal(spill_value->local_slot, spill_value);
+    auto spill_store = builder->last_instr();
+    if (prev_use && prev_use->instr->opcode->flags & OPCODE_FLAG_PAIRED_PREV) {
+      // Don't separate paired instructions.
+      assert_not_null(prev_use->instr->next);
+      spill_store->MoveBefore(prev_use->instr->next);
+      spill_value->last_use = spill_store;
+    } else if (prev_use) {
+      spill_store->MoveBefore(prev_use->instr);
+      spill_value->last_use = prev_use->instr;
+    } else {
+      spill_store->MoveBefore(spill_value->def->next);
+      spill_value->last_use = spill_store;
+    }
+  }
+  // Otherwise this is already a reload and the local holds the value.
+
+  // The reload is after the current position, so it'll get its register when
+  // the scan reaches it.
+  auto new_value = builder->LoadLocal(spill_value->local_slot);
+  builder->last_instr()->MoveBefore(next_use->instr);
+  new_value->local_slot = spill_value->local_slot;
+
+  for (auto rename_instr : rename_instrs_) {
+    uint32_t signature = rename_instr->opcode->signature;
+    if (GET_OPCODE_SIG_TYPE_SRC1(signature) == OPCODE_SIG_TYPE_V &&
+        rename_instr->src1.value == spill_value) {
+      rename_instr->set_src1(new_value);
+    }
+    if (GET_OPCODE_SIG_TYPE_SRC2(signature) == OPCODE_SIG_TYPE_V &&
+        rename_instr->src2.value == spill_value) {
+      rename_instr->set_src2(new_value);
+    }
+    if (GET_OPCODE_SIG_TYPE_SRC3(signature) == OPCODE_SIG_TYPE_V &&
+        rename_instr->src3.value == spill_value) {
+      rename_instr->set_src3(new_value);
+    }
+  }
+  new_value->last_use = last_instr;
+
+  state->free_mask |= reg_bit;
+  ++spill_count_;
+  return true;
+}
+
+void LinearScanRegisterAllocationPass::AddActive(RegisterSetState* state,
+                                                 Value* value, uint32_t end) {
+  auto& active = state->active;
+  auto it = std::upper_bound(
+      active.begin(), active.end(), end,
+      [](uint32_t a, const Interval& b) { return a < b.end; });
+  active.insert(it, {value, end});
+}
+
+bool LinearScanRegisterAllocationPass::IsLiveAcrossCall(uint32_t position,
+                                                        uint32_t end) const {
+  // A call at the last use reads the value before clobbering anything.
+  auto it = std::upper_bound(call_positions_.begin(), call_positions_.end(),
+                             position);
+  return it != call_positions_.end() && *it < end;
+}
+
+LinearScanRegisterAllocationPass::RegisterSetState*
+LinearScanRegisterAllocationPass::StateForType(TypeName type) {
+  if (type <= INT64_TYPE) {
+    return int_state_;
+  } else if (type <= FLOAT64_TYPE) {
+    return float_state_;
+  } else {
+    return vec_state_;
+  }
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
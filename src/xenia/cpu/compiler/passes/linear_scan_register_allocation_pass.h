@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_LINEAR_SCAN_REGISTER_ALLOCATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_LINEAR_SCAN_REGISTER_ALLOCATION_PASS_H_
+
+#include <vector>
+
+#include "xenia/cpu/backend/machine_info.h"
+#include "xenia/cpu/compiler/compiler_pass.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Per-block linear scan register allocator. Produces the same HIR as
+// RegisterAllocationPass (registers assigned to values, spills as local
+// stores and loads), but works on live intervals computed once per value
+// instead of keeping per-register use lists sorted.
+class LinearScanRegisterAllocationPass : public CompilerPass {
+ public:
+  explicit LinearScanRegisterAllocationPass(
+      const backend::MachineInfo* machine_info);
+  ~LinearScanRegisterAllocationPass() override;
+
+  const char* name() const override { return "LinearScanRegisterAllocation"; }
+
+  bool Run(hir::HIRBuilder* builder) override;
+
+  void GetCounters(std::vector<Counter>* counters) const override;
+
+ private:
+  struct Interval {
+    hir::Value* value;
+    // Ordinal of the last instruction using the value.
+    uint32_t end;
+  };
+  struct RegisterSetState {
+    const backend::MachineInfo::RegisterSet* set = nullptr;
+    uint32_t all_mask = 0;
+    uint32_t free_mask = 0;
+    // Sorted by end.
+    std::vector<Interval> active;
+  };
+
+  void ExpireIntervals(uint32_t position);
+  bool AllocateValue(hir::HIRBuilder* builder, hir::Instr* instr,
+                     uint32_t position);
+  // Frees the register of the active value ending last by storing it to a
+  // local and reloading it before its next use. The reload gets a register
+  // when the scan reaches it.
+  bool SplitInterval(hir::HIRBuilder* builder, RegisterSetState* state,
+                     uint32_t position);
+  void AddActive(RegisterSetState* state, hir::Value* value, uint32_t end);
+  bool IsLiveAcrossCall(uint32_t position, uint32_t end) const;
+
+  RegisterSetState* StateForType(hir::TypeName type);
+
+  RegisterSetState states_[3];
+  RegisterSetState* int_state_ = nullptr;
+  RegisterSetState* float_state_ = nullptr;
+  RegisterSetState* vec_state_ = nullptr;
+
+  // Ordinals of calls in the current block, in order.
+  std::vector<uint32_t> call_positions_;
+  std::vector<hir::Instr*> rename_instrs_;
+
+  uint64_t spill_count_ = 0;
+  uint64_t hinted_count_ = 0;
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_LINEAR_SCAN_REGISTER_ALLOCATION_PASS_H_
@@ -21,6 +21,7 @@ using namespace xe::cpu::hir;
 
 using xe::cpu::hir::HIRBuilder;
 using xe::cpu::hir::Instr;
+using xe::cpu::hir::TypeName;
 using xe::cpu::hir::Value;
 
 MemorySequenceCombinationPass::MemorySequenceCombinationPass()
@@ -61,7 +62,9 @@ void MemorySequenceCombinationPass::CombineLoadSequence(Instr* i) {
   //   v2.i32 = byte_swap v1.i32
   //   v3.i64 = zero_extend v2.i32
   // becomes:
-  //   v1.i64 = load_convert v0, [swap|i32->i64,zero]
+  //   v1.i64 = load v0, [swap|memory i32]
+  //   v2.i64 = v1.i64
+  //   v3.i64 = v2.i64
 
   if (!i->dest->use_head) {
     // No uses of the load result - ignore. Will be killed by DCE.
@@ -70,31 +73,87 @@ void MemorySequenceCombinationPass::CombineLoadSequence(Instr* i) {
 
   // Ensure all uses of the load result are BYTE_SWAP - if it's mixed we
   // shouldn't transform as we'd have to introduce new swaps!
+  bool all_swaps = true;
   auto use = i->dest->use_head;
   while (use) {
     if (use->instr->opcode != &OPCODE_BYTE_SWAP_info) {
       // Not a swap.
-      return;
+      all_swaps = false;
+      break;
     }
     // TODO(benvanik): allow uses by STORE (we can make that swap).
     use = use->next;
   }
 
-  // Merge byte swap into load.
-  // Note that we may have already been a swapped operation - this inverts that.
-  i->flags ^= LoadStoreFlags::LOAD_STORE_BYTE_SWAP;
+  if (all_swaps) {
+    // Merge byte swap into load.
+    // Note that we may have already been a swapped operation - this inverts
+    // that.
+    i->flags ^= LoadStoreFlags::LOAD_STORE_BYTE_SWAP;
+
+    // Replace use of byte swap value with loaded value.
+    // It's byte_swap vN -> assign vN, so not much to do.
+    use = i->dest->use_head;
+    while (use) {
+      auto next_use = use->next;
+      use->instr->opcode = &OPCODE_ASSIGN_info;
+      use->instr->flags = 0;
+      use = next_use;
+    }
+  }
+
+  CombineLoadExtend(i);
+}
 
-  // Replace use of byte swap value with loaded value.
-  // It's byte_swap vN -> assign vN, so not much to do.
-  use = i->dest->use_head;
-  while (use) {
-    auto next_use = use->next;
-    use->instr->opcode = &OPCODE_ASSIGN_info;
-    use->instr->flags = 0;
-    use = next_use;
+void MemorySequenceCombinationPass::CombineLoadExtend(Instr* i) {
+  uint16_t memory_flag;
+  switch (i->dest->type) {
+    case INT8_TYPE:
+      memory_flag = LoadStoreFlags::LOAD_STORE_MEMORY_I8;
+      break;
+    case INT16_TYPE:
+      memory_flag = LoadStoreFlags::LOAD_STORE_MEMORY_I16;
+      break;
+    case INT32_TYPE:
+      memory_flag = LoadStoreFlags::LOAD_STORE_MEMORY_I32;
+      break;
+    default:
+      return;
   }
 
-  // TODO(benvanik): merge in extend/truncate.
+  // Find the extend, only going through assignments that have no other uses.
+  Value* value = i->dest;
+  Instr* extend;
+  while (true) {
+    if (!value->use_head || value->use_head->next) {
+      return;
+    }
+    extend = value->use_head->instr;
+    if (extend->opcode != &OPCODE_ASSIGN_info) {
+      break;
+    }
+    value = extend->dest;
+  }
+  if (extend->opcode == &OPCODE_SIGN_EXTEND_info) {
+    i->flags |= LoadStoreFlags::LOAD_SIGN_EXTEND;
+  } else if (extend->opcode != &OPCODE_ZERO_EXTEND_info) {
+    return;
+  }
+  i->flags |= memory_flag;
+
+  // Widen the load and the assignments in between, and turn the extend into
+  // an assignment. Nothing else uses these values.
+  TypeName type = extend->dest->type;
+  Value* chain_value = i->dest;
+  while (true) {
+    chain_value->type = type;
+    if (chain_value == value) {
+      break;
+    }
+    chain_value = chain_value->use_head->instr->dest;
+  }
+  extend->Replace(&OPCODE_ASSIGN_info, 0);
+  extend->set_src1(value);
 }
 
 void MemorySequenceCombinationPass::CombineStoreSequence(Instr* i) {
@@ -111,7 +170,7 @@ void MemorySequenceCombinationPass::CombineStoreSequence(Instr* i) {
   //   v3.i32 = byte_swap v2.i32
   //   store v0, v3.i32
   // becomes:
-  //   store_convert v0, v1.i64, [swap|i64->i32,trunc]
+  //   store v0, v1.i64, [swap|memory i32]
 
   auto src = i->src2.value;
   if (i->opcode == &OPCODE_STORE_OFFSET_info) {
@@ -123,31 +182,54 @@ void MemorySequenceCombinationPass::CombineStoreSequence(Instr* i) {
     return;
   }
 
-  // Find source and ensure it is a byte swap.
+  // Find source and check if it is a byte swap.
   auto def = src->def;
   while (def && def->opcode == &OPCODE_ASSIGN_info) {
     // Skip asignments.
     def = def->src1.value->def;
   }
-  if (!def || def->opcode != &OPCODE_BYTE_SWAP_info) {
-    // Not a swap/not defined?
-    return;
+  if (def && def->opcode == &OPCODE_BYTE_SWAP_info) {
+    // Merge byte swap into store.
+    // Note that we may have already been a swapped operation - this inverts
+    // that.
+    i->flags ^= LoadStoreFlags::LOAD_STORE_BYTE_SWAP;
+
+    // Pull the original value (from before the byte swap).
+    // The byte swap itself will go away in DCE.
+    src = def->src1.value;
+    SetStoreValue(i, src);
+    def = src->def;
+    while (def && def->opcode == &OPCODE_ASSIGN_info) {
+      def = def->src1.value->def;
+    }
   }
 
-  // Merge byte swap into store.
-  // Note that we may have already been a swapped operation - this inverts
-  // that.
-  i->flags ^= LoadStoreFlags::LOAD_STORE_BYTE_SWAP;
+  // Merge truncate into store.
+  if (!def || def->opcode != &OPCODE_TRUNCATE_info) {
+    return;
+  }
+  switch (src->type) {
+    case INT8_TYPE:
+      i->flags |= LoadStoreFlags::LOAD_STORE_MEMORY_I8;
+      break;
+    case INT16_TYPE:
+      i->flags |= LoadStoreFlags::LOAD_STORE_MEMORY_I16;
+      break;
+    case INT32_TYPE:
+      i->flags |= LoadStoreFlags::LOAD_STORE_MEMORY_I32;
+      break;
+    default:
+      return;
+  }
+  SetStoreValue(i, def->src1.value);
+}
 
-  // Pull the original value (from before the byte swap).
-  // The byte swap itself will go away in DCE.
+void MemorySequenceCombinationPass::SetStoreValue(Instr* i, Value* value) {
   if (i->opcode == &OPCODE_STORE_info) {
-    i->set_src2(def->src1.value);
+    i->set_src2(value);
   } else if (i->opcode == &OPCODE_STORE_OFFSET_info) {
-    i->set_src3(def->src1.value);
+    i->set_src3(value);
   }
-
-  // TODO(benvanik): extend/truncate.
 }
 
 }  // namespace passes
@@ -22,12 +22,16 @@ class MemorySequenceCombinationPass : public CompilerPass {
   MemorySequenceCombinationPass();
   ~MemorySequenceCombinationPass() override;
 
+  const char* name() const override { return "MemorySequenceCombination"; }
+
   bool Run(hir::HIRBuilder* builder) override;
 
  private:
   void CombineMemorySequences(hir::HIRBuilder* builder);
   void CombineLoadSequence(hir::Instr* i);
+  void CombineLoadExtend(hir::Instr* i);
   void CombineStoreSequence(hir::Instr* i);
+  void SetStoreValue(hir::Instr* i, hir::Value* value);
 };
 
 }  // namespace passes
@@ -173,6 +173,11 @@ bool RegisterAllocationPass::Run(HIRBuilder* builder) {
   return true;
 }
 
+void RegisterAllocationPass::GetCounters(
+    std::vector<Counter>* counters) const {
+  counters->push_back({"spills", spill_count_});
+}
+
 void RegisterAllocationPass::DumpUsage(const char* name) {
 #if 0
   fprintf(stdout, "\n%s:\n", name);
@@ -467,6 +472,7 @@ bool RegisterAllocationPass::SpillOneRegister(HIRBuilder* builder, Block* block,
 
   // Update tracking.
   MarkRegAvailable(reg);
+  ++spill_count_;
 
   return true;
 }
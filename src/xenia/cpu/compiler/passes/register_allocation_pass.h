@@ -28,8 +28,12 @@ class RegisterAllocationPass : public CompilerPass {
   explicit RegisterAllocationPass(const backend::MachineInfo* machine_info);
   ~RegisterAllocationPass() override;
 
+  const char* name() const override { return "RegisterAllocation"; }
+
   bool Run(hir::HIRBuilder* builder) override;
 
+  void GetCounters(std::vector<Counter>* counters) const override;
+
  private:
   // TODO(benvanik): rewrite all this set shit -- too much indirection, the
   // complexity is not needed.
@@ -76,6 +80,8 @@ class RegisterAllocationPass : public CompilerPass {
     RegisterSetUsage* vec_set = nullptr;
     RegisterSetUsage* all_sets[3];
   } usage_sets_;
+
+  uint64_t spill_count_ = 0;
 };
 
 }  // namespace passes
@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/type_propagation_pass.h"
+
+#include <utility>
+
+#include "xenia/base/profiling.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+using xe::cpu::hir::TypeName;
+using xe::cpu::hir::Value;
+
+TypePropagationPass::TypePropagationPass() : ConditionalGroupSubpass() {}
+
+TypePropagationPass::~TypePropagationPass() {}
+
+void TypePropagationPass::GetCounters(std::vector<Counter>* counters) const {
+  counters->push_back({"conversion chains collapsed", collapsed_count_});
+  counters->push_back({"truncated ops narrowed", narrowed_count_});
+  counters->push_back({"extended ands widened", widened_count_});
+}
+
+bool TypePropagationPass::Run(HIRBuilder* builder, bool& result) {
+  // 32-bit guest instructions work on the low half of 64-bit registers, so
+  // after context promotion there are a lot of chains like:
+  //   v1.i32 = truncate v0.i64
+  //   v2.i32 = and v1.i32, 0xFF00
+  //   v3.i64 = zero_extend v2.i32
+  // or, for values that are only stored as words:
+  //   v1.i64 = zero_extend v0.i32
+  //   v2.i64 = add v1.i64, 1
+  //   v3.i32 = truncate v2.i64
+  // The first becomes v3.i64 = and v0.i64, 0xFF00 and the second becomes
+  // v3.i32 = add v0.i32, 1. Conversions of conversions are folded into one.
+  // The old instructions are left for DCE to clean up.
+  SCOPE_profile_cpu_f("cpu");
+
+  result = false;
+  auto block = builder->first_block();
+  while (block) {
+    auto i = block->instr_head;
+    while (i) {
+      if (i->opcode == &OPCODE_TRUNCATE_info) {
+        if (CollapseConversions(i)) {
+          ++collapsed_count_;
+          result = true;
+        } else if (NarrowTruncatedOp(builder, i)) {
+          ++narrowed_count_;
+          result = true;
+        }
+      } else if (i->opcode == &OPCODE_ZERO_EXTEND_info) {
+        if (CollapseConversions(i)) {
+          ++collapsed_count_;
+          result = true;
+        } else if (WidenExtendedAnd(builder, i)) {
+          ++widened_count_;
+          result = true;
+        }
+      } else if (i->opcode == &OPCODE_SIGN_EXTEND_info) {
+        if (CollapseConversions(i)) {
+          ++collapsed_count_;
+          result = true;
+        }
+      }
+      i = i->next;
+    }
+    block = block->next;
+  }
+  return true;
+}
+
+Instr* TypePropagationPass::GetDef(Value* value) {
+  auto def = value->def;
+  while (def && def->opcode == &OPCODE_ASSIGN_info) {
+    def = def->src1.value->def;
+  }
+  return def;
+}
+
+bool TypePropagationPass::CollapseConversions(Instr* i) {
+  auto def = GetDef(i->src1.value);
+  if (!def || def->block != i->block) {
+    return false;
+  }
+  Value* source = def->src1.value;
+  size_t source_size = GetTypeSize(source->type);
+  size_t dest_size = GetTypeSize(i->dest->type);
+  const OpcodeInfo* opcode = nullptr;
+  if (i->opcode == &OPCODE_TRUNCATE_info) {
+    if (def->opcode == &OPCODE_TRUNCATE_info) {
+      // truncate(truncate(x)) = truncate(x)
+      opcode = &OPCODE_TRUNCATE_info;
+    } else if (def->opcode == &OPCODE_ZERO_EXTEND_info ||
+               def->opcode == &OPCODE_SIGN_EXTEND_info) {
+      // Only the extension or none of it is truncated away.
+      if (source_size == dest_size) {
+        opcode = &OPCODE_ASSIGN_info;
+      } else if (source_size > dest_size) {
+        opcode = &OPCODE_TRUNCATE_info;
+      } else {
+        opcode = def->opcode;
+      }
+    }
+  } else if (i->opcode == &OPCODE_ZERO_EXTEND_info) {
+    if (def->opcode == &OPCODE_ZERO_EXTEND_info) {
+      // zero_extend(zero_extend(x)) = zero_extend(x)
+      opcode = &OPCODE_ZERO_EXTEND_info;
+    }
+  } else if (i->opcode == &OPCODE_SIGN_EXTEND_info) {
+    if (def->opcode == &OPCODE_SIGN_EXTEND_info) {
+      // sign_extend(sign_extend(x)) = sign_extend(x)
+      opcode = &OPCODE_SIGN_EXTEND_info;
+    } else if (def->opcode == &OPCODE_ZERO_EXTEND_info) {
+      // The sign bit of a zero extended value is always clear.
+      opcode = &OPCODE_ZERO_EXTEND_info;
+    }
+  }
+  if (!opcode) {
+    return false;
+  }
+  i->Replace(opcode, 0);
+  i->set_src1(source);
+  return true;
+}
+
+Value* TypePropagationPass::GetNarrowedValue(HIRBuilder* builder,
+                                             Value* value, TypeName type) {
+  if (value->IsConstant()) {
+    return builder->Truncate(value, type);
+  }
+  auto def = GetDef(value);
+  if (def && (def->opcode == &OPCODE_ZERO_EXTEND_info ||
+              def->opcode == &OPCODE_SIGN_EXTEND_info)) {
+    if (def->src1.value->type == type) {
+      return def->src1.value;
+    }
+  }
+  return nullptr;
+}
+
+bool TypePropagationPass::NarrowTruncatedOp(HIRBuilder* builder, Instr* i) {
+  // The low bits of these don't depend on the high bits of the operands.
+  auto def = GetDef(i->src1.value);
+  if (!def || def->block != i->block) {
+    return false;
+  }
+  bool is_unary;
+  if (def->opcode == &OPCODE_NOT_info || def->opcode == &OPCODE_NEG_info) {
+    is_unary = true;
+  } else if (def->opcode == &OPCODE_ADD_info ||
+             def->opcode == &OPCODE_SUB_info ||
+             def->opcode == &OPCODE_MUL_info ||
+             def->opcode == &OPCODE_AND_info ||
+             def->opcode == &OPCODE_OR_info ||
+             def->opcode == &OPCODE_XOR_info) {
+    is_unary = false;
+  } else {
+    return false;
+  }
+  if (def->flags & ARITHMETIC_SATURATE) {
+    return false;
+  }
+  // If the wide result is used elsewhere this would only add an instruction.
+  auto wide_value = def->dest;
+  if (!wide_value->use_head || wide_value->use_head->next ||
+      wide_value->type > INT64_TYPE) {
+    return false;
+  }
+  TypeName type = i->dest->type;
+  Value* src1 = GetNarrowedValue(builder, def->src1.value, type);
+  if (!src1) {
+    return false;
+  }
+  Value* src2 = nullptr;
+  if (!is_unary) {
+    src2 = GetNarrowedValue(builder, def->src2.value, type);
+    if (!src2) {
+      return false;
+    }
+    // Not worth it if both operands are constants - constant propagation will
+    // fold the wide op anyway.
+    if (src1->IsConstant() && src2->IsConstant()) {
+      return false;
+    }
+  }
+  i->Replace(def->opcode, def->flags);
+  i->set_src1(src1);
+  if (src2) {
+    i->set_src2(src2);
+  }
+  return true;
+}
+
+bool TypePropagationPass::WidenExtendedAnd(HIRBuilder* builder, Instr* i) {
+  // zero_extend(and(truncate(x), c)) = and(x, zero_extend(c))
+  auto def = GetDef(i->src1.value);
+  if (!def || def->opcode != &OPCODE_AND_info || def->block != i->block) {
+    return false;
+  }
+  auto narrow_value = def->dest;
+  if (!narrow_value->use_head || narrow_value->use_head->next) {
+    return false;
+  }
+  Value* src = def->src1.value;
+  Value* mask = def->src2.value;
+  if (src->IsConstant()) {
+    std::swap(src, mask);
+  }
+  if (!mask->IsConstant() || src->IsConstant()) {
+    return false;
+  }
+  auto src_def = GetDef(src);
+  if (!src_def || src_def->opcode != &OPCODE_TRUNCATE_info ||
+      src_def->src1.value->type != i->dest->type) {
+    return false;
+  }
+  Value* wide_src = src_def->src1.value;
+  Value* wide_mask = builder->ZeroExtend(mask, i->dest->type);
+  i->Replace(&OPCODE_AND_info, 0);
+  i->set_src1(wide_src);
+  i->set_src2(wide_mask);
+  return true;
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_TYPE_PROPAGATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_TYPE_PROPAGATION_PASS_H_
+
+#include "xenia/cpu/compiler/passes/conditional_group_subpass.h"
+#include "xenia/cpu/hir/value.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Collapses chains of integer truncates and extends, and moves arithmetic to
+// the type its result is actually used as, so that the 32-bit guest code
+// operating on 64-bit registers doesn't bounce between the two widths.
+class TypePropagationPass : public ConditionalGroupSubpass {
+ public:
+  TypePropagationPass();
+  ~TypePropagationPass() override;
+
+  const char* name() const override { return "TypePropagation"; }
+
+  bool Run(hir::HIRBuilder* builder, bool& result) override;
+
+  void GetCounters(std::vector<Counter>* counters) const override;
+
+ private:
+  bool CollapseConversions(hir::Instr* i);
+  bool NarrowTruncatedOp(hir::HIRBuilder* builder, hir::Instr* i);
+  bool WidenExtendedAnd(hir::HIRBuilder* builder, hir::Instr* i);
+
+  // Returns the value an operand would have when narrowed to the given type
+  // without adding instructions, or null if that's not possible.
+  hir::Value* GetNarrowedValue(hir::HIRBuilder* builder, hir::Value* value,
+                               hir::TypeName type);
+  static hir::Instr* GetDef(hir::Value* value);
+
+  uint64_t collapsed_count_ = 0;
+  uint64_t narrowed_count_ = 0;
+  uint64_t widened_count_ = 0;
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_TYPE_PROPAGATION_PASS_H_
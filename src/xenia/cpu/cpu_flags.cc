@@ -37,6 +37,41 @@ DEFINE_bool(
 
 DEFINE_bool(validate_hir, false,
             "Perform validation checks on the HIR during compilation.", "CPU");
+DEFINE_bool(log_jit_stats, false,
+            "Log translation statistics on shutdown: time and allocations per "
+            "compiler pass, pass counters such as register spills, and "
+            "histograms of function sizes.",
+            "CPU");
+DEFINE_string(jit_stats_path, "",
+              "File to write translation statistics to as JSON on shutdown.",
+              "CPU");
+DEFINE_bool(inline_guest_calls, true,
+            "Emit small leaf functions in place of the calls to them. Not done "
+            "for functions with debug info (tracing, disassembly).",
+            "CPU");
+DEFINE_int32(inline_max_guest_instrs, 24,
+             "Largest function inlined by --inline_guest_calls, in guest "
+             "instructions.",
+             "CPU");
+DEFINE_bool(tiered_compilation, false,
+            "Compile guest functions with a minimal set of passes first, and "
+            "recompile the ones entered --tier_up_threshold times with the "
+            "full optimization pipeline in the background.",
+            "CPU");
+DEFINE_int32(tier_up_threshold, 1000,
+             "Entries of a baseline function before it's recompiled.", "CPU");
+DEFINE_bool(linear_scan_register_allocation, false,
+            "Allocate registers with linear scan over live intervals instead "
+            "of the use-sorting allocator.",
+            "CPU");
+
+DEFINE_string(sampling_profiler_path, "",
+              "Sample the stacks of running guest threads and write them to "
+              "this file on shutdown, in the folded format used by flame graph "
+              "tools. A flat profile is logged as well.",
+              "CPU");
+DEFINE_int32(sampling_profiler_interval_us, 1000,
+             "Microseconds between samples of each guest thread.", "CPU");
 
 // Breakpoints:
 DEFINE_uint64(break_on_instruction, 0,
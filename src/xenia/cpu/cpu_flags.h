@@ -25,6 +25,15 @@ DECLARE_bool(trace_function_data);
 DECLARE_bool(disable_global_lock);
 
 DECLARE_bool(validate_hir);
+DECLARE_bool(log_jit_stats);
+DECLARE_string(jit_stats_path);
+DECLARE_bool(inline_guest_calls);
+DECLARE_int32(inline_max_guest_instrs);
+DECLARE_bool(tiered_compilation);
+DECLARE_int32(tier_up_threshold);
+DECLARE_bool(linear_scan_register_allocation);
+DECLARE_string(sampling_profiler_path);
+DECLARE_int32(sampling_profiler_interval_us);
 
 DECLARE_uint64(break_on_instruction);
 DECLARE_int32(break_condition_gpr);
@@ -34,4 +43,6 @@ DECLARE_bool(break_condition_truncate);
 
 DECLARE_bool(break_on_debugbreak);
 
+DECLARE_bool(background_compilation);
+
 #endif  // XENIA_CPU_CPU_FLAGS_H_
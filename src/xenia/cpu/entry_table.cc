@@ -15,20 +15,89 @@
 namespace xe {
 namespace cpu {
 
-EntryTable::EntryTable() = default;
+namespace {
+
+Entry* CreateEntry(uint32_t address) {
+  Entry* entry = new Entry();
+  entry->address = address;
+  entry->end_address = 0;
+  entry->status = Entry::STATUS_COMPILING;
+  entry->function = nullptr;
+  return entry;
+}
+
+Entry::Status WaitForEntry(Entry* entry) {
+  Entry::Status status = entry->status;
+  // If we aren't ready yet spin and wait.
+  while (status == Entry::STATUS_COMPILING) {
+    // TODO(benvanik): sleep for less time?
+    xe::threading::Sleep(std::chrono::microseconds(10));
+    status = entry->status;
+  }
+  return status;
+}
+
+}  // namespace
+
+EntryTable::EntryTable() {
+  for (uint32_t i = 0; i < kPageCount; ++i) {
+    pages_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
 
 EntryTable::~EntryTable() {
+  for (uint32_t i = 0; i < kPageCount; ++i) {
+    Page* page = pages_[i].load(std::memory_order_relaxed);
+    if (!page) {
+      continue;
+    }
+    for (uint32_t j = 0; j < kEntriesPerPage; ++j) {
+      delete page->entries[j].load(std::memory_order_relaxed);
+    }
+    delete page;
+  }
   auto global_lock = global_critical_region_.Acquire();
-  for (auto it : map_) {
+  for (auto it : unpaged_map_) {
     Entry* entry = it.second;
     delete entry;
   }
 }
 
+std::atomic<Entry*>* EntryTable::GetSlot(uint32_t address, bool create) {
+  uint32_t offset = address - kCodeRangeBase;
+  if (offset >= kCodeRangeSize || (address & 3)) {
+    return nullptr;
+  }
+  auto& page_ptr = pages_[offset >> kPageSizeLog2];
+  Page* page = page_ptr.load(std::memory_order_acquire);
+  if (!page) {
+    if (!create) {
+      return nullptr;
+    }
+    // Value-initialized, so all entries are null.
+    Page* new_page = new Page();
+    if (page_ptr.compare_exchange_strong(page, new_page,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+      page = new_page;
+    } else {
+      // Another thread got there first - page now holds its pointer.
+      delete new_page;
+    }
+  }
+  return &page->entries[(offset & ((1 << kPageSizeLog2) - 1)) >> 2];
+}
+
 Entry* EntryTable::Get(uint32_t address) {
-  auto global_lock = global_critical_region_.Acquire();
-  const auto& it = map_.find(address);
-  Entry* entry = it != map_.end() ? it->second : nullptr;
+  Entry* entry;
+  auto slot = GetSlot(address, false);
+  if (slot) {
+    entry = slot->load(std::memory_order_acquire);
+  } else {
+    auto global_lock = global_critical_region_.Acquire();
+    const auto& it = unpaged_map_.find(address);
+    entry = it != unpaged_map_.end() ? it->second : nullptr;
+  }
   if (entry) {
     // TODO(benvanik): wait if needed?
     if (entry->status != Entry::STATUS_READY) {
@@ -39,51 +108,66 @@ Entry* EntryTable::Get(uint32_t address) {
 }
 
 Entry::Status EntryTable::GetOrCreate(uint32_t address, Entry** out_entry) {
-  // TODO(benvanik): replace with a map with wait-free for find.
-  // https://github.com/facebook/folly/blob/master/folly/AtomicHashMap.h
+  auto slot = GetSlot(address, true);
+  if (!slot) {
+    return GetOrCreateUnpaged(address, out_entry);
+  }
 
-  auto global_lock = global_critical_region_.Acquire();
-  const auto& it = map_.find(address);
-  Entry* entry = it != map_.end() ? it->second : nullptr;
-  Entry::Status status;
-  if (entry) {
-    // If we aren't ready yet spin and wait.
-    if (entry->status == Entry::STATUS_COMPILING) {
-      // Still compiling, so spin.
-      do {
-        global_lock.unlock();
-        // TODO(benvanik): sleep for less time?
-        xe::threading::Sleep(std::chrono::microseconds(10));
-        global_lock.lock();
-      } while (entry->status == Entry::STATUS_COMPILING);
+  Entry* entry = slot->load(std::memory_order_acquire);
+  if (!entry) {
+    // Create and try to publish it. Whoever wins the exchange compiles, and
+    // everybody else waits on the winner's entry.
+    Entry* new_entry = CreateEntry(address);
+    if (slot->compare_exchange_strong(entry, new_entry,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+      *out_entry = new_entry;
+      return Entry::STATUS_NEW;
     }
-    status = entry->status;
-  } else {
+    delete new_entry;
+  }
+  *out_entry = entry;
+  return WaitForEntry(entry);
+}
+
+Entry::Status EntryTable::GetOrCreateUnpaged(uint32_t address,
+                                             Entry** out_entry) {
+  auto global_lock = global_critical_region_.Acquire();
+  const auto& it = unpaged_map_.find(address);
+  Entry* entry = it != unpaged_map_.end() ? it->second : nullptr;
+  if (!entry) {
     // Create and return for initialization.
-    entry = new Entry();
-    entry->address = address;
-    entry->end_address = 0;
-    entry->status = Entry::STATUS_COMPILING;
-    entry->function = 0;
-    map_[address] = entry;
-    status = Entry::STATUS_NEW;
+    entry = CreateEntry(address);
+    unpaged_map_[address] = entry;
+    *out_entry = entry;
+    return Entry::STATUS_NEW;
   }
   global_lock.unlock();
   *out_entry = entry;
-  return status;
+  return WaitForEntry(entry);
 }
 
 std::vector<Function*> EntryTable::FindWithAddress(uint32_t address) {
-  auto global_lock = global_critical_region_.Acquire();
   std::vector<Function*> fns;
-  for (auto& it : map_) {
-    Entry* entry = it.second;
-    if (address >= entry->address && address <= entry->end_address) {
-      if (entry->status == Entry::STATUS_READY) {
-        fns.push_back(entry->function);
-      }
+  auto check_entry = [address, &fns](Entry* entry) {
+    if (entry && entry->status == Entry::STATUS_READY &&
+        address >= entry->address && address <= entry->end_address) {
+      fns.push_back(entry->function);
+    }
+  };
+  for (uint32_t i = 0; i < kPageCount; ++i) {
+    Page* page = pages_[i].load(std::memory_order_acquire);
+    if (!page) {
+      continue;
+    }
+    for (uint32_t j = 0; j < kEntriesPerPage; ++j) {
+      check_entry(page->entries[j].load(std::memory_order_acquire));
     }
   }
+  auto global_lock = global_critical_region_.Acquire();
+  for (auto& it : unpaged_map_) {
+    check_entry(it.second);
+  }
   return fns;
 }
 
@@ -10,6 +10,7 @@
 #ifndef XENIA_CPU_ENTRY_TABLE_H_
 #define XENIA_CPU_ENTRY_TABLE_H_
 
+#include <atomic>
 #include <unordered_map>
 #include <vector>
 
@@ -30,10 +31,16 @@ typedef struct Entry_t {
 
   uint32_t address;
   uint32_t end_address;
-  Status status;
+  // Written last by the compiling thread, after function and end_address.
+  std::atomic<Status> status;
   Function* function;
 } Entry;
 
+// Maps guest function addresses to their entries.
+// Addresses in the guest code range are looked up in a two-level page table
+// without taking any locks, with entries published by compare-exchange so only
+// one thread ever gets STATUS_NEW for an address. Anything outside of the
+// range falls back to a map under the global lock.
 class EntryTable {
  public:
   EntryTable();
@@ -42,12 +49,32 @@ class EntryTable {
   Entry* Get(uint32_t address);
   Entry::Status GetOrCreate(uint32_t address, Entry** out_entry);
 
+  // Returns the ready functions whose range contains the address.
+  // This scans every slot of every allocated page, so it's O(table size) and
+  // must only be used off the hot path (breakpoints and the debugger).
   std::vector<Function*> FindWithAddress(uint32_t address);
 
  private:
+  static const uint32_t kCodeRangeBase = 0x80000000;
+  static const uint32_t kCodeRangeSize = 0x20000000;
+  static const uint32_t kPageSizeLog2 = 16;
+  static const uint32_t kPageCount = kCodeRangeSize >> kPageSizeLog2;
+  // Guest instructions are 4 byte aligned.
+  static const uint32_t kEntriesPerPage = (1 << kPageSizeLog2) >> 2;
+
+  struct Page {
+    std::atomic<Entry*> entries[kEntriesPerPage];
+  };
+
+  // Returns the slot for the address, allocating its page if needed, or
+  // nullptr if the address is not in the paged range.
+  std::atomic<Entry*>* GetSlot(uint32_t address, bool create);
+  Entry::Status GetOrCreateUnpaged(uint32_t address, Entry** out_entry);
+
+  std::atomic<Page*> pages_[kPageCount];
+
   xe::global_critical_region global_critical_region_;
-  // TODO(benvanik): replace with a better data structure.
-  std::unordered_map<uint32_t, Entry*> map_;
+  std::unordered_map<uint32_t, Entry*> unpaged_map_;
 };
 
 }  // namespace cpu
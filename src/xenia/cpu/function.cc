@@ -89,16 +89,21 @@ const SourceMapEntry* GuestFunction::LookupHIROffset(uint32_t offset) const {
   return nullptr;
 }
 
-const SourceMapEntry* GuestFunction::LookupMachineCodeOffset(
-    uint32_t offset) const {
+static const SourceMapEntry* FindMachineCodeOffset(
+    const std::vector<SourceMapEntry>& source_map, uint32_t offset) {
   // TODO(benvanik): binary search? We know the list is sorted by code order.
-  for (int64_t i = source_map_.size() - 1; i >= 0; --i) {
-    const auto& entry = source_map_[i];
+  for (int64_t i = source_map.size() - 1; i >= 0; --i) {
+    const auto& entry = source_map[i];
     if (entry.code_offset <= offset) {
       return &entry;
     }
   }
-  return source_map_.empty() ? nullptr : &source_map_[0];
+  return source_map.empty() ? nullptr : &source_map[0];
+}
+
+const SourceMapEntry* GuestFunction::LookupMachineCodeOffset(
+    uint32_t offset) const {
+  return FindMachineCodeOffset(source_map_, offset);
 }
 
 uint32_t GuestFunction::MapGuestAddressToMachineCodeOffset(
@@ -116,11 +121,30 @@ uintptr_t GuestFunction::MapGuestAddressToMachineCode(
 
 uint32_t GuestFunction::MapMachineCodeToGuestAddress(
     uintptr_t host_address) const {
+  for (auto& retired : retired_machine_code_) {
+    if (host_address >= retired.machine_code &&
+        host_address < retired.machine_code + retired.machine_code_length) {
+      auto entry = FindMachineCodeOffset(
+          retired.source_map,
+          static_cast<uint32_t>(host_address - retired.machine_code));
+      return entry ? entry->guest_address : address();
+    }
+  }
   auto entry = LookupMachineCodeOffset(static_cast<uint32_t>(
       host_address - reinterpret_cast<uintptr_t>(machine_code())));
   return entry ? entry->guest_address : address();
 }
 
+void GuestFunction::RetireMachineCode() {
+  if (!machine_code()) {
+    return;
+  }
+  retired_machine_code_.push_back({reinterpret_cast<uintptr_t>(machine_code()),
+                                   machine_code_length(),
+                                   std::move(source_map_)});
+  source_map_.clear();
+}
+
 bool GuestFunction::Call(ThreadState* thread_state, uint32_t return_address) {
   // SCOPE_profile_cpu_f("cpu");
 
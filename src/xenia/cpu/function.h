@@ -117,6 +117,24 @@ class GuestFunction : public Function {
   }
   FunctionTraceData& trace_data() { return trace_data_; }
   std::vector<SourceMapEntry>& source_map() { return source_map_; }
+  // Called before the machine code is replaced, such as when promoted to the
+  // optimized tier. The old code is never freed and may still be running, so
+  // its source map is kept for MapMachineCodeToGuestAddress.
+  void RetireMachineCode();
+
+  // See --tiered_compilation.
+  enum class Tier {
+    kUncompiled,
+    // Quickly compiled code counting its entries down in tier_up_counter,
+    // recompiled in the background once it reaches zero.
+    kBaseline,
+    kOptimized,
+  };
+  Tier tier() const { return tier_; }
+  void set_tier(Tier tier) { tier_ = tier; }
+  // Decremented by baseline code without synchronization, so a few entries
+  // may be lost to races - it's only a heuristic.
+  int32_t* tier_up_counter() { return &tier_up_counter_; }
 
   ExternHandler extern_handler() const { return extern_handler_; }
   Export* export_data() const { return export_data_; }
@@ -139,6 +157,14 @@ class GuestFunction : public Function {
   std::unique_ptr<FunctionDebugInfo> debug_info_;
   FunctionTraceData trace_data_;
   std::vector<SourceMapEntry> source_map_;
+  struct RetiredMachineCode {
+    uintptr_t machine_code;
+    size_t machine_code_length;
+    std::vector<SourceMapEntry> source_map;
+  };
+  std::vector<RetiredMachineCode> retired_machine_code_;
+  Tier tier_ = Tier::kUncompiled;
+  int32_t tier_up_counter_ = 0;
   ExternHandler extern_handler_ = nullptr;
   Export* export_data_ = nullptr;
 };
@@ -712,7 +712,6 @@ Value* HIRBuilder::AllocValue(TypeName type) {
   value->use_head = NULL;
   value->last_use = NULL;
   value->local_slot = NULL;
-  value->tag = NULL;
   value->reg.set = NULL;
   value->reg.index = -1;
   return value;
@@ -728,7 +727,6 @@ Value* HIRBuilder::CloneValue(Value* source) {
   value->use_head = NULL;
   value->last_use = NULL;
   value->local_slot = NULL;
-  value->tag = NULL;
   value->reg.set = NULL;
   value->reg.index = -1;
   return value;
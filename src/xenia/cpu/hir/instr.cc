@@ -23,7 +23,7 @@ void Instr::set_src1(Value* value) {
     src1.value->RemoveUse(src1_use);
   }
   src1.value = value;
-  src1_use = value ? value->AddUse(block->arena, this) : NULL;
+  src1_use = value ? value->AddUse(&use_storage[0], this) : NULL;
 }
 
 void Instr::set_src2(Value* value) {
@@ -34,7 +34,7 @@ void Instr::set_src2(Value* value) {
     src2.value->RemoveUse(src2_use);
   }
   src2.value = value;
-  src2_use = value ? value->AddUse(block->arena, this) : NULL;
+  src2_use = value ? value->AddUse(&use_storage[1], this) : NULL;
 }
 
 void Instr::set_src3(Value* value) {
@@ -45,7 +45,7 @@ void Instr::set_src3(Value* value) {
     src3.value->RemoveUse(src3_use);
   }
   src3.value = value;
-  src3_use = value ? value->AddUse(block->arena, this) : NULL;
+  src3_use = value ? value->AddUse(&use_storage[2], this) : NULL;
 }
 
 void Instr::MoveBefore(Instr* other) {
@@ -48,9 +48,13 @@ class Instr {
   Op src2;
   Op src3;
 
+  // Point into use_storage when the src is a value, null otherwise.
   Value::Use* src1_use;
   Value::Use* src2_use;
   Value::Use* src3_use;
+  // Use list entries of the srcs, kept with the instruction instead of being
+  // allocated on every set_src so that walking uses stays within it.
+  Value::Use use_storage[3];
 
   void set_src1(Value* value);
   void set_src2(Value* value);
@@ -37,6 +37,14 @@ enum RoundMode {
 
 enum LoadStoreFlags {
   LOAD_STORE_BYTE_SWAP = 1 << 0,
+  // Memory access narrower than the value. Loads are zero extended (or sign
+  // extended with LOAD_SIGN_EXTEND) and stores are truncated.
+  LOAD_STORE_MEMORY_I8 = 1 << 1,
+  LOAD_STORE_MEMORY_I16 = 1 << 2,
+  LOAD_STORE_MEMORY_I32 = 1 << 3,
+  LOAD_STORE_MEMORY_TYPE_MASK =
+      LOAD_STORE_MEMORY_I8 | LOAD_STORE_MEMORY_I16 | LOAD_STORE_MEMORY_I32,
+  LOAD_SIGN_EXTEND = 1 << 4,
 };
 
 enum CacheControlType {
@@ -103,10 +103,8 @@ class Value {
   Instr* last_use;
   Value* local_slot;
 
-  // TODO(benvanik): remove to shrink size.
-  void* tag;
-
-  Use* AddUse(Arena* arena, Instr* instr);
+  // Links a use owned by the instruction into the use list.
+  Use* AddUse(Use* use, Instr* instr);
   void RemoveUse(Use* use);
 
   void set_zero(TypeName new_type) {
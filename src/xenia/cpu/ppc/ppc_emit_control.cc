@@ -47,6 +47,21 @@ int InstrEmit_branch(PPCHIRBuilder& f, const char* src, uint64_t cia,
     call_flags |= CALL_TAIL;
   }
 
+  if (nia_is_lr && !lk && f.inline_return_label()) {
+    // Return from a callee inlined into the function. The link register is
+    // never changed by those, so this is always back to the caller.
+    if (cond) {
+      if (expect_true) {
+        f.BranchTrue(cond, f.inline_return_label());
+      } else {
+        f.BranchFalse(cond, f.inline_return_label());
+      }
+    } else {
+      f.Branch(f.inline_return_label());
+    }
+    return 0;
+  }
+
   // TODO(benvanik): set CALL_TAIL if !lk and the last block in the fn.
   //                 This is almost always a jump to restore gpr.
 
@@ -10,6 +10,8 @@
 #include "xenia/cpu/ppc/ppc_frontend.h"
 
 #include "xenia/base/atomic.h"
+#include "xenia/base/string.h"
+#include "xenia/cpu/cpu_flags.h"
 #include "xenia/cpu/ppc/ppc_context.h"
 #include "xenia/cpu/ppc/ppc_emit.h"
 #include "xenia/cpu/ppc/ppc_opcode_info.h"
@@ -43,11 +45,27 @@ void CleanupOnShutdown() {}
 
 PPCFrontend::PPCFrontend(Processor* processor) : processor_(processor) {
   InitializeIfNeeded();
+  if (cvars::log_jit_stats || !cvars::jit_stats_path.empty()) {
+    compiler_stats_ = std::make_unique<compiler::CompilerStats>();
+  }
 }
 
 PPCFrontend::~PPCFrontend() {
   // Force cleanup now before we deinit.
+  // Translators report their pass counters to the stats when destroyed.
   translator_pool_.Reset();
+
+  if (compiler_stats_) {
+    if (processor_->backend()) {
+      processor_->backend()->ReportStats(compiler_stats_.get());
+    }
+    if (cvars::log_jit_stats) {
+      compiler_stats_->Dump();
+    }
+    if (!cvars::jit_stats_path.empty()) {
+      compiler_stats_->WriteJson(xe::to_wstring(cvars::jit_stats_path));
+    }
+  }
 }
 
 Memory* PPCFrontend::memory() const { return processor_->memory(); }
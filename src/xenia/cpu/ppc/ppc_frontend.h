@@ -13,6 +13,7 @@
 #include <memory>
 
 #include "xenia/base/type_pool.h"
+#include "xenia/cpu/compiler/compiler_stats.h"
 #include "xenia/cpu/function.h"
 #include "xenia/memory.h"
 
@@ -45,6 +46,10 @@ class PPCFrontend {
   Processor* processor() const { return processor_; }
   Memory* memory() const;
   PPCBuiltins* builtins() { return &builtins_; }
+  // Null unless JIT stats are enabled.
+  compiler::CompilerStats* compiler_stats() const {
+    return compiler_stats_.get();
+  }
 
   bool DeclareFunction(GuestFunction* function);
   bool DefineFunction(GuestFunction* function, uint32_t debug_info_flags);
@@ -53,6 +58,7 @@ class PPCFrontend {
   Processor* processor_;
   PPCBuiltins builtins_ = {0};
   TypePool<PPCTranslator, PPCFrontend*> translator_pool_;
+  std::unique_ptr<compiler::CompilerStats> compiler_stats_;
 };
 
 }  // namespace ppc
@@ -68,15 +68,15 @@ void PPCHIRBuilder::Reset() {
   instr_count_ = 0;
   instr_offset_list_ = NULL;
   label_list_ = NULL;
+  inline_return_label_ = nullptr;
   with_debug_info_ = false;
   HIRBuilder::Reset();
 }
 
-bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
+bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags,
+                         const std::vector<InlineCall>& inline_calls) {
   SCOPE_profile_cpu_f("cpu");
 
-  Memory* memory = frontend_->memory();
-
   function_ = function;
   start_address_ = function_->address();
   instr_count_ = (function_->end_address() - function_->address()) / 4 + 1;
@@ -103,82 +103,140 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
   // Always mark entry with label.
   label_list_[0] = NewLabel();
 
+  auto inline_call = inline_calls.begin();
   uint32_t start_address = function_->address();
   uint32_t end_address = function_->end_address();
   for (uint32_t address = start_address, offset = 0; address <= end_address;
        address += 4, offset++) {
-    trace_info_.dest_count = 0;
-    uint32_t code =
-        xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
-    auto opcode = LookupOpcode(code);
-    auto& opcode_info = GetOpcodeInfo(opcode);
-
-    // Mark label, if we were assigned one earlier on in the walk.
-    // We may still get a label, but it'll be inserted by LookupLabel
-    // as needed.
-    Label* label = label_list_[offset];
-    if (label) {
-      MarkLabel(label);
+    if (inline_call != inline_calls.end() &&
+        inline_call->call_address == address) {
+      EmitInlineCall(*inline_call, offset);
+      ++inline_call;
+      continue;
     }
+    EmitInstruction(address, offset);
+  }
 
-    Instr* first_instr = 0;
-    if (with_debug_info_) {
-      if (label) {
-        AnnotateLabel(address, label);
-      }
-      comment_buffer_.Reset();
-      comment_buffer_.AppendFormat("%.8X %.8X ", address, code);
-      DisasmPPC(address, code, &comment_buffer_);
-      Comment(comment_buffer_);
-      first_instr = last_instr();
-    }
+  if (false) {
+    DumpAllOpcodeCounts();
+  }
 
-    // Mark source offset for debugging.
-    // We could omit this if we never wanted to debug.
-    SourceOffset(address);
-    if (!first_instr) {
-      first_instr = last_instr();
-    }
+  return Finalize();
+}
 
-    // Stash instruction offset. It's either the SOURCE_OFFSET or the COMMENT.
-    instr_offset_list_[offset] = first_instr;
+void PPCHIRBuilder::EmitInstruction(uint32_t address, uint32_t offset) {
+  Memory* memory = frontend_->memory();
 
-    if (opcode == PPCOpcode::kInvalid) {
-      XELOGE("Invalid instruction %.8llX %.8X", address, code);
-      Comment("INVALID!");
-      // TraceInvalidInstruction(i);
-      continue;
-    }
-    ++opcode_translation_counts[static_cast<int>(opcode)];
+  trace_info_.dest_count = 0;
+  uint32_t code =
+      xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
+  auto opcode = LookupOpcode(code);
+  auto& opcode_info = GetOpcodeInfo(opcode);
 
-    // Synchronize the PPC context as required.
-    // This will ensure all registers are saved to the PPC context before this
-    // instruction executes.
-    if (opcode_info.type == PPCOpcodeType::kSync) {
-      ContextBarrier();
-    }
+  BeginInstruction(address, offset, code);
 
-    MaybeBreakOnInstruction(address);
-
-    InstrData i;
-    i.address = address;
-    i.code = code;
-    i.opcode = opcode;
-    i.opcode_info = &opcode_info;
-    if (!opcode_info.emit || opcode_info.emit(*this, i)) {
-      auto& disasm_info = GetOpcodeDisasmInfo(opcode);
-      XELOGE("Unimplemented instr %.8llX %.8X %s", address, code,
-             disasm_info.name);
-      Comment("UNIMPLEMENTED!");
-      DebugBreak();
+  if (opcode == PPCOpcode::kInvalid) {
+    XELOGE("Invalid instruction %.8llX %.8X", address, code);
+    Comment("INVALID!");
+    // TraceInvalidInstruction(i);
+    return;
+  }
+  ++opcode_translation_counts[static_cast<int>(opcode)];
+
+  // Synchronize the PPC context as required.
+  // This will ensure all registers are saved to the PPC context before this
+  // instruction executes.
+  if (opcode_info.type == PPCOpcodeType::kSync) {
+    ContextBarrier();
+  }
+
+  MaybeBreakOnInstruction(address);
+
+  InstrData i;
+  i.address = address;
+  i.code = code;
+  i.opcode = opcode;
+  i.opcode_info = &opcode_info;
+  if (!opcode_info.emit || opcode_info.emit(*this, i)) {
+    auto& disasm_info = GetOpcodeDisasmInfo(opcode);
+    XELOGE("Unimplemented instr %.8llX %.8X %s", address, code,
+           disasm_info.name);
+    Comment("UNIMPLEMENTED!");
+    DebugBreak();
+  }
+}
+
+void PPCHIRBuilder::BeginInstruction(uint32_t address, uint32_t offset,
+                                     uint32_t code) {
+  // Mark label, if we were assigned one earlier on in the walk.
+  // We may still get a label, but it'll be inserted by LookupLabel
+  // as needed.
+  Label* label = label_list_[offset];
+  if (label) {
+    MarkLabel(label);
+  }
+
+  Instr* first_instr = 0;
+  if (with_debug_info_) {
+    if (label) {
+      AnnotateLabel(address, label);
     }
+    comment_buffer_.Reset();
+    comment_buffer_.AppendFormat("%.8X %.8X ", address, code);
+    DisasmPPC(address, code, &comment_buffer_);
+    Comment(comment_buffer_);
+    first_instr = last_instr();
   }
 
-  if (false) {
-    DumpAllOpcodeCounts();
+  // Mark source offset for debugging.
+  // We could omit this if we never wanted to debug.
+  SourceOffset(address);
+  if (!first_instr) {
+    first_instr = last_instr();
   }
 
-  return Finalize();
+  // Stash instruction offset. It's either the SOURCE_OFFSET or the COMMENT.
+  instr_offset_list_[offset] = first_instr;
+}
+
+void PPCHIRBuilder::EmitInlineCall(const InlineCall& call, uint32_t offset) {
+  // The bl itself. The link register is set as usual, but there's no return
+  // address to pass as nothing is called.
+  Memory* memory = frontend_->memory();
+  trace_info_.dest_count = 0;
+  BeginInstruction(call.call_address, offset,
+                   xe::load_and_swap<uint32_t>(
+                       memory->TranslateVirtual(call.call_address)));
+  MaybeBreakOnInstruction(call.call_address);
+  StoreLR(LoadConstantUint64(call.call_address + 4));
+
+  // The callee is emitted like a function of its own, with branches within
+  // it resolved against its own labels and returns going to the instruction
+  // after the bl.
+  uint64_t caller_start_address = start_address_;
+  uint64_t caller_instr_count = instr_count_;
+  Instr** caller_instr_offset_list = instr_offset_list_;
+  Label** caller_label_list = label_list_;
+  start_address_ = call.start_address;
+  instr_count_ = (call.end_address - call.start_address) / 4 + 1;
+  size_t list_size = instr_count_ * sizeof(void*);
+  instr_offset_list_ = (Instr**)arena_->Alloc(list_size);
+  label_list_ = (Label**)arena_->Alloc(list_size);
+  std::memset(instr_offset_list_, 0, list_size);
+  std::memset(label_list_, 0, list_size);
+  inline_return_label_ = NewLabel();
+
+  for (uint32_t address = call.start_address, callee_offset = 0;
+       address <= call.end_address; address += 4, callee_offset++) {
+    EmitInstruction(address, callee_offset);
+  }
+
+  MarkLabel(inline_return_label_);
+  inline_return_label_ = nullptr;
+  start_address_ = caller_start_address;
+  instr_count_ = caller_instr_count;
+  instr_offset_list_ = caller_instr_offset_list;
+  label_list_ = caller_label_list;
 }
 
 void PPCHIRBuilder::MaybeBreakOnInstruction(uint32_t address) {
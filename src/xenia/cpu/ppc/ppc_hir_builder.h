@@ -10,6 +10,8 @@
 #ifndef XENIA_CPU_PPC_PPC_HIR_BUILDER_H_
 #define XENIA_CPU_PPC_PPC_HIR_BUILDER_H_
 
+#include <vector>
+
 #include "xenia/base/string_buffer.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/hir/hir_builder.h"
@@ -38,9 +40,20 @@ class PPCHIRBuilder : public hir::HIRBuilder {
     // Emit comment nodes.
     EMIT_DEBUG_COMMENTS = 1 << 0,
   };
-  bool Emit(GuestFunction* function, uint32_t flags);
+  // A bl whose callee is emitted in place of the call.
+  struct InlineCall {
+    uint32_t call_address;
+    // Callee extents, the end being its final blr.
+    uint32_t start_address;
+    uint32_t end_address;
+  };
+  // inline_calls must be sorted by call address.
+  bool Emit(GuestFunction* function, uint32_t flags,
+            const std::vector<InlineCall>& inline_calls = {});
 
   GuestFunction* function() const { return function_; }
+  // Where returns go while emitting an inlined callee, otherwise nullptr.
+  Label* inline_return_label() const { return inline_return_label_; }
   Function* LookupFunction(uint32_t address);
   Label* LookupLabel(uint32_t address);
 
@@ -82,6 +95,10 @@ class PPCHIRBuilder : public hir::HIRBuilder {
   Value* LoadReserved();
 
  private:
+  void EmitInstruction(uint32_t address, uint32_t offset);
+  void EmitInlineCall(const InlineCall& call, uint32_t offset);
+  // Labels the instruction and marks its source offset.
+  void BeginInstruction(uint32_t address, uint32_t offset, uint32_t code);
   void MaybeBreakOnInstruction(uint32_t address);
   void AnnotateLabel(uint32_t address, Label* label);
 
@@ -97,6 +114,7 @@ class PPCHIRBuilder : public hir::HIRBuilder {
   uint64_t instr_count_;
   Instr** instr_offset_list_;
   Label** label_list_;
+  Label* inline_return_label_;
 
   // Reset each instruction.
   struct {
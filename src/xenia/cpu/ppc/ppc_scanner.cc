@@ -361,6 +361,74 @@ std::vector<BlockInfo> PPCScanner::FindBlocks(GuestFunction* function) {
   return blocks;
 }
 
+std::vector<uint32_t> PPCScanner::FindCallTargets(GuestFunction* function) {
+  Memory* memory = frontend_->memory();
+
+  std::vector<uint32_t> targets;
+  uint32_t start_address = function->address();
+  uint32_t end_address = function->end_address();
+  for (uint32_t address = start_address; address <= end_address; address += 4) {
+    uint32_t code =
+        xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
+    if (LookupOpcode(code) != PPCOpcode::bx) {
+      continue;
+    }
+    PPCDecodeData d;
+    d.address = address;
+    d.code = code;
+    if (d.I.LK()) {
+      targets.push_back(d.I.ADDR());
+    }
+  }
+  std::sort(targets.begin(), targets.end());
+  targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  return targets;
+}
+
+uint32_t PPCScanner::FindInlineableExtent(uint32_t address,
+                                          uint32_t max_instr_count) {
+  Memory* memory = frontend_->memory();
+
+  uint32_t start_address = address;
+  uint32_t furthest_target = start_address;
+  for (uint32_t n = 0; n < max_instr_count; ++n, address += 4) {
+    uint32_t code =
+        xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
+    auto opcode = LookupOpcode(code);
+    if (!code || opcode == PPCOpcode::kInvalid) {
+      return 0;
+    }
+    PPCDecodeData d;
+    d.address = address;
+    d.code = code;
+    if (opcode == PPCOpcode::bx || opcode == PPCOpcode::bcx) {
+      uint32_t target = opcode == PPCOpcode::bx ? d.I.ADDR() : d.B.ADDR();
+      if ((opcode == PPCOpcode::bx ? d.I.LK() : d.B.LK()) ||
+          target < start_address) {
+        // Calls out or tail calls.
+        return 0;
+      }
+      // Checked against the end once it's found.
+      furthest_target = std::max(furthest_target, target);
+    } else if (opcode == PPCOpcode::bclrx) {
+      if (d.XL.LK()) {
+        return 0;
+      }
+      if (code == 0x4E800020 && furthest_target <= address) {
+        return address;
+      }
+    } else if (opcode == PPCOpcode::bcctrx || opcode == PPCOpcode::sc) {
+      return 0;
+    } else if (opcode == PPCOpcode::mtspr &&
+               (((d.XFX.SPR() & 0x1F) << 5) | ((d.XFX.SPR() >> 5) & 0x1F)) ==
+                   8) {
+      // mtlr - the return goes somewhere else (__restgprlr_*, longjmp).
+      return 0;
+    }
+  }
+  return 0;
+}
+
 }  // namespace ppc
 }  // namespace cpu
 }  // namespace xe
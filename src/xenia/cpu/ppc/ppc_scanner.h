@@ -35,6 +35,15 @@ class PPCScanner {
 
   std::vector<BlockInfo> FindBlocks(GuestFunction* function);
 
+  // Returns the targets of all bl/bla instructions in the (scanned) function.
+  std::vector<uint32_t> FindCallTargets(GuestFunction* function);
+
+  // Returns the address of the final blr of the function at address if it's
+  // a leaf function of at most max_instr_count instructions that only
+  // branches within itself and returns to the link register it was called
+  // with, or 0 if it can't be inlined into its callers.
+  uint32_t FindInlineableExtent(uint32_t address, uint32_t max_instr_count);
+
  private:
   bool IsRestGprLr(uint32_t address);
 
@@ -9,13 +9,17 @@
 
 #include "xenia/cpu/ppc/ppc_translator.h"
 
+#include <algorithm>
+
 #include "xenia/base/assert.h"
 #include "xenia/base/byte_order.h"
+#include "xenia/base/clock.h"
 #include "xenia/base/memory.h"
 #include "xenia/base/profiling.h"
 #include "xenia/base/reset_scope.h"
 #include "xenia/cpu/compiler/compiler_passes.h"
 #include "xenia/cpu/cpu_flags.h"
+#include "xenia/cpu/ppc/ppc_decode_data.h"
 #include "xenia/cpu/ppc/ppc_frontend.h"
 #include "xenia/cpu/ppc/ppc_hir_builder.h"
 #include "xenia/cpu/ppc/ppc_opcode_info.h"
@@ -36,6 +40,7 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
   scanner_.reset(new PPCScanner(frontend));
   builder_.reset(new PPCHIRBuilder(frontend));
   compiler_.reset(new Compiler(frontend->processor()));
+  compiler_->set_stats(frontend->compiler_stats());
   assembler_ = backend->CreateAssembler();
   assembler_->Initialize();
 
@@ -52,13 +57,18 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
   compiler_->AddPass(std::make_unique<passes::ContextPromotionPass>());
   if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
 
-  // Grouped simplification + constant propagation.
+  // Grouped simplification + constant propagation, including constants stored
+  // to the context in other blocks.
   // Loops until no changes are made.
   auto sap = std::make_unique<passes::ConditionalGroupPass>();
+  sap->AddPass(std::make_unique<passes::TypePropagationPass>());
+  if (validate) sap->AddPass(std::make_unique<passes::ValidationPass>());
   sap->AddPass(std::make_unique<passes::SimplificationPass>());
   if (validate) sap->AddPass(std::make_unique<passes::ValidationPass>());
   sap->AddPass(std::make_unique<passes::ConstantPropagationPass>());
   if (validate) sap->AddPass(std::make_unique<passes::ValidationPass>());
+  sap->AddPass(std::make_unique<passes::ContextConstantPropagationPass>());
+  if (validate) sap->AddPass(std::make_unique<passes::ValidationPass>());
   compiler_->AddPass(std::move(sap));
 
   if (backend->machine_info()->supports_extended_load_store) {
@@ -71,9 +81,8 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
   }
   compiler_->AddPass(std::make_unique<passes::SimplificationPass>());
   if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
-  // compiler_->AddPass(std::make_unique<passes::DeadStoreEliminationPass>());
-  // if (validate)
-  // compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+  compiler_->AddPass(std::make_unique<passes::DeadStoreEliminationPass>());
+  if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
   compiler_->AddPass(std::make_unique<passes::DeadCodeEliminationPass>());
   if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
 
@@ -85,23 +94,119 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
   // Will modify the HIR to add loads/stores.
   // This should be the last pass before finalization, as after this all
   // registers are assigned and ready to be emitted.
-  compiler_->AddPass(std::make_unique<passes::RegisterAllocationPass>(
-      backend->machine_info()));
+  if (cvars::linear_scan_register_allocation) {
+    compiler_->AddPass(
+        std::make_unique<passes::LinearScanRegisterAllocationPass>(
+            backend->machine_info()));
+  } else {
+    compiler_->AddPass(std::make_unique<passes::RegisterAllocationPass>(
+        backend->machine_info()));
+  }
   if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
 
   // Must come last. The HIR is not really HIR after this.
   compiler_->AddPass(std::make_unique<passes::FinalizationPass>());
+
+  if (cvars::tiered_compilation) {
+    // Only what the backend needs, plus dead code elimination as it's cheap
+    // and saves the register allocator work.
+    baseline_compiler_.reset(new Compiler(frontend->processor()));
+    baseline_compiler_->set_stats(frontend->compiler_stats());
+    baseline_compiler_->AddPass(
+        std::make_unique<passes::ConstantPropagationPass>());
+    if (validate) {
+      baseline_compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+    }
+    baseline_compiler_->AddPass(
+        std::make_unique<passes::DeadCodeEliminationPass>());
+    if (validate) {
+      baseline_compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+    }
+    baseline_compiler_->AddPass(
+        std::make_unique<passes::RegisterAllocationPass>(
+            backend->machine_info()));
+    if (validate) {
+      baseline_compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+    }
+    baseline_compiler_->AddPass(std::make_unique<passes::FinalizationPass>());
+  }
 }
 
 PPCTranslator::~PPCTranslator() = default;
 
+namespace {
+uint32_t CountInstrs(hir::HIRBuilder* builder, uint32_t* block_count) {
+  uint32_t instr_count = 0;
+  *block_count = 0;
+  for (auto block = builder->first_block(); block; block = block->next) {
+    ++*block_count;
+    for (auto instr = block->instr_head; instr; instr = instr->next) {
+      ++instr_count;
+    }
+  }
+  return instr_count;
+}
+
+// Callee instructions inlined into a single function.
+const uint32_t kMaxInlinedInstrCount = 256;
+
+// Finds the bl instructions of the (scanned) function whose callees can be
+// emitted in their place.
+std::vector<PPCHIRBuilder::InlineCall> FindInlineCalls(
+    PPCFrontend* frontend, PPCScanner* scanner, GuestFunction* function) {
+  Memory* memory = frontend->memory();
+
+  std::vector<PPCHIRBuilder::InlineCall> inline_calls;
+  uint32_t inlined_instr_count = 0;
+  for (uint32_t address = function->address();
+       address <= function->end_address(); address += 4) {
+    uint32_t code =
+        xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
+    if (LookupOpcode(code) != PPCOpcode::bx) {
+      continue;
+    }
+    PPCDecodeData d;
+    d.address = address;
+    d.code = code;
+    uint32_t target = d.I.ADDR();
+    if (!d.I.LK() || target == function->address()) {
+      continue;
+    }
+    // Imports and the like have behavior of their own.
+    auto callee = frontend->processor()->LookupFunction(target);
+    if (!callee || (callee->behavior() != Function::Behavior::kDefault &&
+                    callee->behavior() != Function::Behavior::kProlog &&
+                    callee->behavior() != Function::Behavior::kEpilog)) {
+      continue;
+    }
+    uint32_t end_address = scanner->FindInlineableExtent(
+        target, uint32_t(std::max(cvars::inline_max_guest_instrs, 0)));
+    if (!end_address) {
+      continue;
+    }
+    uint32_t instr_count = (end_address - target) / 4 + 1;
+    if (inlined_instr_count + instr_count > kMaxInlinedInstrCount) {
+      break;
+    }
+    inlined_instr_count += instr_count;
+    inline_calls.push_back({address, target, end_address});
+  }
+  return inline_calls;
+}
+}  // namespace
+
 bool PPCTranslator::Translate(GuestFunction* function,
                               uint32_t debug_info_flags) {
   SCOPE_profile_cpu_f("cpu");
 
+  auto stats = frontend_->compiler_stats();
+  uint64_t start_ticks = stats ? Clock::QueryHostTickCount() : 0;
+  compiler::CompilerStats::FunctionStats function_stats = {};
+
   // Reset() all caching when we leave.
   xe::make_reset_scope(builder_);
   xe::make_reset_scope(compiler_);
+  xe::make_reset_scope(baseline_compiler_);
   xe::make_reset_scope(assembler_);
   xe::make_reset_scope(&string_buffer_);
 
@@ -131,6 +236,26 @@ bool PPCTranslator::Translate(GuestFunction* function,
     return false;
   }
 
+  // Reuse the code generated in a previous execution, if it's still valid.
+  if (!debug_info_flags &&
+      frontend_->processor()->backend()->RestoreFunction(function)) {
+    function->set_tier(GuestFunction::Tier::kOptimized);
+    return true;
+  }
+
+  // Cold code is compiled quickly and only optimized once it turns out to be
+  // hot. Functions that were baseline are being promoted by the processor.
+  bool promoted = function->tier() == GuestFunction::Tier::kBaseline;
+  bool baseline = baseline_compiler_ && !debug_info_flags &&
+                  function->tier() == GuestFunction::Tier::kUncompiled;
+  if (baseline) {
+    *function->tier_up_counter() = std::max(cvars::tier_up_threshold, 1);
+    function->set_tier(GuestFunction::Tier::kBaseline);
+  } else {
+    function->set_tier(GuestFunction::Tier::kOptimized);
+  }
+  Compiler* compiler = baseline ? baseline_compiler_.get() : compiler_.get();
+
   // Setup trace data, if needed.
   if (debug_info_flags & DebugInfoFlags::kDebugInfoTraceFunctions) {
     // Base trace data.
@@ -164,10 +289,20 @@ bool PPCTranslator::Translate(GuestFunction* function,
   if (debug_info) {
     emit_flags |= PPCHIRBuilder::EMIT_DEBUG_COMMENTS;
   }
-  if (!builder_->Emit(function, emit_flags)) {
+  std::vector<PPCHIRBuilder::InlineCall> inline_calls;
+  if (cvars::inline_guest_calls && !debug_info_flags && !baseline) {
+    inline_calls = FindInlineCalls(frontend_, scanner_.get(), function);
+  }
+  if (!builder_->Emit(function, emit_flags, inline_calls)) {
     return false;
   }
 
+  if (stats) {
+    uint32_t block_count;
+    function_stats.raw_hir_instr_count =
+        CountInstrs(builder_.get(), &block_count);
+  }
+
   // Stash raw HIR.
   if (debug_info_flags & DebugInfoFlags::kDebugInfoDisasmRawHir) {
     builder_->Dump(&string_buffer_);
@@ -176,10 +311,16 @@ bool PPCTranslator::Translate(GuestFunction* function,
   }
 
   // Compile/optimize/etc.
-  if (!compiler_->Compile(builder_.get())) {
+  if (!compiler->Compile(builder_.get())) {
     return false;
   }
 
+  if (stats) {
+    function_stats.hir_instr_count =
+        CountInstrs(builder_.get(), &function_stats.hir_block_count);
+    function_stats.hir_value_count = builder_->max_value_ordinal();
+  }
+
   // Stash optimized HIR.
   if (debug_info_flags & DebugInfoFlags::kDebugInfoDisasmHir) {
     builder_->Dump(&string_buffer_);
@@ -193,6 +334,18 @@ bool PPCTranslator::Translate(GuestFunction* function,
     return false;
   }
 
+  if (stats) {
+    function_stats.address = function->address();
+    function_stats.inlined_call_count = uint32_t(inline_calls.size());
+    function_stats.baseline = baseline;
+    function_stats.promoted = promoted;
+    function_stats.guest_instr_count =
+        (function->end_address() - function->address()) / 4 + 1;
+    function_stats.code_size = function->machine_code_length();
+    function_stats.ticks = Clock::QueryHostTickCount() - start_ticks;
+    stats->AddFunction(function_stats, compiler->pass_runs());
+  }
+
   return true;
 }
 
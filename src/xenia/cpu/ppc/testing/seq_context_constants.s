@@ -0,0 +1,42 @@
+test_context_constants_1:
+  # r5 is only set before the loop.
+  li r3, 0
+  li r4, 5
+  li r5, 3
+  mtspr ctr, r4
+context_constants_1_loop:
+  add r3, r3, r5
+  bdnz context_constants_1_loop
+  blr
+  #_ REGISTER_OUT r3 15
+  #_ REGISTER_OUT r4 5
+  #_ REGISTER_OUT r5 3
+
+test_context_constants_2:
+  # r4 holds different constants on the two incoming paths.
+  #_ REGISTER_IN r3 1
+  li r4, 10
+  cmpwi r3, 0
+  beq context_constants_2_merge
+  li r4, 20
+context_constants_2_merge:
+  addi r5, r4, 1
+  blr
+  #_ REGISTER_OUT r3 1
+  #_ REGISTER_OUT r4 20
+  #_ REGISTER_OUT r5 21
+
+test_context_constants_3:
+  # r4 is changed inside the loop after the first iteration.
+  li r3, 0
+  li r4, 1
+  li r5, 3
+  mtspr ctr, r5
+context_constants_3_loop:
+  add r3, r3, r4
+  li r4, 2
+  bdnz context_constants_3_loop
+  blr
+  #_ REGISTER_OUT r3 5
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 3
@@ -0,0 +1,55 @@
+test_dead_context_stores_1:
+  # cr1 from the first compare is overwritten on both paths.
+  #_ REGISTER_IN r3 1
+  #_ REGISTER_IN r4 2
+  li r5, 0
+  cmpw cr1, r3, r4
+  cmpwi r3, 0
+  beq dead_context_stores_1_equal
+  cmpw cr1, r4, r3
+  b dead_context_stores_1_done
+dead_context_stores_1_equal:
+  cmpw cr1, r3, r3
+dead_context_stores_1_done:
+  bng cr1, dead_context_stores_1_end
+  li r5, 1
+dead_context_stores_1_end:
+  blr
+  #_ REGISTER_OUT r3 1
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 1
+
+test_dead_context_stores_2:
+  # cr1 from the first compare is still live on the taken path.
+  #_ REGISTER_IN r3 0
+  #_ REGISTER_IN r4 2
+  li r5, 0
+  cmpw cr1, r3, r4
+  cmpwi r3, 0
+  beq dead_context_stores_2_skip
+  cmpw cr1, r4, r3
+dead_context_stores_2_skip:
+  bnl cr1, dead_context_stores_2_end
+  li r5, 1
+dead_context_stores_2_end:
+  blr
+  #_ REGISTER_OUT r3 0
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 1
+
+test_dead_context_stores_3:
+  # r5 from the add is overwritten on both paths, the taken one included.
+  #_ REGISTER_IN r3 0
+  #_ REGISTER_IN r4 2
+  add r5, r3, r4
+  cmpwi r3, 0
+  beq dead_context_stores_3_equal
+  li r5, 7
+  b dead_context_stores_3_done
+dead_context_stores_3_equal:
+  li r5, 9
+dead_context_stores_3_done:
+  blr
+  #_ REGISTER_OUT r3 0
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 9
@@ -0,0 +1,49 @@
+inline_calls_sum:
+  # r3 = r4 + (r4 - 1) + ... + 1, leaf with an early return and a loop.
+  li r3, 0
+  cmpwi r4, 0
+  beqlr
+inline_calls_sum_loop:
+  add r3, r3, r4
+  addic. r4, r4, -1
+  bne inline_calls_sum_loop
+  blr
+
+inline_calls_get_lr:
+  mfspr r3, lr
+  blr
+
+test_inline_calls_1:
+  #_ REGISTER_IN r4 4
+  mfspr r12, lr
+  bl inline_calls_sum
+  mtspr lr, r12
+  blr
+  #_ REGISTER_OUT r3 10
+  #_ REGISTER_OUT r4 0
+
+test_inline_calls_2:
+  # Early return.
+  #_ REGISTER_IN r4 0
+  mfspr r12, lr
+  bl inline_calls_sum
+  mtspr lr, r12
+  blr
+  #_ REGISTER_OUT r3 0
+  #_ REGISTER_OUT r4 0
+
+test_inline_calls_3:
+  # The callee sees the link register set by the bl.
+  mfspr r12, lr
+  bl inline_calls_get_lr
+inline_calls_3_return:
+  lis r4, inline_calls_3_return@h
+  ori r4, r4, inline_calls_3_return@l
+  cmplw r3, r4
+  li r3, 0
+  bne inline_calls_3_done
+  li r3, 1
+inline_calls_3_done:
+  mtspr lr, r12
+  blr
+  #_ REGISTER_OUT r3 1
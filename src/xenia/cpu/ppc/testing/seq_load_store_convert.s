@@ -0,0 +1,33 @@
+test_load_store_convert_1:
+  # Extending loads, with and without byte reversal.
+  #_ MEMORY_IN 10001000 80 81 82 83 84 85 86 87
+  #_ REGISTER_IN r4 0x10001000
+  lbz r3, 0(r4)
+  lhz r5, 0(r4)
+  lha r6, 0(r4)
+  lwz r7, 4(r4)
+  lwa r8, 4(r4)
+  lhbrx r9, r0, r4
+  lwbrx r10, r0, r4
+  blr
+  #_ REGISTER_OUT r3 0x80
+  #_ REGISTER_OUT r4 0x10001000
+  #_ REGISTER_OUT r5 0x8081
+  #_ REGISTER_OUT r6 0xFFFFFFFFFFFF8081
+  #_ REGISTER_OUT r7 0x84858687
+  #_ REGISTER_OUT r8 0xFFFFFFFF84858687
+  #_ REGISTER_OUT r9 0x8180
+  #_ REGISTER_OUT r10 0x83828180
+
+test_load_store_convert_2:
+  # Truncating stores.
+  #_ MEMORY_IN 10001000 00 00 00 00 00 00 00 00
+  #_ REGISTER_IN r4 0x10001000
+  #_ REGISTER_IN r5 0x0123456789ABCDEF
+  stb r5, 0(r4)
+  sth r5, 2(r4)
+  stw r5, 4(r4)
+  blr
+  #_ REGISTER_OUT r4 0x10001000
+  #_ REGISTER_OUT r5 0x0123456789ABCDEF
+  #_ MEMORY_OUT 10001000 EF 00 CD EF 89 AB CD EF
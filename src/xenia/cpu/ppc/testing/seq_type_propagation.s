@@ -0,0 +1,15 @@
+test_type_propagation_1:
+  # Word ops on the low half of doubleword registers.
+  #_ REGISTER_IN r4 0xFFFFFFFF123456F8
+  rlwinm r3, r4, 0, 16, 23
+  clrlwi r6, r4, 24
+  extsb r7, r6
+  extsw r8, r4
+  slwi r9, r4, 8
+  blr
+  #_ REGISTER_OUT r3 0x5600
+  #_ REGISTER_OUT r4 0xFFFFFFFF123456F8
+  #_ REGISTER_OUT r6 0xF8
+  #_ REGISTER_OUT r7 0xFFFFFFFFFFFFFFF8
+  #_ REGISTER_OUT r8 0x123456F8
+  #_ REGISTER_OUT r9 0x3456F800
@@ -9,6 +9,7 @@ project("xenia-cpu")
   links({
     "xenia-base",
     "mspack",
+    "xxhash",
   })
   includedirs({
     project_root.."/third_party/llvm/include",
@@ -19,6 +20,60 @@ project("xenia-cpu")
   local_platform_files("compiler/passes")
   local_platform_files("hir")
   local_platform_files("ppc")
+  removefiles({"translate_all_main.cc"})
+
+group("src")
+project("xenia-cpu-translate-all")
+  uuid("6c8c3f5e-7d41-4d0a-9a3e-2b8f1e5d7c90")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "aes_128",
+    "capstone",
+    "dxbc",
+    "glslang-spirv",
+    "imgui",
+    "libavcodec",
+    "libavutil",
+    "mspack",
+    "snappy",
+    "spirv-tools",
+    "volk",
+    "xenia-apu",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-cpu-backend-x64",
+    "xenia-gpu",
+    "xenia-hid",
+    "xenia-kernel",
+    "xenia-ui",
+    "xenia-ui-spirv",
+    "xenia-vfs",
+    "xxhash",
+  })
+  defines({
+  })
+  includedirs({
+    project_root.."/third_party/llvm/include",
+  })
+  files({
+    "translate_all_main.cc",
+    "../base/main_"..platform_suffix..".cc",
+  })
+
+  filter("platforms:Linux")
+    links({
+      "X11",
+      "xcb",
+      "X11-xcb",
+      "vulkan",
+    })
+
+  filter("platforms:Windows")
+    links({
+      "psapi",
+    })
 
 include("testing")
 include("ppc/testing")
@@ -9,6 +9,9 @@
 
 #include "xenia/cpu/processor.h"
 
+#include <algorithm>
+
+#include "third_party/xxhash/xxhash.h"
 #include "xenia/base/assert.h"
 #include "xenia/base/atomic.h"
 #include "xenia/base/byte_order.h"
@@ -26,9 +29,11 @@
 #include "xenia/cpu/module.h"
 #include "xenia/cpu/ppc/ppc_decode_data.h"
 #include "xenia/cpu/ppc/ppc_frontend.h"
+#include "xenia/cpu/sampling_profiler.h"
 #include "xenia/cpu/stack_walker.h"
 #include "xenia/cpu/thread.h"
 #include "xenia/cpu/thread_state.h"
+#include "xenia/cpu/tier_up_compiler.h"
 #include "xenia/cpu/xex_module.h"
 
 // TODO(benvanik): based on compiler support
@@ -82,6 +87,18 @@ Processor::Processor(xe::Memory* memory, ExportResolver* export_resolver)
     : memory_(memory), export_resolver_(export_resolver) {}
 
 Processor::~Processor() {
+  // Workers use the frontend and the backend.
+  background_compiler_.reset();
+  tier_up_compiler_.reset();
+
+  if (sampling_profiler_) {
+    sampling_profiler_->Stop();
+    sampling_profiler_->Dump();
+    sampling_profiler_->WriteFoldedStacks(
+        xe::to_wstring(cvars::sampling_profiler_path));
+    sampling_profiler_.reset();
+  }
+
   {
     auto global_lock = global_critical_region_.Acquire();
     modules_.clear();
@@ -146,9 +163,59 @@ bool Processor::Setup(std::unique_ptr<backend::Backend> backend) {
         functions_trace_path_, 32 * 1024 * 1024, true);
   }
 
+  if (cvars::tiered_compilation) {
+    tier_up_compiler_ = std::make_unique<TierUpCompiler>(this);
+  }
+
+  if (!cvars::sampling_profiler_path.empty()) {
+    sampling_profiler_ = SamplingProfiler::Create(this);
+    if (sampling_profiler_) {
+      sampling_profiler_->Start(std::chrono::microseconds(
+          std::max(cvars::sampling_profiler_interval_us, 1)));
+    }
+  }
+
   return true;
 }
 
+void Processor::InitializeCodeStorage(const std::wstring& storage_root,
+                                      uint32_t title_id, XexModule* module) {
+  if (!module || module->high_address() <= module->low_address()) {
+    return;
+  }
+  // The whole code range identifies the executable - title updates and
+  // different builds of the same title get their own storage.
+  uint64_t module_hash =
+      XXH64(memory_->TranslateVirtual(module->low_address()),
+            module->high_address() - module->low_address(), 0);
+  backend_->InitializeCodeStorage(storage_root, title_id, module_hash);
+}
+
+void Processor::ShutdownCodeStorage() { backend_->ShutdownCodeStorage(); }
+
+void Processor::StartBackgroundCompilation(XexModule* module,
+                                           uint32_t entry_point) {
+  if (!cvars::background_compilation || !module) {
+    return;
+  }
+  if (!background_compiler_) {
+    background_compiler_ = std::make_unique<BackgroundCompiler>(this);
+  }
+  background_compiler_->Start(module, entry_point);
+}
+
+void Processor::StopBackgroundCompilation() {
+  if (background_compiler_) {
+    background_compiler_->Shutdown();
+  }
+}
+
+void Processor::RequestTierUp(GuestFunction* function) {
+  if (tier_up_compiler_) {
+    tier_up_compiler_->Enqueue(function);
+  }
+}
+
 void Processor::PreLaunch() {
   if (cvars::break_on_start) {
     // Start paused.
@@ -236,6 +303,10 @@ Function* Processor::ResolveFunction(uint32_t address) {
     entry->function = function;
     entry->end_address = function->end_address();
     status = entry->status = Entry::STATUS_READY;
+
+    if (background_compiler_ && !BackgroundCompiler::IsWorkerThread()) {
+      background_compiler_->OnFunctionDemanded(function);
+    }
   }
   if (status == Entry::STATUS_READY) {
     // Ready to use.
@@ -504,6 +575,9 @@ void Processor::OnThreadDestroyed(uint32_t thread_id) {
   auto thread_info = it->second.get();
   thread_info->state = ThreadDebugInfo::State::kZombie;
   thread_info->thread = nullptr;
+  if (sampling_profiler_) {
+    sampling_profiler_->OnThreadDestroyed(thread_id);
+  }
 }
 
 void Processor::OnThreadEnteringWait(uint32_t thread_id) {
@@ -19,6 +19,7 @@
 #include "xenia/base/mapped_memory.h"
 #include "xenia/base/mutex.h"
 #include "xenia/cpu/backend/backend.h"
+#include "xenia/cpu/background_compiler.h"
 #include "xenia/cpu/debug_listener.h"
 #include "xenia/cpu/entry_table.h"
 #include "xenia/cpu/export_resolver.h"
@@ -35,6 +36,8 @@ namespace xe {
 namespace cpu {
 
 class Breakpoint;
+class SamplingProfiler;
+class TierUpCompiler;
 class StackWalker;
 class XexModule;
 
@@ -72,6 +75,21 @@ class Processor {
 
   bool Setup(std::unique_ptr<backend::Backend> backend);
 
+  // Opens the persistent storage of generated code for the executable module
+  // so functions translated in previous executions can be reused.
+  void InitializeCodeStorage(const std::wstring& storage_root,
+                             uint32_t title_id, XexModule* module);
+  void ShutdownCodeStorage();
+
+  // Starts compiling the functions of the module on background threads, if
+  // enabled.
+  void StartBackgroundCompilation(XexModule* module, uint32_t entry_point);
+  void StopBackgroundCompilation();
+
+  // Queues a hot baseline function for recompilation with all optimizations.
+  // Called from generated code.
+  void RequestTierUp(GuestFunction* function);
+
   // Runs any pre-launch logic once the module and thread have been setup.
   void PreLaunch();
 
@@ -238,6 +256,7 @@ class Processor {
 
   Memory* memory_ = nullptr;
   std::unique_ptr<StackWalker> stack_walker_;
+  std::unique_ptr<SamplingProfiler> sampling_profiler_;
 
   std::function<DebugListener*(Processor*)> debug_listener_handler_;
   DebugListener* debug_listener_ = nullptr;
@@ -251,6 +270,8 @@ class Processor {
   std::unique_ptr<ppc::PPCFrontend> frontend_;
   std::unique_ptr<backend::Backend> backend_;
   ExportResolver* export_resolver_ = nullptr;
+  std::unique_ptr<BackgroundCompiler> background_compiler_;
+  std::unique_ptr<TierUpCompiler> tier_up_compiler_;
 
   EntryTable entry_table_;
   xe::global_critical_region global_critical_region_;
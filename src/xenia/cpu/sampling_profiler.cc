@@ -0,0 +1,229 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/sampling_profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/cpu/backend/backend.h"
+#include "xenia/cpu/backend/code_cache.h"
+#include "xenia/cpu/function.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/cpu/thread.h"
+#include "xenia/cpu/thread_debug_info.h"
+
+namespace xe {
+namespace cpu {
+
+SamplingProfiler::SamplingProfiler(Processor* processor)
+    : processor_(processor),
+      code_cache_(processor->backend()->code_cache()) {
+  code_cache_min_ = code_cache_->base_address();
+  code_cache_max_ = code_cache_min_ + code_cache_->total_size();
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  // Subclasses must stop before their state goes away.
+  assert_false(running_);
+}
+
+void SamplingProfiler::Start(std::chrono::microseconds interval) {
+  assert_false(running_);
+  interval_ = interval;
+  running_ = true;
+  thread_ = xe::threading::Thread::Create({}, [this]() { SamplerThread(); });
+  thread_->set_name("Sampling Profiler");
+  // Needs to run when guest threads are busy.
+  thread_->set_priority(xe::threading::ThreadPriority::kAboveNormal);
+}
+
+void SamplingProfiler::Stop() {
+  if (!running_) {
+    return;
+  }
+  running_ = false;
+  xe::threading::Wait(thread_.get(), false);
+  thread_.reset();
+}
+
+void SamplingProfiler::OnThreadDestroyed(uint32_t thread_id) {
+  std::lock_guard<std::mutex> lock(capture_mutex_);
+  destroyed_thread_ids_.insert(thread_id);
+}
+
+void SamplingProfiler::SamplerThread() {
+  while (running_) {
+    sampled_threads_.clear();
+    {
+      auto global_lock = global_critical_region_.Acquire();
+      for (auto thread_info : processor_->QueryThreadDebugInfos()) {
+        if (thread_info->state != ThreadDebugInfo::State::kAlive ||
+            !thread_info->thread || thread_info->suspended) {
+          continue;
+        }
+        sampled_threads_.push_back(
+            {thread_info->thread_id, thread_info->thread});
+      }
+    }
+    {
+      // Threads that were already gone when the list was taken won't show up
+      // in it again.
+      std::lock_guard<std::mutex> lock(capture_mutex_);
+      for (auto it = destroyed_thread_ids_.begin();
+           it != destroyed_thread_ids_.end();) {
+        if (std::find_if(sampled_threads_.begin(), sampled_threads_.end(),
+                         [&it](const SampledThread& sampled_thread) {
+                           return sampled_thread.thread_id == *it;
+                         }) == sampled_threads_.end()) {
+          it = destroyed_thread_ids_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    for (auto& sampled_thread : sampled_threads_) {
+      // Only the thread being captured is kept from being destroyed, the
+      // global lock isn't held while it's stopped.
+      size_t count;
+      {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        if (destroyed_thread_ids_.count(sampled_thread.thread_id)) {
+          continue;
+        }
+        count = CaptureStack(sampled_thread.thread_id, sampled_thread.thread,
+                             host_pcs_, xe::countof(host_pcs_));
+      }
+      if (count) {
+        // Function source maps are changed under the global lock.
+        auto global_lock = global_critical_region_.Acquire();
+        AddSample(host_pcs_, count);
+      }
+    }
+    xe::threading::Sleep(interval_);
+  }
+}
+
+void SamplingProfiler::AddSample(const uint64_t* host_pcs, size_t count) {
+  ++sample_count_;
+
+  frames_.clear();
+  bool in_host = true;
+  for (size_t i = 0; i < count; ++i) {
+    if (!IsInCodeCache(host_pcs[i])) {
+      continue;
+    }
+    auto function = code_cache_->LookupFunction(host_pcs[i]);
+    if (!function) {
+      // Thunks.
+      continue;
+    }
+    if (i == 0) {
+      in_host = false;
+      // The PC where the thread was stopped, no adjustment needed.
+      ++addresses_[function->MapMachineCodeToGuestAddress(host_pcs[i])];
+      ++functions_[function].self;
+    }
+    frames_.push_back(function);
+  }
+  if (in_host) {
+    ++host_sample_count_;
+  }
+
+  // Recursive functions are only counted once per sample.
+  std::string stack;
+  for (size_t i = frames_.size(); i-- > 0;) {
+    auto function = frames_[i];
+    if (std::find(frames_.begin() + i + 1, frames_.end(), function) ==
+        frames_.end()) {
+      ++functions_[function].total;
+    }
+    if (!stack.empty()) {
+      stack += ';';
+    }
+    stack += GetFunctionName(function);
+  }
+  if (in_host) {
+    stack += stack.empty() ? "[host]" : ";[host]";
+  }
+  ++stacks_[stack];
+}
+
+std::string SamplingProfiler::GetFunctionName(Function* function) const {
+  if (!function->name().empty()) {
+    return function->name();
+  }
+  char name[32];
+  snprintf(name, xe::countof(name), "sub_%08X", function->address());
+  return name;
+}
+
+void SamplingProfiler::Dump() {
+  assert_false(running_);
+  if (!sample_count_) {
+    return;
+  }
+  XELOGI("Sampling profile: %" PRIu64 " samples, %" PRIu64 " (%.1f%%) in host "
+         "code",
+         sample_count_, host_sample_count_,
+         100.0 * host_sample_count_ / sample_count_);
+
+  std::vector<std::pair<Function*, FunctionCounts>> functions(
+      functions_.begin(), functions_.end());
+  std::sort(functions.begin(), functions.end(),
+            [](const std::pair<Function*, FunctionCounts>& a,
+               const std::pair<Function*, FunctionCounts>& b) {
+              return a.second.self > b.second.self ||
+                     (a.second.self == b.second.self &&
+                      a.second.total > b.second.total);
+            });
+  XELOGI("  %-40s %8s %7s %8s %7s", "function", "self", "", "total", "");
+  for (size_t i = 0; i < std::min(functions.size(), size_t(40)); ++i) {
+    auto& counts = functions[i].second;
+    XELOGI("  %-40s %8" PRIu64 " %6.2f%% %8" PRIu64 " %6.2f%%",
+           GetFunctionName(functions[i].first).c_str(), counts.self,
+           100.0 * counts.self / sample_count_, counts.total,
+           100.0 * counts.total / sample_count_);
+  }
+
+  std::vector<std::pair<uint32_t, uint64_t>> addresses(addresses_.begin(),
+                                                       addresses_.end());
+  std::sort(addresses.begin(), addresses.end(),
+            [](const std::pair<uint32_t, uint64_t>& a,
+               const std::pair<uint32_t, uint64_t>& b) {
+              return a.second > b.second;
+            });
+  XELOGI("  %-40s %8s", "address", "self");
+  for (size_t i = 0; i < std::min(addresses.size(), size_t(40)); ++i) {
+    XELOGI("  %08X %40" PRIu64 " %6.2f%%", addresses[i].first,
+           addresses[i].second, 100.0 * addresses[i].second / sample_count_);
+  }
+}
+
+bool SamplingProfiler::WriteFoldedStacks(const std::wstring& path) {
+  assert_false(running_);
+  FILE* file = xe::filesystem::OpenFile(path, "w");
+  if (!file) {
+    XELOGE("Unable to open sampling profile file %S", path.c_str());
+    return false;
+  }
+  for (auto& it : stacks_) {
+    fprintf(file, "%s %" PRIu64 "\n", it.first.c_str(), it.second);
+  }
+  fclose(file);
+  return true;
+}
+
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,130 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_SAMPLING_PROFILER_H_
+#define XENIA_CPU_SAMPLING_PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/base/threading.h"
+
+namespace xe {
+namespace cpu {
+namespace backend {
+class CodeCache;
+}  // namespace backend
+class Function;
+class Processor;
+class Thread;
+}  // namespace cpu
+}  // namespace xe
+
+namespace xe {
+namespace cpu {
+
+// Periodically stops each running guest thread, captures the host PCs on its
+// stack and maps the ones in generated code back to guest functions.
+// Samples are aggregated per guest function (self and total), per guest
+// address (self) and per guest call stack.
+class SamplingProfiler {
+ public:
+  // Returns nullptr if threads can't be sampled on this host.
+  static std::unique_ptr<SamplingProfiler> Create(Processor* processor);
+
+  virtual ~SamplingProfiler();
+
+  void Start(std::chrono::microseconds interval);
+  void Stop();
+
+  // Called after the thread is marked as destroyed and before its Thread
+  // object goes away. Waits for a capture of the thread that's in progress.
+  void OnThreadDestroyed(uint32_t thread_id);
+
+  // The following must only be called when stopped.
+
+  // Logs the hottest functions and guest addresses.
+  void Dump();
+  // Writes one line per unique guest stack, outermost function first:
+  //   sub_82001000;sub_82004560;sub_82005678 123
+  // Samples taken in host code are attributed to a [host] frame under the
+  // guest function that called out. This is the input format of flamegraph.pl
+  // and most other flame graph tools.
+  bool WriteFoldedStacks(const std::wstring& path);
+
+ protected:
+  static const size_t kMaxFrameCount = 128;
+
+  explicit SamplingProfiler(Processor* processor);
+
+  // Stops the thread, captures up to max_count host PCs from its stack
+  // (innermost first) and resumes it. Returns the number of PCs captured.
+  // Nothing may allocate or take locks while the thread is stopped - it may
+  // hold them.
+  virtual size_t CaptureStack(uint32_t thread_id, Thread* thread,
+                              uint64_t* host_pcs, size_t max_count) = 0;
+
+  bool IsInCodeCache(uint64_t host_pc) const {
+    return host_pc >= code_cache_min_ && host_pc < code_cache_max_;
+  }
+
+  Processor* processor_ = nullptr;
+  backend::CodeCache* code_cache_ = nullptr;
+
+ private:
+  struct FunctionCounts {
+    uint64_t self = 0;
+    uint64_t total = 0;
+  };
+  struct SampledThread {
+    uint32_t thread_id;
+    Thread* thread;
+  };
+
+  void SamplerThread();
+  void AddSample(const uint64_t* host_pcs, size_t count);
+  std::string GetFunctionName(Function* function) const;
+
+  uint64_t code_cache_min_ = 0;
+  uint64_t code_cache_max_ = 0;
+
+  xe::global_critical_region global_critical_region_;
+  // Held while a thread is being captured, instead of the global lock that
+  // the JIT and guest threads need.
+  std::mutex capture_mutex_;
+  // Threads destroyed since the thread list was taken.
+  std::unordered_set<uint32_t> destroyed_thread_ids_;
+  std::vector<SampledThread> sampled_threads_;
+  std::unique_ptr<xe::threading::Thread> thread_;
+  std::atomic<bool> running_ = {false};
+  std::chrono::microseconds interval_;
+
+  uint64_t host_pcs_[kMaxFrameCount];
+  // Guest functions of the current sample, innermost first.
+  std::vector<Function*> frames_;
+
+  uint64_t sample_count_ = 0;
+  // Samples taken outside of generated code.
+  uint64_t host_sample_count_ = 0;
+  std::unordered_map<Function*, FunctionCounts> functions_;
+  std::unordered_map<uint32_t, uint64_t> addresses_;
+  std::unordered_map<std::string, uint64_t> stacks_;
+};
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_SAMPLING_PROFILER_H_
@@ -0,0 +1,226 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/sampling_profiler.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <algorithm>
+#include <cerrno>
+
+#include "xenia/base/logging.h"
+#include "xenia/cpu/backend/code_cache.h"
+#include "xenia/cpu/thread.h"
+
+namespace xe {
+namespace cpu {
+
+namespace {
+
+// Handshake with the signal handler. Only the sampler thread sends the
+// signal, and to one thread at a time.
+// Nonzero while a signal is on its way. The handler claims it by swapping in
+// zero, so a late signal for a request that timed out is ignored.
+std::atomic<uint32_t> sample_request = {0};
+sem_t sample_captured_semaphore;
+sem_t sample_resume_semaphore;
+uint64_t sample_rip = 0;
+uint64_t sample_rsp = 0;
+
+void SampleSignalHandler(int signal, siginfo_t* info, void* context) {
+  if (!sample_request.exchange(0)) {
+    return;
+  }
+  int saved_errno = errno;
+  auto ucontext = reinterpret_cast<ucontext_t*>(context);
+  sample_rip = uint64_t(ucontext->uc_mcontext.gregs[REG_RIP]);
+  sample_rsp = uint64_t(ucontext->uc_mcontext.gregs[REG_RSP]);
+  sem_post(&sample_captured_semaphore);
+  // Stay here until the sampler is done reading our stack.
+  while (sem_wait(&sample_resume_semaphore) && errno == EINTR) {
+  }
+  errno = saved_errno;
+}
+
+}  // namespace
+
+// There's no platform unwind information for generated code here, so threads
+// are stopped with a signal and their guest frames are stepped over with the
+// frame layouts the code cache keeps (see CodeFrameLayout).
+class PosixSamplingProfiler : public SamplingProfiler {
+ public:
+  explicit PosixSamplingProfiler(Processor* processor)
+      : SamplingProfiler(processor) {}
+
+  ~PosixSamplingProfiler() override {
+    Stop();
+    if (installed_) {
+      sigaction(SIGPROF, &old_action_, nullptr);
+      sem_destroy(&sample_captured_semaphore);
+      sem_destroy(&sample_resume_semaphore);
+    }
+  }
+
+  bool Initialize() {
+    sem_init(&sample_captured_semaphore, 0, 0);
+    sem_init(&sample_resume_semaphore, 0, 0);
+    struct sigaction action = {};
+    action.sa_sigaction = SampleSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &old_action_)) {
+      XELOGE("Unable to install the sampling profiler signal handler");
+      sem_destroy(&sample_captured_semaphore);
+      sem_destroy(&sample_resume_semaphore);
+      return false;
+    }
+    installed_ = true;
+    return true;
+  }
+
+ protected:
+  size_t CaptureStack(uint32_t thread_id, Thread* thread, uint64_t* host_pcs,
+                      size_t max_count) override {
+    auto handle =
+        reinterpret_cast<pthread_t>(thread->thread()->native_handle());
+    // Looked up ahead of time - this allocates.
+    auto bounds_it = stack_bounds_.find(thread_id);
+    if (bounds_it == stack_bounds_.end()) {
+      StackBounds bounds;
+      pthread_attr_t attr;
+      void* stack_address;
+      size_t stack_size;
+      if (pthread_getattr_np(handle, &attr)) {
+        return 0;
+      }
+      pthread_attr_getstack(&attr, &stack_address, &stack_size);
+      pthread_attr_destroy(&attr);
+      bounds.low = reinterpret_cast<uint64_t>(stack_address);
+      bounds.high = bounds.low + stack_size;
+      bounds_it = stack_bounds_.emplace(thread_id, bounds).first;
+    }
+    const StackBounds& bounds = bounds_it->second;
+
+    sample_request = 1;
+    if (pthread_kill(handle, SIGPROF)) {
+      sample_request = 0;
+      return 0;
+    }
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 50 * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+      deadline.tv_nsec -= 1000 * 1000 * 1000;
+      ++deadline.tv_sec;
+    }
+    while (sem_timedwait(&sample_captured_semaphore, &deadline)) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Timed out. If the handler hasn't claimed the request it never will,
+      // otherwise it's about to post.
+      if (sample_request.exchange(0)) {
+        return 0;
+      }
+      while (sem_wait(&sample_captured_semaphore) && errno == EINTR) {
+      }
+      break;
+    }
+
+    size_t count =
+        WalkStack(sample_rip, sample_rsp, bounds, host_pcs, max_count);
+    sem_post(&sample_resume_semaphore);
+    return count;
+  }
+
+ private:
+  struct StackBounds {
+    uint64_t low;
+    uint64_t high;
+  };
+
+  // How far above the stack pointer to look for a return address into
+  // generated code when stopped in host code.
+  static const uint64_t kMaxHostStackScan = 256 * 1024;
+
+  const backend::CodeFrameLayout* LookupFrameLayout(uint64_t host_pc) {
+    if (!IsInCodeCache(host_pc)) {
+      return nullptr;
+    }
+    return reinterpret_cast<const backend::CodeFrameLayout*>(
+        code_cache_->LookupUnwindInfo(host_pc));
+  }
+
+  size_t WalkStack(uint64_t pc, uint64_t sp, const StackBounds& bounds,
+                   uint64_t* host_pcs, size_t max_count) {
+    if (sp < bounds.low || sp >= bounds.high) {
+      return 0;
+    }
+    size_t count = 0;
+    auto layout = LookupFrameLayout(pc);
+    if (!layout) {
+      // Host code (a kernel export, the emulator, the system) doesn't keep a
+      // frame pointer, so look for the innermost return address into the
+      // body of generated code instead. A stale value may be picked up now
+      // and then, which only misattributes that one sample.
+      host_pcs[count++] = pc;
+      uint64_t scan_end = std::min(bounds.high, sp + kMaxHostStackScan);
+      for (uint64_t slot = sp; slot + 8 <= scan_end; slot += 8) {
+        uint64_t value = *reinterpret_cast<const uint64_t*>(slot);
+        auto candidate = LookupFrameLayout(value);
+        if (candidate && value - candidate->code_address >
+                             candidate->prolog_stack_alloc_offset) {
+          pc = value;
+          sp = slot + 8;
+          layout = candidate;
+          break;
+        }
+      }
+    }
+    while (layout && count < max_count) {
+      host_pcs[count++] = pc;
+      // Before the prolog allocated the frame or after the epilog freed it
+      // the return address is on top of the stack. Tail calls free the frame
+      // outside of the epilog, which is missed here - rare enough to ignore.
+      uint64_t offset = pc - layout->code_address;
+      uint64_t frame_size = 0;
+      if (offset >= layout->prolog_stack_alloc_offset &&
+          offset <= layout->epilog_offset) {
+        frame_size = layout->stack_size;
+      }
+      uint64_t return_slot = sp + frame_size;
+      if (return_slot + 8 > bounds.high) {
+        break;
+      }
+      pc = *reinterpret_cast<const uint64_t*>(return_slot);
+      sp = return_slot + 8;
+      layout = LookupFrameLayout(pc);
+    }
+    return count;
+  }
+
+  bool installed_ = false;
+  struct sigaction old_action_ = {};
+  std::unordered_map<uint32_t, StackBounds> stack_bounds_;
+};
+
+std::unique_ptr<SamplingProfiler> SamplingProfiler::Create(
+    Processor* processor) {
+  auto profiler = std::make_unique<PosixSamplingProfiler>(processor);
+  if (!profiler->Initialize()) {
+    return nullptr;
+  }
+  return std::unique_ptr<SamplingProfiler>(profiler.release());
+}
+
+}  // namespace cpu
+}  // namespace xe
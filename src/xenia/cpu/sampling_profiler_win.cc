@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/sampling_profiler.h"
+
+#include "xenia/base/logging.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/cpu/stack_walker.h"
+#include "xenia/cpu/thread.h"
+
+namespace xe {
+namespace cpu {
+
+class Win32SamplingProfiler : public SamplingProfiler {
+ public:
+  explicit Win32SamplingProfiler(Processor* processor)
+      : SamplingProfiler(processor) {}
+  ~Win32SamplingProfiler() override { Stop(); }
+
+ protected:
+  size_t CaptureStack(uint32_t thread_id, Thread* thread, uint64_t* host_pcs,
+                      size_t max_count) override {
+    // The stack walker unwinds generated code through the function tables the
+    // code cache registers, so host and guest frames come out together.
+    auto host_thread = thread->thread();
+    if (!host_thread->Suspend()) {
+      return 0;
+    }
+    size_t count = processor_->stack_walker()->CaptureStackTrace(
+        host_thread->native_handle(), host_pcs, 0, max_count, nullptr,
+        nullptr);
+    host_thread->Resume();
+    return count;
+  }
+};
+
+std::unique_ptr<SamplingProfiler> SamplingProfiler::Create(
+    Processor* processor) {
+  if (!processor->stack_walker()) {
+    XELOGW("Sampling profiler requires a stack walker");
+    return nullptr;
+  }
+  return std::make_unique<Win32SamplingProfiler>(processor);
+}
+
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/cpu/entry_table.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace cpu {
+namespace test {
+
+namespace {
+
+const uint32_t kTestBase = 0x82000000;
+const uint32_t kTestFunctionCount = 16384;
+
+// The map behind the global lock EntryTable used to be, for comparison.
+class LockedMapEntryTable {
+ public:
+  ~LockedMapEntryTable() {
+    for (auto it : map_) {
+      delete it.second;
+    }
+  }
+  Entry* Get(uint32_t address) {
+    auto global_lock = global_critical_region_.Acquire();
+    const auto& it = map_.find(address);
+    Entry* entry = it != map_.end() ? it->second : nullptr;
+    if (entry && entry->status != Entry::STATUS_READY) {
+      entry = nullptr;
+    }
+    return entry;
+  }
+  void Insert(uint32_t address) {
+    auto global_lock = global_critical_region_.Acquire();
+    Entry* entry = new Entry();
+    entry->address = address;
+    entry->end_address = address + 4;
+    entry->status = Entry::STATUS_READY;
+    entry->function = nullptr;
+    map_[address] = entry;
+  }
+
+ private:
+  xe::global_critical_region global_critical_region_;
+  std::unordered_map<uint32_t, Entry*> map_;
+};
+
+void FillEntryTable(EntryTable* table) {
+  for (uint32_t i = 0; i < kTestFunctionCount; ++i) {
+    Entry* entry;
+    uint32_t address = kTestBase + i * 0x40;
+    REQUIRE(table->GetOrCreate(address, &entry) == Entry::STATUS_NEW);
+    entry->end_address = address + 4;
+    entry->status = Entry::STATUS_READY;
+  }
+}
+
+// Returns lookups per second over all threads.
+template <typename T>
+double MeasureLookups(T* table, uint32_t thread_count) {
+  const uint32_t kIterations = 16;
+  std::atomic<uint32_t> misses(0);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([table, t, &misses]() {
+      uint32_t local_misses = 0;
+      for (uint32_t i = 0; i < kIterations; ++i) {
+        for (uint32_t j = 0; j < kTestFunctionCount; ++j) {
+          uint32_t index = (j * 7919 + t) % kTestFunctionCount;
+          if (!table->Get(kTestBase + index * 0x40)) {
+            ++local_misses;
+          }
+        }
+      }
+      misses += local_misses;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  REQUIRE(misses == 0);
+  return double(thread_count) * kIterations * kTestFunctionCount / elapsed;
+}
+
+}  // namespace
+
+TEST_CASE("ENTRY_TABLE_GET_OR_CREATE", "[entry_table]") {
+  EntryTable table;
+  Entry* entry;
+
+  REQUIRE(table.Get(kTestBase) == nullptr);
+  REQUIRE(table.GetOrCreate(kTestBase, &entry) == Entry::STATUS_NEW);
+  REQUIRE(entry->address == kTestBase);
+  // Not visible until it's ready.
+  REQUIRE(table.Get(kTestBase) == nullptr);
+  entry->end_address = kTestBase + 0x10;
+  entry->status = Entry::STATUS_READY;
+  REQUIRE(table.Get(kTestBase) == entry);
+
+  Entry* existing_entry;
+  REQUIRE(table.GetOrCreate(kTestBase, &existing_entry) ==
+          Entry::STATUS_READY);
+  REQUIRE(existing_entry == entry);
+
+  // Outside of the paged range.
+  REQUIRE(table.GetOrCreate(0x40000000, &entry) == Entry::STATUS_NEW);
+  entry->end_address = 0x40000010;
+  entry->status = Entry::STATUS_FAILED;
+  REQUIRE(table.GetOrCreate(0x40000000, &entry) == Entry::STATUS_FAILED);
+  REQUIRE(table.Get(0x40000000) == nullptr);
+
+  REQUIRE(table.FindWithAddress(kTestBase + 0x8).size() == 1);
+  REQUIRE(table.FindWithAddress(kTestBase + 0x14).empty());
+}
+
+TEST_CASE("ENTRY_TABLE_COMPILING_HANDOFF", "[entry_table]") {
+  const uint32_t kThreadCount = 8;
+  EntryTable table;
+  std::atomic<uint32_t> new_count(0);
+  std::atomic<uint32_t> ready_count(0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&]() {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t address = kTestBase + i * 4;
+        Entry* entry;
+        Entry::Status status = table.GetOrCreate(address, &entry);
+        if (status == Entry::STATUS_NEW) {
+          ++new_count;
+          entry->end_address = address;
+          entry->status = Entry::STATUS_READY;
+        } else if (status == Entry::STATUS_READY &&
+                   entry->end_address == address) {
+          ++ready_count;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // Exactly one thread compiles each function, everybody else gets it ready.
+  REQUIRE(new_count == 256);
+  REQUIRE(ready_count == 256 * (kThreadCount - 1));
+}
+
+// Hidden by default, run with "[.benchmark]" or "[entry_table_benchmark]".
+TEST_CASE("ENTRY_TABLE_CONTENDED_LOOKUP",
+          "[.benchmark][entry_table_benchmark]") {
+  EntryTable table;
+  FillEntryTable(&table);
+  LockedMapEntryTable locked_map_table;
+  for (uint32_t i = 0; i < kTestFunctionCount; ++i) {
+    locked_map_table.Insert(kTestBase + i * 0x40);
+  }
+
+  for (uint32_t thread_count : {1u, 2u, 4u, 8u}) {
+    double paged = MeasureLookups(&table, thread_count);
+    double locked_map = MeasureLookups(&locked_map_table, thread_count);
+    std::printf(
+        "%u threads: paged %.1f Mlookups/s, locked map %.1f Mlookups/s "
+        "(%.1fx)\n",
+        thread_count, paged / 1000000.0, locked_map / 1000000.0,
+        paged / locked_map);
+  }
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace xe
@@ -61,6 +61,15 @@ TEST_CASE("PACK_FLOAT16_2", "[instr]") {
         auto result = ctx->v[3];
         REQUIRE(result == vec128i(0, 0, 0, 0x55556666));
       });
+  // NaNs come out quiet, even with only the low mantissa bits set.
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128i(0x7F800001, 0x7FC00000, 0x00000000, 0x3F800000);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128i(0, 0, 0, 0x7E007E00));
+      });
 }
 
 TEST_CASE("PACK_FLOAT16_4", "[instr]") {
@@ -82,6 +91,15 @@ TEST_CASE("PACK_FLOAT16_4", "[instr]") {
         REQUIRE(result ==
                 vec128i(0x00000000, 0x00000000, 0x64D26D8C, 0x48824491));
       });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128i(0x7F800001, 0xFF800001, 0x7F800000, 0x7FFFFFFF);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result ==
+                vec128i(0x00000000, 0x00000000, 0x7E00FE00, 0x7C007FFF));
+      });
 }
 
 TEST_CASE("PACK_SHORT_2", "[instr]") {
@@ -111,3 +129,49 @@ TEST_CASE("PACK_SHORT_2", "[instr]") {
         REQUIRE(result == vec128i(0, 0, 0, 0x80018001));
       });
 }
+
+TEST_CASE("PACK_8_IN_16_UN_UN_SAT", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.Pack(LoadVR(b, 4), LoadVR(b, 5),
+                   PACK_TYPE_8_IN_16 | PACK_TYPE_IN_UNSIGNED |
+                       PACK_TYPE_OUT_UNSIGNED | PACK_TYPE_OUT_SATURATE));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0x0000, 0x0001, 0x007F, 0x0080, 0x00FF, 0x0100,
+                            0x7FFF, 0x8000);
+        ctx->v[5] = vec128s(0xFFFF, 0x1234, 0x00AB, 0x0042, 0x0155, 0x00FE,
+                            0xFF00, 0x0010);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128b(0x00, 0x01, 0x7F, 0x80, 0xFF, 0xFF, 0xFF,
+                                  0xFF, 0xFF, 0xFF, 0xAB, 0x42, 0xFF, 0xFE,
+                                  0xFF, 0x10));
+      });
+}
+
+TEST_CASE("PACK_8_IN_16_UN_UN", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.Pack(LoadVR(b, 4), LoadVR(b, 5),
+                   PACK_TYPE_8_IN_16 | PACK_TYPE_IN_UNSIGNED |
+                       PACK_TYPE_OUT_UNSIGNED));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0x0000, 0x0001, 0x007F, 0x0080, 0x00FF, 0x0100,
+                            0x7FFF, 0x8000);
+        ctx->v[5] = vec128s(0xFFFF, 0x1234, 0x00AB, 0x0042, 0x0155, 0x00FE,
+                            0xFF00, 0x0010);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128b(0x00, 0x01, 0x7F, 0x80, 0xFF, 0x00, 0xFF,
+                                  0x00, 0xFF, 0x34, 0xAB, 0x42, 0x55, 0xFE,
+                                  0x00, 0x10));
+      });
+}
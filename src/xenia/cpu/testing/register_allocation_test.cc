@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/testing/util.h"
+
+#include "xenia/cpu/cpu_flags.h"
+
+using namespace xe;
+using namespace xe::cpu;
+using namespace xe::cpu::hir;
+using namespace xe::cpu::testing;
+using xe::cpu::ppc::PPCContext;
+
+namespace {
+
+// Keeps 16 integer and 16 vector values live at once, more than there are
+// host registers for, so both allocators have to spill.
+void RunHighPressure(bool linear_scan) {
+  cvars::linear_scan_register_allocation = linear_scan;
+  TestFunction test([](HIRBuilder& b) {
+    Value* gprs[16];
+    Value* vrs[16];
+    for (int i = 0; i < 16; ++i) {
+      gprs[i] = LoadGPR(b, i);
+      vrs[i] = LoadVR(b, i);
+    }
+    for (int i = 0; i < 16; ++i) {
+      StoreGPR(b, 16 + i, b.Add(gprs[i], gprs[15 - i]));
+      StoreVR(b, 16 + i, b.Xor(vrs[i], vrs[15 - i]));
+    }
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        for (int i = 0; i < 16; ++i) {
+          ctx->r[i] = uint64_t(i) << 32 | i;
+          ctx->v[i] = vec128i(i, i << 8, i << 16, i << 24);
+        }
+      },
+      [](PPCContext* ctx) {
+        for (int i = 0; i < 16; ++i) {
+          REQUIRE(ctx->r[16 + i] == (uint64_t(15) << 32 | 15));
+          int j = i ^ (15 - i);
+          REQUIRE(ctx->v[16 + i] == vec128i(j, j << 8, j << 16, j << 24));
+        }
+      });
+  cvars::linear_scan_register_allocation = false;
+}
+
+}  // namespace
+
+TEST_CASE("REGISTER_ALLOCATION_SPILL", "[regalloc]") {
+  RunHighPressure(false);
+}
+
+TEST_CASE("REGISTER_ALLOCATION_LINEAR_SCAN_SPILL", "[regalloc]") {
+  RunHighPressure(true);
+}
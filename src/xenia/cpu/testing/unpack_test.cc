@@ -86,6 +86,32 @@ TEST_CASE("UNPACK_FLOAT16_4", "[instr]") {
       });
 }
 
+TEST_CASE("UNPACK_FLOAT16_4_SPECIAL", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3, b.Unpack(LoadVR(b, 4), PACK_TYPE_FLOAT16_4));
+    b.Return();
+  });
+  // Denormals, infinities, NaNs and negative zero.
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0, 0, 0, 0, 0x0001, 0x7C00, 0x83FF, 0x7E00);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result ==
+                vec128i(0x33800000, 0x7F800000, 0xB87FC000, 0x7FC00000));
+      });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0, 0, 0, 0, 0xFC00, 0x8000, 0x3555, 0x0400);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result ==
+                vec128i(0xFF800000, 0x80000000, 0x3EAAA000, 0x38800000));
+      });
+}
+
 TEST_CASE("UNPACK_SHORT_2", "[instr]") {
   TestFunction test([](HIRBuilder& b) {
     StoreVR(b, 3, b.Unpack(LoadVR(b, 4), PACK_TYPE_SHORT_2));
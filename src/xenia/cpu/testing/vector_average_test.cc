@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/testing/util.h"
+
+using namespace xe;
+using namespace xe::cpu;
+using namespace xe::cpu::hir;
+using namespace xe::cpu::testing;
+using xe::cpu::ppc::PPCContext;
+
+TEST_CASE("VECTOR_AVERAGE_I8_UNSIGNED", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorAverage(LoadVR(b, 4), LoadVR(b, 5), INT8_TYPE,
+                            ARITHMETIC_UNSIGNED));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128b(0, 1, 2, 3, 254, 255, 255, 0x80, 0x7F, 10, 20, 30,
+                            40, 50, 60, 70);
+        ctx->v[5] = vec128b(0, 0, 1, 2, 255, 255, 0, 0x7F, 0x80, 11, 22, 33,
+                            44, 55, 66, 77);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128b(0x00, 0x01, 0x02, 0x03, 0xFF, 0xFF, 0x80,
+                                  0x80, 0x80, 0x0B, 0x15, 0x20, 0x2A, 0x35,
+                                  0x3F, 0x4A));
+      });
+}
+
+TEST_CASE("VECTOR_AVERAGE_I16_UNSIGNED", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorAverage(LoadVR(b, 4), LoadVR(b, 5), INT16_TYPE,
+                            ARITHMETIC_UNSIGNED));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0x0000, 0x0001, 0xFFFF, 0xFFFF, 0x8000, 0x1234,
+                            100, 0xFFFE);
+        ctx->v[5] = vec128s(0x0000, 0x0002, 0xFFFF, 0x0000, 0x7FFF, 0x4321,
+                            201, 0xFFFF);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128s(0x0000, 0x0002, 0xFFFF, 0x8000, 0x8000,
+                                  0x2AAB, 0x0097, 0xFFFF));
+      });
+}
+
+TEST_CASE("VECTOR_AVERAGE_I32_UNSIGNED", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorAverage(LoadVR(b, 4), LoadVR(b, 5), INT32_TYPE,
+                            ARITHMETIC_UNSIGNED));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128i(0xFFFFFFFF, 0x00000000, 0x80000000, 2);
+        ctx->v[5] = vec128i(0xFFFFFFFF, 0x00000001, 0x7FFFFFFF, 5);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128i(0xFFFFFFFF, 0x00000001, 0x80000000, 4));
+      });
+}
+
+TEST_CASE("VECTOR_AVERAGE_I32_SIGNED", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorAverage(LoadVR(b, 4), LoadVR(b, 5), INT32_TYPE, 0));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128i(0xFFFFFFFF, 0xFFFFFFFD, 0x7FFFFFFF, 0x80000000);
+        ctx->v[5] = vec128i(0xFFFFFFFF, 0x00000000, 0x7FFFFFFF, 0x80000001);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result ==
+                vec128i(0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x80000001));
+      });
+}
@@ -70,3 +70,66 @@ TEST_CASE("VECTOR_ROTATE_LEFT_I32", "[instr]") {
                 vec128i(0x00000001, 0x00000002, 0x00000001, 0x00000002));
       });
 }
+
+TEST_CASE("VECTOR_ROTATE_LEFT_I8_CONSTANT", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorRotateLeft(
+                LoadVR(b, 4),
+                b.LoadConstantVec128(vec128b(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                             11, 12, 13, 14, 15)),
+                INT8_TYPE));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128b(0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                            0xF0, 0x0F, 0x5A, 0xA5, 0x3C, 0xC3, 0x12, 0xFF);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128b(0x81, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60,
+                                  0xC0, 0xF0, 0x1E, 0x69, 0x2D, 0xC3, 0x78,
+                                  0x84, 0xFF));
+      });
+}
+
+TEST_CASE("VECTOR_ROTATE_LEFT_I16_CONSTANT", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorRotateLeft(
+                LoadVR(b, 4),
+                b.LoadConstantVec128(vec128s(0, 1, 4, 15, 8, 16, 17, 31)),
+                INT16_TYPE));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128s(0x8001, 0x8001, 0x1234, 0x1234, 0xF00F, 0xF00F,
+                            0xABCD, 0xABCD);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result == vec128s(0x8001, 0x0003, 0x2341, 0x091A, 0x0FF0,
+                                  0xF00F, 0x579B, 0xD5E6));
+      });
+}
+
+TEST_CASE("VECTOR_ROTATE_LEFT_I32_CONSTANT", "[instr]") {
+  TestFunction test([](HIRBuilder& b) {
+    StoreVR(b, 3,
+            b.VectorRotateLeft(LoadVR(b, 4),
+                               b.LoadConstantVec128(vec128i(1, 4, 31, 48)),
+                               INT32_TYPE));
+    b.Return();
+  });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->v[4] = vec128i(0x80000001, 0x12345678, 0xDEADBEEF, 0x0000FFFF);
+      },
+      [](PPCContext* ctx) {
+        auto result = ctx->v[3];
+        REQUIRE(result ==
+                vec128i(0x00000003, 0x23456781, 0xEF56DF77, 0xFFFF0000));
+      });
+}
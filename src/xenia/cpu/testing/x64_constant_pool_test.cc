@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "xenia/base/platform.h"
+#include "xenia/base/vec128.h"
+
+#include "third_party/catch/include/catch.hpp"
+#include "third_party/xbyak/xbyak/xbyak.h"
+
+namespace xe {
+namespace cpu {
+namespace test {
+
+namespace {
+
+// Generates x = min(max(x * scale + bias, -1), 1) on 4 floats in a loop, the
+// clamp used when packing normals, with the constants loaded the way
+// X64Emitter does: either built on the stack (MovMem64 and a reload) or read
+// from a pool after the code (GetConstantPoolPtr). The multiply and add load
+// their constant into a register like LoadConstantXmm, and the min and max
+// take it as a memory operand like EmitBinaryXmmMemOp.
+class ClampKernel : public Xbyak::CodeGenerator {
+ public:
+  typedef void (*Function)(uint64_t iterations, vec128_t* value);
+
+  explicit ClampKernel(bool use_pool) : use_pool_(use_pool) {
+#if XE_PLATFORM_WIN32
+    const Xbyak::Reg64& iterations = rcx;
+    const Xbyak::Reg64& value = rdx;
+#else
+    const Xbyak::Reg64& iterations = rdi;
+    const Xbyak::Reg64& value = rsi;
+#endif  // XE_PLATFORM_WIN32
+    // 16-byte aligned stash space, like the emitter's stack frame.
+    sub(rsp, 40);
+    vmovups(xmm1, ptr[value]);
+    Xbyak::Label loop;
+    L(loop);
+    size_t body_start = getSize();
+    vmovdqa(xmm0, GetConstant(0, vec128f(1.5f)));
+    vmulps(xmm1, xmm1, xmm0);
+    vmovdqa(xmm0, GetConstant(0, vec128f(-0.25f)));
+    vaddps(xmm1, xmm1, xmm0);
+    vmaxps(xmm1, xmm1, GetConstant(0, vec128f(-1.0f)));
+    vminps(xmm1, xmm1, GetConstant(0, vec128f(1.0f)));
+    body_size_ = getSize() - body_start;
+    dec(iterations);
+    jnz(loop);
+    vmovups(ptr[value], xmm1);
+    add(rsp, 40);
+    ret();
+
+    if (use_pool_) {
+      while (getSize() & 15) {
+        db(0xCC);
+      }
+      L(pool_label_);
+      for (const vec128_t& v : pool_) {
+        dq(v.low);
+        dq(v.high);
+      }
+    }
+  }
+
+  Function function() const { return getCode<Function>(); }
+  // Bytes of code per iteration, without the loop branch.
+  size_t body_size() const { return body_size_; }
+  size_t pool_size() const { return pool_.size() * sizeof(vec128_t); }
+
+ private:
+  Xbyak::Address GetConstant(int index, const vec128_t& v) {
+    if (use_pool_) {
+      size_t pool_index = 0;
+      while (pool_index < pool_.size() && pool_[pool_index] != v) {
+        ++pool_index;
+      }
+      if (pool_index == pool_.size()) {
+        pool_.push_back(v);
+      }
+      return ptr[rip + pool_label_ + int(pool_index * sizeof(vec128_t))];
+    }
+    // Every constant here needs both 32-bit halves, so MovMem64 uses two
+    // dword stores for each qword.
+    auto addr = rsp + index * 16;
+    mov(dword[addr], uint32_t(v.low));
+    mov(dword[addr + 4], uint32_t(v.low >> 32));
+    mov(dword[addr + 8], uint32_t(v.high));
+    mov(dword[addr + 12], uint32_t(v.high >> 32));
+    return ptr[addr];
+  }
+
+  bool use_pool_;
+  Xbyak::Label pool_label_;
+  std::vector<vec128_t> pool_;
+  size_t body_size_ = 0;
+};
+
+}  // namespace
+
+TEST_CASE("X64_CONSTANT_POOL", "[x64_constant_pool]") {
+  ClampKernel stack_kernel(false);
+  ClampKernel pool_kernel(true);
+  REQUIRE(pool_kernel.pool_size() == 4 * sizeof(vec128_t));
+  REQUIRE(pool_kernel.body_size() < stack_kernel.body_size());
+
+  vec128_t stack_value = vec128f(-2.0f, -0.5f, 0.25f, 3.0f);
+  vec128_t pool_value = stack_value;
+  stack_kernel.function()(3, &stack_value);
+  pool_kernel.function()(3, &pool_value);
+  REQUIRE(stack_value == pool_value);
+}
+
+// Hidden by default, run with "[.benchmark]" or
+// "[x64_constant_pool_benchmark]". Only the loads of the constants differ
+// between the two kernels.
+TEST_CASE("X64_CONSTANT_POOL_BENCHMARK",
+          "[.benchmark][x64_constant_pool_benchmark]") {
+  const uint64_t kIterations = 100000000;
+  for (bool use_pool : {false, true}) {
+    ClampKernel kernel(use_pool);
+    vec128_t value = vec128f(-2.0f, -0.5f, 0.25f, 3.0f);
+    kernel.function()(kIterations / 10, &value);
+    auto start = std::chrono::steady_clock::now();
+    kernel.function()(kIterations, &value);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%s: %zu bytes of code, %zu of constants, %.2f ns/iteration\n",
+                use_pool ? "constant pool" : "stack", kernel.body_size(),
+                kernel.pool_size(),
+                std::chrono::duration<double, std::nano>(elapsed).count() /
+                    kIterations);
+  }
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace xe
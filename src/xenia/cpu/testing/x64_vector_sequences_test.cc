@@ -0,0 +1,605 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "xenia/base/math.h"
+#include "xenia/base/platform.h"
+#include "xenia/base/vec128.h"
+
+#include "third_party/catch/include/catch.hpp"
+#include "third_party/half/include/half.hpp"
+#include "third_party/xbyak/xbyak/xbyak_util.h"
+
+// The inline vector sequences in x64_seq_vector.cc can only be run through
+// the JIT, which the instruction tests can't do yet. These are the same
+// instruction sequences written with intrinsics, checked against the C++
+// emulation the sequences replaced, so that a change to one of the
+// algorithms can be checked on the host. Keep them in sync with the emitters
+// named above each of them.
+
+#if XE_COMPILER_MSVC
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define TARGET_F16C
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512vl,avx512bw")))
+#define TARGET_F16C __attribute__((target("f16c")))
+#endif  // XE_COMPILER_MSVC
+
+namespace xe {
+namespace cpu {
+namespace test {
+
+namespace {
+
+// Emulation, as called through CallNativeSafe before the inline sequences.
+
+template <typename T>
+__m128i EmulateVectorShl(__m128i src1, __m128i src2) {
+  alignas(16) T value[16 / sizeof(T)];
+  alignas(16) T shamt[16 / sizeof(T)];
+  _mm_store_si128(reinterpret_cast<__m128i*>(value), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(shamt), src2);
+  for (size_t i = 0; i < (16 / sizeof(T)); ++i) {
+    value[i] = value[i] << (shamt[i] & ((sizeof(T) * 8) - 1));
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(value));
+}
+
+template <typename T>
+__m128i EmulateVectorShr(__m128i src1, __m128i src2) {
+  alignas(16) T value[16 / sizeof(T)];
+  alignas(16) T shamt[16 / sizeof(T)];
+  _mm_store_si128(reinterpret_cast<__m128i*>(value), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(shamt), src2);
+  for (size_t i = 0; i < (16 / sizeof(T)); ++i) {
+    value[i] = value[i] >> (shamt[i] & ((sizeof(T) * 8) - 1));
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(value));
+}
+
+template <typename T>
+__m128i EmulateVectorRotateLeft(__m128i src1, __m128i src2) {
+  alignas(16) T value[16 / sizeof(T)];
+  alignas(16) T shamt[16 / sizeof(T)];
+  _mm_store_si128(reinterpret_cast<__m128i*>(value), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(shamt), src2);
+  for (size_t i = 0; i < (16 / sizeof(T)); ++i) {
+    value[i] = xe::rotate_left<T>(value[i], shamt[i] & ((sizeof(T) * 8) - 1));
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(value));
+}
+
+template <typename T>
+__m128i EmulateVectorAverage(__m128i src1, __m128i src2) {
+  alignas(16) T src1v[16 / sizeof(T)];
+  alignas(16) T src2v[16 / sizeof(T)];
+  alignas(16) T value[16 / sizeof(T)];
+  _mm_store_si128(reinterpret_cast<__m128i*>(src1v), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(src2v), src2);
+  for (size_t i = 0; i < (16 / sizeof(T)); ++i) {
+    auto t = (uint64_t(src1v[i]) + uint64_t(src2v[i]) + 1) / 2;
+    value[i] = T(t);
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(value));
+}
+
+__m128i EmulatePack8_IN_16_UN_UN_SAT(__m128i src1, __m128i src2) {
+  alignas(16) uint16_t a[8];
+  alignas(16) uint16_t b[8];
+  alignas(16) uint8_t c[16];
+  _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(b), src2);
+  for (int i = 0; i < 8; ++i) {
+    c[i] = uint8_t(std::min(uint16_t(255), a[i]));
+    c[i + 8] = uint8_t(std::min(uint16_t(255), b[i]));
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(c));
+}
+
+__m128i EmulatePack8_IN_16_UN_UN(__m128i src1, __m128i src2) {
+  alignas(16) uint8_t a[16];
+  alignas(16) uint8_t b[16];
+  alignas(16) uint8_t c[16];
+  _mm_store_si128(reinterpret_cast<__m128i*>(a), src1);
+  _mm_store_si128(reinterpret_cast<__m128i*>(b), src2);
+  for (int i = 0; i < 8; ++i) {
+    c[i] = a[i * 2];
+    c[i + 8] = b[i * 2];
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(c));
+}
+
+// Halves in the low words of the dwords, like the sequences produce before
+// their final shuffle.
+__m128i EmulateFloatToHalf(__m128i src) {
+  alignas(16) float a[4];
+  alignas(16) uint32_t b[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(a), src);
+  for (int i = 0; i < 4; ++i) {
+    b[i] = half_float::detail::float2half<std::round_toward_zero>(a[i]);
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(b));
+}
+
+__m128i EmulateHalfToFloat(__m128i src) {
+  alignas(16) uint32_t a[4];
+  alignas(16) float b[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(a), src);
+  for (int i = 0; i < 4; ++i) {
+    b[i] = half_float::detail::half2float(uint16_t(a[i]));
+  }
+  return _mm_load_si128(reinterpret_cast<__m128i*>(b));
+}
+
+// Constants from the xmm_consts table in x64_emitter.cc.
+
+// XMMShlMultipliersI8 and XMMShrMultipliersI8.
+const __m128i kShlMultipliersI8 =
+    _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+const __m128i kShrMultipliersI8 =
+    _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+
+__m128i Splat(uint32_t value) { return _mm_set1_epi32(int(value)); }
+__m128 SplatFloat(uint32_t value) { return _mm_castsi128_ps(Splat(value)); }
+
+// EmitVectorShlInt8, after LoadVectorShiftAmounts.
+__m128i ShlInt8(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, _mm_set1_epi8(0x07));
+  x0 = _mm_shuffle_epi8(kShlMultipliersI8, x0);
+  __m128i x1 = _mm_mullo_epi16(src1, x0);
+  x1 = _mm_and_si128(x1, Splat(0x00FF00FF));
+  x0 = _mm_srli_epi16(x0, 8);
+  __m128i x2 = _mm_and_si128(src1, Splat(0xFF00FF00));
+  x0 = _mm_mullo_epi16(x2, x0);
+  return _mm_or_si128(x1, x0);
+}
+
+// EmitVectorShrInt8.
+__m128i ShrInt8(__m128i src1, __m128i src2, bool is_arithmetic) {
+  __m128i x0 = _mm_and_si128(src2, _mm_set1_epi8(0x07));
+  x0 = _mm_shuffle_epi8(kShrMultipliersI8, x0);
+  __m128i x2;
+  if (is_arithmetic) {
+    x2 = _mm_srai_epi16(_mm_slli_epi16(src1, 8), 8);
+  } else {
+    x2 = _mm_and_si128(src1, Splat(0x00FF00FF));
+  }
+  __m128i x1 = _mm_and_si128(x0, Splat(0x00FF00FF));
+  x2 = _mm_mullo_epi16(x2, x1);
+  if (is_arithmetic) {
+    x2 = _mm_and_si128(_mm_srai_epi16(x2, 7), Splat(0x00FF00FF));
+  } else {
+    x2 = _mm_srli_epi16(x2, 7);
+  }
+  x0 = _mm_srli_epi16(x0, 8);
+  x1 = is_arithmetic ? _mm_srai_epi16(src1, 8) : _mm_srli_epi16(src1, 8);
+  x0 = _mm_mullo_epi16(x1, x0);
+  x0 = _mm_slli_epi16(x0, 1);
+  x0 = _mm_and_si128(x0, Splat(0xFF00FF00));
+  return _mm_or_si128(x2, x0);
+}
+
+// VECTOR_ROTATE_LEFT_V128::EmitInt8.
+__m128i RotateLeftInt8(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, _mm_set1_epi8(0x07));
+  x0 = _mm_shuffle_epi8(kShlMultipliersI8, x0);
+  __m128i x1 = _mm_and_si128(x0, Splat(0x00FF00FF));
+  __m128i x2 = _mm_and_si128(src1, Splat(0x00FF00FF));
+  x1 = _mm_mullo_epi16(x2, x1);
+  x2 = _mm_srli_epi16(x1, 8);
+  x1 = _mm_or_si128(x1, x2);
+  x1 = _mm_and_si128(x1, Splat(0x00FF00FF));
+  x0 = _mm_srli_epi16(x0, 8);
+  x2 = _mm_srli_epi16(src1, 8);
+  x0 = _mm_mullo_epi16(x2, x0);
+  x2 = _mm_slli_epi16(x0, 8);
+  x0 = _mm_or_si128(x0, x2);
+  x0 = _mm_and_si128(x0, Splat(0xFF00FF00));
+  return _mm_or_si128(x1, x0);
+}
+
+// VECTOR_SHL_V128::EmitInt16 without AVX-512.
+__m128i ShlInt16(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x000F000F));
+  __m128i x1 = _mm_slli_epi16(x0, 8);
+  x0 = _mm_or_si128(x0, x1);
+  x0 = _mm_xor_si128(x0, Splat(0x08000800));
+  x0 = _mm_shuffle_epi8(kShlMultipliersI8, x0);
+  return _mm_mullo_epi16(src1, x0);
+}
+
+// VECTOR_SHR_V128::EmitInt16 with AVX2.
+TARGET_AVX2 __m128i ShrInt16AVX2(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x000F000F));
+  __m128i x1 = _mm_and_si128(x0, Splat(0x0000FFFF));
+  __m128i x2 = _mm_and_si128(src1, Splat(0x0000FFFF));
+  x1 = _mm_srlv_epi32(x2, x1);
+  x0 = _mm_srli_epi32(x0, 16);
+  x0 = _mm_srlv_epi32(src1, x0);
+  return _mm_blend_epi16(x1, x0, 0b10101010);
+}
+
+// VECTOR_SHA_V128::EmitInt16 with AVX2.
+TARGET_AVX2 __m128i ShaInt16AVX2(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x000F000F));
+  __m128i x1 = _mm_and_si128(x0, Splat(0x0000FFFF));
+  __m128i x2 = _mm_slli_epi32(src1, 16);
+  x2 = _mm_srav_epi32(x2, x1);
+  x2 = _mm_srli_epi32(x2, 16);
+  x0 = _mm_srli_epi32(x0, 16);
+  x0 = _mm_srav_epi32(src1, x0);
+  return _mm_blend_epi16(x2, x0, 0b10101010);
+}
+
+// VECTOR_ROTATE_LEFT_V128::EmitInt16 with AVX2.
+TARGET_AVX2 __m128i RotateLeftInt16AVX2(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x000F000F));
+  __m128i x1 = _mm_and_si128(x0, Splat(0x0000FFFF));
+  __m128i x2 = _mm_and_si128(src1, Splat(0x0000FFFF));
+  x1 = _mm_sllv_epi32(x2, x1);
+  x2 = _mm_srli_epi32(x1, 16);
+  x1 = _mm_or_si128(x1, x2);
+  x0 = _mm_srli_epi32(x0, 16);
+  x2 = _mm_srli_epi32(src1, 16);
+  x0 = _mm_sllv_epi32(x2, x0);
+  x2 = _mm_slli_epi32(x0, 16);
+  x0 = _mm_or_si128(x0, x2);
+  return _mm_blend_epi16(x1, x0, 0b10101010);
+}
+
+// VECTOR_ROTATE_LEFT_V128::EmitInt32 with AVX2.
+TARGET_AVX2 __m128i RotateLeftInt32AVX2(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x1F));
+  __m128i x1 = _mm_sllv_epi32(src1, x0);
+  __m128i temp = _mm_sub_epi32(Splat(32), x0);
+  return _mm_or_si128(_mm_srlv_epi32(src1, temp), x1);
+}
+
+// The AVX-512 paths of VECTOR_SHL_V128, VECTOR_SHR_V128, VECTOR_SHA_V128 and
+// VECTOR_ROTATE_LEFT_V128 for INT16_TYPE.
+TARGET_AVX512 __m128i ShlInt16AVX512(__m128i src1, __m128i src2) {
+  return _mm_sllv_epi16(src1, _mm_and_si128(src2, Splat(0x000F000F)));
+}
+TARGET_AVX512 __m128i ShrInt16AVX512(__m128i src1, __m128i src2) {
+  return _mm_srlv_epi16(src1, _mm_and_si128(src2, Splat(0x000F000F)));
+}
+TARGET_AVX512 __m128i ShaInt16AVX512(__m128i src1, __m128i src2) {
+  return _mm_srav_epi16(src1, _mm_and_si128(src2, Splat(0x000F000F)));
+}
+TARGET_AVX512 __m128i RotateLeftInt16AVX512(__m128i src1, __m128i src2) {
+  __m128i x0 = _mm_and_si128(src2, Splat(0x000F000F));
+  __m128i x1 = _mm_sllv_epi16(src1, x0);
+  x0 = _mm_sub_epi16(Splat(0x00100010), x0);
+  x0 = _mm_srlv_epi16(src1, x0);
+  return _mm_or_si128(x1, x0);
+}
+
+// VECTOR_ROTATE_LEFT_V128::EmitInt32 with AVX-512.
+TARGET_AVX512 __m128i RotateLeftInt32AVX512(__m128i src1, __m128i src2) {
+  return _mm_rolv_epi32(src1, src2);
+}
+
+// VECTOR_AVERAGE for INT32_TYPE.
+__m128i AverageInt32(__m128i src1, __m128i src2, bool is_unsigned) {
+  __m128i x1 = _mm_xor_si128(src1, src2);
+  x1 = is_unsigned ? _mm_srli_epi32(x1, 1) : _mm_srai_epi32(x1, 1);
+  return _mm_sub_epi32(_mm_or_si128(src1, src2), x1);
+}
+
+// PACK::Emit8_IN_16 from unsigned to unsigned, before the byte order
+// shuffle.
+__m128i Pack8In16(__m128i src1, __m128i src2, bool saturate) {
+  __m128i x0, x1;
+  if (saturate) {
+    x0 = _mm_min_epu16(src1, Splat(0x00FF00FF));
+    x1 = _mm_min_epu16(src2, Splat(0x00FF00FF));
+  } else {
+    x0 = _mm_and_si128(src1, Splat(0x00FF00FF));
+    x1 = _mm_and_si128(src2, Splat(0x00FF00FF));
+  }
+  return _mm_packus_epi16(x0, x1);
+}
+
+// PACK::EmitFloatToHalf, before vpackusdw.
+__m128i FloatToHalf(__m128i src) {
+  __m128i x0 = _mm_and_si128(src, Splat(0x7FFFFFFF));
+  __m128 x1f = _mm_mul_ps(_mm_castsi128_ps(x0), _mm_set1_ps(16777216.0f));
+  __m128i x1 = _mm_cvttps_epi32(x1f);
+  __m128i x2 = _mm_sub_epi32(_mm_srli_epi32(x0, 13), Splat(0x0001C000));
+  __m128i x3 = _mm_cmpgt_epi32(x0, Splat(0x387FFFFF));
+  x1 = _mm_blendv_epi8(x1, x2, x3);
+  x3 = _mm_cmpgt_epi32(x0, Splat(0x477FFFFF));
+  x1 = _mm_blendv_epi8(x1, Splat(0x00007BFF), x3);
+  x2 = _mm_sub_epi32(_mm_srli_epi32(x0, 13), Splat(0x00038000));
+  x3 = _mm_cmpgt_epi32(x0, Splat(0x7F7FFFFF));
+  x1 = _mm_blendv_epi8(x1, x2, x3);
+  x3 = _mm_cmpgt_epi32(x0, Splat(0x7F800000));
+  x3 = _mm_and_si128(x3, Splat(0x00000200));
+  x1 = _mm_or_si128(x1, x3);
+  x0 = _mm_and_si128(_mm_srli_epi32(src, 16), Splat(0x80008000));
+  return _mm_or_si128(x1, x0);
+}
+
+// PACK::EmitFLOAT16_4 with F16C, widened back to dwords.
+TARGET_F16C __m128i FloatToHalfF16C(__m128i src) {
+  __m128i x0 = _mm_cvtps_ph(_mm_castsi128_ps(src), 0b00000011);
+  return _mm_unpacklo_epi16(x0, _mm_setzero_si128());
+}
+
+// UNPACK::EmitHalfToFloat.
+__m128i HalfToFloat(__m128i src) {
+  __m128i x0 = _mm_and_si128(src, Splat(0x00007FFF));
+  __m128i x1 = _mm_xor_si128(src, x0);
+  __m128 x2 = _mm_castsi128_ps(_mm_slli_epi32(x0, 13));
+  x2 = _mm_mul_ps(x2, SplatFloat(0x77800000));
+  x0 = _mm_cmpgt_epi32(x0, Splat(0x00007BFF));
+  x0 = _mm_and_si128(x0, Splat(0x7F800000));
+  x1 = _mm_slli_epi32(x1, 16);
+  x0 = _mm_or_si128(x0, x1);
+  return _mm_or_si128(_mm_castps_si128(x2), x0);
+}
+
+// UNPACK::EmitFLOAT16_4 with F16C, on the halves in the low words.
+TARGET_F16C __m128i HalfToFloatF16C(__m128i src) {
+  __m128i x0 = _mm_shuffle_epi8(
+      src, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1,
+                         -1));
+  return _mm_castps_si128(_mm_cvtph_ps(x0));
+}
+
+bool Equal(__m128i a, __m128i b) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF;
+}
+
+vec128_t Store(__m128i value) {
+  vec128_t result;
+  _mm_store_si128(reinterpret_cast<__m128i*>(&result), value);
+  return result;
+}
+
+__m128i Load(const vec128_t& value) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(&value));
+}
+
+// Random vectors, plus shift amounts that cover every count in every lane.
+std::vector<vec128_t> MakeTestVectors(size_t count) {
+  std::vector<vec128_t> vectors;
+  for (int i = 0; i < 16; ++i) {
+    vectors.push_back(Store(_mm_add_epi8(
+        _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm_set1_epi8(char(i * 16)))));
+    vectors.push_back(
+        Store(_mm_add_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7),
+                            _mm_set1_epi16(short(i * 8)))));
+    vectors.push_back(Store(
+        _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(i * 4))));
+  }
+  for (uint32_t value : {0x00000000u, 0xFFFFFFFFu, 0x80008000u, 0x7FFF7FFFu,
+                         0x80808080u, 0x7F7F7F7Fu}) {
+    vectors.push_back(Store(Splat(value)));
+  }
+  std::mt19937_64 random(0x360);
+  while (vectors.size() < count) {
+    vectors.push_back(
+        Store(_mm_set_epi64x(int64_t(random()), int64_t(random()))));
+  }
+  return vectors;
+}
+
+template <typename F, typename R>
+void CheckBinaryOp(const std::vector<vec128_t>& vectors, F sequence,
+                   R reference) {
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    for (size_t j = 0; j < vectors.size(); j += 1 + (i & 7)) {
+      __m128i src1 = Load(vectors[i]);
+      __m128i src2 = Load(vectors[j]);
+      REQUIRE(Equal(sequence(src1, src2), reference(src1, src2)));
+    }
+  }
+}
+
+Xbyak::util::Cpu cpu;
+
+bool HasAVX512() {
+  return cpu.has(Xbyak::util::Cpu::tAVX512F) &&
+         cpu.has(Xbyak::util::Cpu::tAVX512VL) &&
+         cpu.has(Xbyak::util::Cpu::tAVX512BW);
+}
+
+}  // namespace
+
+TEST_CASE("X64_VECTOR_SHIFT_I8", "[x64_sequences]") {
+  auto vectors = MakeTestVectors(1024);
+  CheckBinaryOp(vectors, ShlInt8, EmulateVectorShl<uint8_t>);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return ShrInt8(a, b, false); },
+      EmulateVectorShr<uint8_t>);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return ShrInt8(a, b, true); },
+      EmulateVectorShr<int8_t>);
+  CheckBinaryOp(vectors, RotateLeftInt8, EmulateVectorRotateLeft<uint8_t>);
+}
+
+TEST_CASE("X64_VECTOR_SHIFT_I16", "[x64_sequences]") {
+  auto vectors = MakeTestVectors(1024);
+  CheckBinaryOp(vectors, ShlInt16, EmulateVectorShl<uint16_t>);
+  if (cpu.has(Xbyak::util::Cpu::tAVX2)) {
+    CheckBinaryOp(vectors, ShrInt16AVX2, EmulateVectorShr<uint16_t>);
+    CheckBinaryOp(vectors, ShaInt16AVX2, EmulateVectorShr<int16_t>);
+    CheckBinaryOp(vectors, RotateLeftInt16AVX2,
+                  EmulateVectorRotateLeft<uint16_t>);
+  }
+  if (HasAVX512()) {
+    CheckBinaryOp(vectors, ShlInt16AVX512, EmulateVectorShl<uint16_t>);
+    CheckBinaryOp(vectors, ShrInt16AVX512, EmulateVectorShr<uint16_t>);
+    CheckBinaryOp(vectors, ShaInt16AVX512, EmulateVectorShr<int16_t>);
+    CheckBinaryOp(vectors, RotateLeftInt16AVX512,
+                  EmulateVectorRotateLeft<uint16_t>);
+  }
+}
+
+TEST_CASE("X64_VECTOR_ROTATE_LEFT_I32", "[x64_sequences]") {
+  auto vectors = MakeTestVectors(1024);
+  if (cpu.has(Xbyak::util::Cpu::tAVX2)) {
+    CheckBinaryOp(vectors, RotateLeftInt32AVX2,
+                  EmulateVectorRotateLeft<uint32_t>);
+  }
+  if (HasAVX512()) {
+    CheckBinaryOp(vectors, RotateLeftInt32AVX512,
+                  EmulateVectorRotateLeft<uint32_t>);
+  }
+}
+
+TEST_CASE("X64_VECTOR_AVERAGE_I32", "[x64_sequences]") {
+  auto vectors = MakeTestVectors(1024);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return AverageInt32(a, b, true); },
+      EmulateVectorAverage<uint32_t>);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return AverageInt32(a, b, false); },
+      EmulateVectorAverage<int32_t>);
+}
+
+TEST_CASE("X64_PACK_8_IN_16", "[x64_sequences]") {
+  auto vectors = MakeTestVectors(1024);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return Pack8In16(a, b, true); },
+      EmulatePack8_IN_16_UN_UN_SAT);
+  CheckBinaryOp(
+      vectors, [](__m128i a, __m128i b) { return Pack8In16(a, b, false); },
+      EmulatePack8_IN_16_UN_UN);
+}
+
+TEST_CASE("X64_FLOAT16", "[x64_sequences]") {
+  bool has_f16c = cpu.has(Xbyak::util::Cpu::tF16C);
+  // Like vcvtph2ps and vcvtps2ph, which set the quiet bit of NaNs. The
+  // emulation kept signaling NaNs when unpacking and turned NaNs with only
+  // the low mantissa bits set into infinity when packing.
+  auto quiet_nans = [](__m128i value, __m128i src, uint32_t abs_mask,
+                       uint32_t infinity, uint32_t quiet_bit) {
+    __m128i nan =
+        _mm_cmpgt_epi32(_mm_and_si128(src, Splat(abs_mask)), Splat(infinity));
+    return _mm_or_si128(value, _mm_and_si128(nan, Splat(quiet_bit)));
+  };
+
+  // Every half.
+  for (uint32_t value = 0; value < 0x10000; value += 4) {
+    __m128i src = _mm_setr_epi32(value, value + 1, value + 2, value + 3);
+    auto expected = EmulateHalfToFloat(src);
+    REQUIRE(Equal(HalfToFloat(src), expected));
+    if (has_f16c) {
+      expected = quiet_nans(expected, src, 0x7FFF, 0x7C00, 0x00400000);
+      REQUIRE(Equal(HalfToFloatF16C(src), expected));
+    }
+  }
+
+  auto check_float_to_half = [&](__m128i src) {
+    auto expected = quiet_nans(EmulateFloatToHalf(src), src, 0x7FFFFFFF,
+                               0x7F800000, 0x0200);
+    REQUIRE(Equal(FloatToHalf(src), expected));
+    if (has_f16c) {
+      REQUIRE(Equal(FloatToHalfF16C(src), expected));
+    }
+  };
+  // Every float exponent and sign with a stride over the mantissa.
+  for (uint64_t value = 0; value < 0x100000000ull; value += 4 * 4099) {
+    check_float_to_half(_mm_add_epi32(Splat(uint32_t(value)),
+                                      _mm_setr_epi32(0, 1, 0x200, 0x1000)));
+  }
+  // Rounding and range boundaries, and NaNs with only the low mantissa bits
+  // set.
+  const uint32_t special_values[] = {
+      0x00000000, 0x00000001, 0x337FFFFF, 0x33800000, 0x387FFFFF, 0x38800000,
+      0x477FE000, 0x477FFFFF, 0x47800000, 0x7F7FFFFF, 0x7F800000, 0x7F800001,
+      0x7F801FFF, 0x7F802000, 0x7FC00000, 0x7FFFFFFF,
+  };
+  for (uint32_t value : special_values) {
+    check_float_to_half(Splat(value));
+    check_float_to_half(Splat(value | 0x80000000));
+  }
+}
+
+// Hidden by default, run with "[.benchmark]" or
+// "[x64_sequences_benchmark]". The emulation is called through a pointer
+// like CallNativeSafe does, but without the register spills around the call,
+// so the real thunks are slower than this.
+TEST_CASE("X64_VECTOR_SEQUENCES_BENCHMARK",
+          "[.benchmark][x64_sequences_benchmark]") {
+  const size_t kIterations = 1 << 24;
+  auto vectors = MakeTestVectors(4096);
+  size_t mask = vectors.size() - 1;
+
+  // Chain the results so the calls can't be overlapped or skipped.
+  auto measure = [&](auto function) {
+    __m128i result = _mm_setzero_si128();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+      result = function(_mm_xor_si128(Load(vectors[i & mask]), result),
+                        Load(vectors[(i + 1) & mask]));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(_mm_cvtsi128_si32(result) != 0x12345678);
+    return std::chrono::duration<double, std::nano>(elapsed).count() /
+           kIterations;
+  };
+  auto run = [&](const char* name, auto sequence,
+                 __m128i (*emulation)(__m128i, __m128i)) {
+    double sequence_ns = measure(sequence);
+    __m128i (*volatile thunk)(__m128i, __m128i) = emulation;
+    double emulation_ns =
+        measure([&](__m128i a, __m128i b) { return thunk(a, b); });
+    std::printf("%-30s inline %5.2f ns, emulated %5.2f ns\n", name,
+                sequence_ns, emulation_ns);
+  };
+
+  run("VECTOR_SHL I8", [](__m128i a, __m128i b) { return ShlInt8(a, b); },
+      EmulateVectorShl<uint8_t>);
+  run("VECTOR_SHA I8", [](__m128i a, __m128i b) { return ShrInt8(a, b, true); },
+      EmulateVectorShr<int8_t>);
+  run("VECTOR_ROTATE_LEFT I8",
+      [](__m128i a, __m128i b) { return RotateLeftInt8(a, b); },
+      EmulateVectorRotateLeft<uint8_t>);
+  run("VECTOR_SHL I16", [](__m128i a, __m128i b) { return ShlInt16(a, b); },
+      EmulateVectorShl<uint16_t>);
+  if (cpu.has(Xbyak::util::Cpu::tAVX2)) {
+    run("VECTOR_SHR I16 (AVX2)",
+        [](__m128i a, __m128i b) { return ShrInt16AVX2(a, b); },
+        EmulateVectorShr<uint16_t>);
+    run("VECTOR_ROTATE_LEFT I32 (AVX2)",
+        [](__m128i a, __m128i b) { return RotateLeftInt32AVX2(a, b); },
+        EmulateVectorRotateLeft<uint32_t>);
+  }
+  if (HasAVX512()) {
+    run("VECTOR_SHR I16 (AVX-512)",
+        [](__m128i a, __m128i b) { return ShrInt16AVX512(a, b); },
+        EmulateVectorShr<uint16_t>);
+  }
+  run("VECTOR_AVERAGE I32",
+      [](__m128i a, __m128i b) { return AverageInt32(a, b, true); },
+      EmulateVectorAverage<uint32_t>);
+  run("PACK 8_IN_16",
+      [](__m128i a, __m128i b) { return Pack8In16(a, b, true); },
+      EmulatePack8_IN_16_UN_UN_SAT);
+  run("PACK FLOAT16_4", [](__m128i a, __m128i) { return FloatToHalf(a); },
+      [](__m128i a, __m128i) { return EmulateFloatToHalf(a); });
+  run("UNPACK FLOAT16_4", [](__m128i a, __m128i) { return HalfToFloat(a); },
+      [](__m128i a, __m128i) { return EmulateHalfToFloat(a); });
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/tier_up_compiler.h"
+
+#include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
+#include "xenia/cpu/function.h"
+#include "xenia/cpu/ppc/ppc_frontend.h"
+#include "xenia/cpu/processor.h"
+
+namespace xe {
+namespace cpu {
+
+TierUpCompiler::TierUpCompiler(Processor* processor) : processor_(processor) {
+  worker_thread_ =
+      xe::threading::Thread::Create({}, [this]() { WorkerThread(); });
+  worker_thread_->set_name("Tier Up Compilation");
+  worker_thread_->set_priority(xe::threading::ThreadPriority::kBelowNormal);
+}
+
+TierUpCompiler::~TierUpCompiler() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    shutdown_ = true;
+  }
+  queue_cond_.notify_all();
+  xe::threading::Wait(worker_thread_.get(), false);
+  worker_thread_.reset();
+  XELOGI("Tier up compilation stopped: %u functions promoted, %u failed",
+         promoted_count_.load(), failed_count_.load());
+}
+
+void TierUpCompiler::Enqueue(GuestFunction* function) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (shutdown_ || !requested_.insert(function).second) {
+      return;
+    }
+    queue_.push_back(function);
+  }
+  queue_cond_.notify_one();
+}
+
+void TierUpCompiler::WorkerThread() {
+  while (true) {
+    GuestFunction* function;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cond_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+      if (shutdown_) {
+        break;
+      }
+      function = queue_.front();
+      queue_.pop_front();
+    }
+
+    if (function->tier() != GuestFunction::Tier::kBaseline) {
+      continue;
+    }
+    SCOPE_profile_cpu_i("cpu", "TierUpCompiler::Compile");
+    // Baseline code is never built with debug info.
+    if (processor_->frontend()->DefineFunction(function, 0)) {
+      ++promoted_count_;
+    } else {
+      // The baseline code stays in place.
+      XELOGW("Unable to recompile hot function %.8X", function->address());
+      ++failed_count_;
+    }
+  }
+}
+
+}  // namespace cpu
+}  // namespace xe
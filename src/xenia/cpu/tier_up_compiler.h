@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_TIER_UP_COMPILER_H_
+#define XENIA_CPU_TIER_UP_COMPILER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include "xenia/base/threading.h"
+
+namespace xe {
+namespace cpu {
+
+class GuestFunction;
+class Processor;
+
+// Recompiles hot baseline functions with the full optimization pipeline on a
+// worker thread (see --tiered_compilation).
+//
+// The new code is published through the indirection table, which also
+// repoints linked calls and inline caches, so callers pick it up on their
+// next call. Activations already running the baseline code finish in it.
+class TierUpCompiler {
+ public:
+  explicit TierUpCompiler(Processor* processor);
+  ~TierUpCompiler();
+
+  // Called from baseline code once the entry counter of the function runs
+  // out. Never blocks on compilation.
+  void Enqueue(GuestFunction* function);
+
+ private:
+  void WorkerThread();
+
+  Processor* processor_ = nullptr;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::deque<GuestFunction*> queue_;
+  // Queued or promoted, as counters may run out more than once.
+  std::unordered_set<GuestFunction*> requested_;
+  bool shutdown_ = false;
+
+  std::unique_ptr<xe::threading::Thread> worker_thread_;
+
+  std::atomic<uint32_t> promoted_count_ = {0};
+  std::atomic<uint32_t> failed_count_ = {0};
+};
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_TIER_UP_COMPILER_H_
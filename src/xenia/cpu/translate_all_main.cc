@@ -0,0 +1,184 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "xenia/base/clock.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/main.h"
+#include "xenia/base/platform.h"
+#include "xenia/base/string.h"
+#include "xenia/cpu/function.h"
+#include "xenia/cpu/ppc/ppc_scanner.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/cpu/xex_module.h"
+#include "xenia/emulator.h"
+#include "xenia/kernel/kernel_state.h"
+#include "xenia/kernel/user_module.h"
+#include "xenia/vfs/devices/host_path_device.h"
+#include "xenia/vfs/virtual_file_system.h"
+
+#if XE_PLATFORM_WIN32
+#include "xenia/base/platform_win.h"
+
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif  // XE_PLATFORM_WIN32
+
+DEFINE_transient_string(target_xex, "", "Specifies the XEX to translate.",
+                        "General");
+
+namespace xe {
+namespace cpu {
+
+// Highest resident memory use of the process so far, in bytes.
+static uint64_t QueryPeakResidentBytes() {
+#if XE_PLATFORM_WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+  // Kilobytes on Linux.
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif  // XE_PLATFORM_WIN32
+}
+
+// Loads a XEX without running it and translates every function that can be
+// found in it on this thread, then reports the translation time, the size of
+// the generated code and the peak memory use, so that changes to the
+// translator can be compared on real code.
+// Functions are found from the module symbols and exception table, plus the
+// call targets of everything translated, like the background compiler does.
+// Run it with the same cvars (such as --tiered_compilation) as the emulator
+// to measure the same pipeline, or toggle one (such as
+// --vector_constant_pool) to measure what it changes.
+// With --log_jit_stats the totals of the passes (such as context loads
+// replaced and stores removed) and the number of guest calls inlined are
+// logged on exit too, so a run with --inline_guest_calls=false shows what
+// inlining changes.
+int translate_all_main(const std::vector<std::wstring>& args) {
+  std::wstring path;
+  if (!cvars::target_xex.empty()) {
+    path = xe::to_wstring(cvars::target_xex);
+  } else if (args.size() >= 2) {
+    path = args[1];
+  }
+  if (path.empty()) {
+    XELOGE("Usage: %S [target_xex]", args[0].c_str());
+    return 1;
+  }
+  path = xe::to_absolute_path(path);
+
+  // Only the CPU and kernel are needed to load a module.
+  auto emulator = std::make_unique<Emulator>(L"", L"", L"");
+  X_STATUS result = emulator->Setup(nullptr, nullptr, nullptr, nullptr);
+  if (XFAILED(result)) {
+    XELOGE("Failed to setup emulator: %.8X", result);
+    return 1;
+  }
+
+  // Mounted the same way as Emulator::LaunchXexFile does.
+  auto mount_path = "\\Device\\Harddisk0\\Partition0";
+  auto device = std::make_unique<vfs::HostPathDevice>(
+      mount_path, xe::find_base_path(path), true);
+  if (!device->Initialize() ||
+      !emulator->file_system()->RegisterDevice(std::move(device))) {
+    XELOGE("Unable to mount %S", path.c_str());
+    return 1;
+  }
+  emulator->file_system()->RegisterSymbolicLink("game:", mount_path);
+  emulator->file_system()->RegisterSymbolicLink("d:", mount_path);
+  std::string module_path =
+      "game:\\" + xe::to_string(xe::find_name_from_path(path));
+  auto module =
+      emulator->kernel_state()->LoadUserModule(module_path.c_str(), false);
+  if (!module) {
+    XELOGE("Failed to load %S", path.c_str());
+    return 1;
+  }
+  XexModule* xex_module = module->xex_module();
+  Processor* processor = emulator->processor();
+
+  std::vector<uint32_t> pending = xex_module->GetExceptionTableFunctions();
+  xex_module->ForEachFunction([&pending](Function* function) {
+    if (function->is_guest() &&
+        function->behavior() != Function::Behavior::kExtern) {
+      pending.push_back(function->address());
+    }
+  });
+  if (module->entry_point()) {
+    pending.push_back(module->entry_point());
+  }
+  std::sort(pending.begin(), pending.end());
+  pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+  std::unordered_set<uint32_t> seen(pending.begin(), pending.end());
+  // Reversed so that functions are translated in address order.
+  std::reverse(pending.begin(), pending.end());
+
+  ppc::PPCScanner scanner(processor->frontend());
+  uint64_t load_peak_bytes = QueryPeakResidentBytes();
+  uint32_t translated_count = 0;
+  uint32_t failed_count = 0;
+  uint64_t code_bytes = 0;
+  uint64_t start_ticks = Clock::QueryHostTickCount();
+  while (!pending.empty()) {
+    uint32_t address = pending.back();
+    pending.pop_back();
+    Function* function = processor->ResolveFunction(address);
+    if (!function) {
+      ++failed_count;
+      continue;
+    }
+    auto guest_function = static_cast<GuestFunction*>(function);
+    ++translated_count;
+    code_bytes += guest_function->machine_code_length();
+    auto callees = scanner.FindCallTargets(guest_function);
+    for (uint32_t callee : callees) {
+      if (xex_module->ContainsAddress(callee) && seen.insert(callee).second) {
+        pending.push_back(callee);
+      }
+    }
+  }
+  uint64_t ticks = Clock::QueryHostTickCount() - start_ticks;
+  uint64_t peak_bytes = QueryPeakResidentBytes();
+
+  double elapsed_ms = ticks * 1000.0 / Clock::QueryHostTickFrequency();
+  XELOGI("Translated %u functions (%u failed) in %.1fms, %.1fus/function",
+         translated_count, failed_count, elapsed_ms,
+         translated_count ? elapsed_ms * 1000.0 / translated_count : 0.0);
+  XELOGI("Generated %" PRIu64 " bytes of code, %.1f bytes/function",
+         code_bytes,
+         translated_count ? double(code_bytes) / translated_count : 0.0);
+  XELOGI("Peak resident memory: %" PRIu64 "MB after loading, %" PRIu64
+         "MB after translating (+%" PRIu64 "MB)",
+         load_peak_bytes >> 20, peak_bytes >> 20,
+         (peak_bytes - load_peak_bytes) >> 20);
+
+  module.reset();
+  emulator.reset();
+  return 0;
+}
+
+}  // namespace cpu
+}  // namespace xe
+
+DEFINE_ENTRY_POINT(L"xenia-cpu-translate-all", xe::cpu::translate_all_main,
+                   "[target_xex]", "target_xex");
@@ -118,6 +118,35 @@ const PESection* XexModule::GetPESection(const char* name) {
   return nullptr;
 }
 
+std::vector<uint32_t> XexModule::GetExceptionTableFunctions() {
+  std::vector<uint32_t> addresses;
+  auto pdata = GetPESection(".pdata");
+  if (!pdata) {
+    return addresses;
+  }
+
+  // IMAGE_CE_RUNTIME_FUNCTION_ENTRY, big endian:
+  // FuncStart : 32
+  // PrologLen : 8, FuncLen : 22 (instructions), ThirtyTwoBit : 1,
+  // ExceptionFlag : 1
+  auto entries =
+      memory()->TranslateVirtual<const xe::be<uint32_t>*>(pdata->address);
+  uint32_t entry_count = pdata->size / 8;
+  addresses.reserve(entry_count);
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    uint32_t address = entries[i * 2];
+    uint32_t function_length = (entries[i * 2 + 1] >> 8) & 0x3FFFFF;
+    if (!address || !function_length || !ContainsAddress(address)) {
+      continue;
+    }
+    addresses.push_back(address);
+  }
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+                  addresses.end());
+  return addresses;
+}
+
 uint32_t XexModule::GetProcAddress(uint16_t ordinal) const {
   // First: Check the xex2 export table.
   if (xex_security_info()->export_table) {
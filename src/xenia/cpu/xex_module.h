@@ -131,6 +131,10 @@ class XexModule : public xe::cpu::Module {
 
   const PESection* GetPESection(const char* name);
 
+  // Start addresses of the functions described by the exception table
+  // (.pdata), in ascending order.
+  std::vector<uint32_t> GetExceptionTableFunctions();
+
   uint32_t GetProcAddress(uint16_t ordinal) const;
   uint32_t GetProcAddress(const char* name) const;
 
@@ -142,6 +146,10 @@ class XexModule : public xe::cpu::Module {
 
   bool ContainsAddress(uint32_t address) override;
 
+  // Range of the code sections in guest memory.
+  uint32_t low_address() const { return low_address_; }
+  uint32_t high_address() const { return high_address_; }
+
   const std::string& name() const override { return name_; }
   bool is_executable() const override {
     return (xex_header()->module_flags & XEX_MODULE_TITLE) != 0;
@@ -170,9 +170,11 @@ X_STATUS Emulator::Setup(
   }
 
   // Initialize the GPU.
-  graphics_system_ = graphics_system_factory();
-  if (!graphics_system_) {
-    return X_STATUS_NOT_IMPLEMENTED;
+  if (graphics_system_factory) {
+    graphics_system_ = graphics_system_factory();
+    if (!graphics_system_) {
+      return X_STATUS_NOT_IMPLEMENTED;
+    }
   }
 
   // Initialize the HID.
@@ -199,10 +201,12 @@ X_STATUS Emulator::Setup(
   kernel_state_ = std::make_unique<xe::kernel::KernelState>(this);
 
   // Setup the core components.
-  result = graphics_system_->Setup(processor_.get(), kernel_state_.get(),
-                                   display_window_);
-  if (result) {
-    return result;
+  if (graphics_system_) {
+    result = graphics_system_->Setup(processor_.get(), kernel_state_.get(),
+                                     display_window_);
+    if (result) {
+      return result;
+    }
   }
 
   if (audio_system_) {
@@ -239,7 +243,9 @@ X_STATUS Emulator::TerminateTitle() {
     return X_STATUS_UNSUCCESSFUL;
   }
 
+  processor_->StopBackgroundCompilation();
   kernel_state_->TerminateTitle();
+  processor_->ShutdownCodeStorage();
   title_id_ = 0;
   game_title_ = L"";
   on_terminate();
@@ -407,7 +413,15 @@ void Emulator::Resume() {
   }
 }
 
-bool Emulator::SaveToFile(const std::wstring& path) {
+bool Emulator::SaveToFile(const std::wstring& path, bool incremental) {
+  // Incremental states reference the last full one, so it must still be there.
+  if (incremental &&
+      (save_state_base_path_.empty() || path == save_state_base_path_)) {
+    XELOGW("No full save state to save an incremental one against");
+    incremental = false;
+  }
+  uint64_t start_time = Clock::QueryHostUptimeMillis();
+
   Pause();
 
   filesystem::CreateFile(path);
@@ -421,6 +435,12 @@ bool Emulator::SaveToFile(const std::wstring& path) {
   ByteStream stream(map->data(), map->size());
   stream.Write('XSAV');
   stream.Write(title_id_);
+  stream.Write(incremental ? xe::to_string(save_state_base_path_)
+                           : std::string());
+  // Offset of the memory, filled in later, for incremental states to read
+  // unchanged pages from.
+  size_t memory_offset_offset = stream.offset();
+  stream.Write(uint64_t(0));
 
   // It's important we don't hold the global lock here! XThreads need to step
   // forward (possibly through guarded regions) without worry!
@@ -428,14 +448,29 @@ bool Emulator::SaveToFile(const std::wstring& path) {
   graphics_system_->Save(&stream);
   audio_system_->Save(&stream);
   kernel_state_->Save(&stream);
-  memory_->Save(&stream);
-  map->Close(stream.offset());
+  uint64_t memory_offset = stream.offset();
+  stream.set_offset(memory_offset_offset);
+  stream.Write(memory_offset);
+  stream.set_offset(size_t(memory_offset));
+  memory_->Save(&stream, incremental);
+  uint64_t size = stream.offset();
+  map->Close(size);
+
+  if (!incremental) {
+    save_state_base_path_ = path;
+  }
 
   Resume();
+
+  XELOGI("Saved %s state to %S: %" PRIu64 " bytes in %" PRIu64 " ms",
+         incremental ? "incremental" : "full", path.c_str(), size,
+         Clock::QueryHostUptimeMillis() - start_time);
   return true;
 }
 
 bool Emulator::RestoreFromFile(const std::wstring& path) {
+  uint64_t start_time = Clock::QueryHostUptimeMillis();
+
   // Restore the emulator state from a file
   auto map = MappedMemory::Open(path, MappedMemory::Mode::kReadWrite);
   if (!map) {
@@ -461,6 +496,29 @@ bool Emulator::RestoreFromFile(const std::wstring& path) {
     return false;
   }
 
+  // Pages unchanged in an incremental state are streamed from the full one.
+  auto base_path = xe::to_wstring(stream.Read<std::string>());
+  stream.Advance(sizeof(uint64_t));
+  std::unique_ptr<MappedMemory> base_map;
+  std::unique_ptr<ByteStream> base_stream;
+  if (!base_path.empty()) {
+    base_map = MappedMemory::Open(base_path, MappedMemory::Mode::kRead);
+    if (!base_map) {
+      XELOGE("Could not open the full state %S of the incremental state",
+             base_path.c_str());
+      return false;
+    }
+    base_stream =
+        std::make_unique<ByteStream>(base_map->data(), base_map->size());
+    if (base_stream->Read<uint32_t>() != 'XSAV' ||
+        base_stream->Read<uint32_t>() != title_id_ ||
+        !base_stream->Read<std::string>().empty()) {
+      XELOGE("%S is not a full state of this title", base_path.c_str());
+      return false;
+    }
+    base_stream->set_offset(size_t(base_stream->Read<uint64_t>()));
+  }
+
   if (!processor_->Restore(&stream)) {
     XELOGE("Could not restore processor!");
     return false;
@@ -477,7 +535,7 @@ bool Emulator::RestoreFromFile(const std::wstring& path) {
     XELOGE("Could not restore kernel state!");
     return false;
   }
-  if (!memory_->Restore(&stream)) {
+  if (!memory_->Restore(&stream, base_stream.get())) {
     XELOGE("Could not restore memory!");
     return false;
   }
@@ -497,6 +555,9 @@ bool Emulator::RestoreFromFile(const std::wstring& path) {
   restore_fence_.Signal();
   restoring_ = false;
 
+  XELOGI("Restored state from %S in %" PRIu64 " ms", path.c_str(),
+         Clock::QueryHostUptimeMillis() - start_time);
+
   return true;
 }
 
@@ -695,6 +756,11 @@ X_STATUS Emulator::CompleteLaunch(const std::wstring& path,
   graphics_system_->InitializeShaderStorage(storage_root_, title_id_, true);
   on_shader_storage_initialization(false);
 
+  processor_->InitializeCodeStorage(storage_root_, title_id_,
+                                    module->xex_module());
+  processor_->StartBackgroundCompilation(module->xex_module(),
+                                         module->entry_point());
+
   auto main_thread = kernel_state_->LaunchModule(module);
   if (!main_thread) {
     return X_STATUS_UNSUCCESSFUL;
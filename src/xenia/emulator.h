@@ -107,7 +107,8 @@ class Emulator {
   // The given window is used for display and the provided functions are used
   // to create subsystems as required.
   // Once this function returns a game can be launched using one of the Launch
-  // functions.
+  // functions. Tools that only load modules may pass no graphics system
+  // factory, but can't launch anything then.
   X_STATUS Setup(
       ui::Window* display_window,
       std::function<std::unique_ptr<apu::AudioSystem>(cpu::Processor*)>
@@ -139,7 +140,10 @@ class Emulator {
   void Resume();
   bool is_paused() const { return paused_; }
 
-  bool SaveToFile(const std::wstring& path);
+  // Saves the state of the emulator. Incremental states only contain the
+  // memory pages that changed since the last full state saved, and need it to
+  // be restored.
+  bool SaveToFile(const std::wstring& path, bool incremental = false);
   bool RestoreFromFile(const std::wstring& path);
 
   // The game can request another title to be loaded.
@@ -188,6 +192,8 @@ class Emulator {
   bool paused_;
   bool restoring_;
   threading::Fence restore_fence_;  // Fired on restore finish.
+  // Last full save state, for incremental ones.
+  std::wstring save_state_base_path_;
 };
 
 }  // namespace xe
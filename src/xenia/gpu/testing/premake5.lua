@@ -0,0 +1,10 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-gpu-tests", project_root, ".", {
+  links = {
+    "xenia-base",
+    "xenia-gpu",
+    "xxhash",
+  },
+})
@@ -0,0 +1,184 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "xenia/base/math.h"
+#include "xenia/gpu/texture_conversion.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+using namespace texture_conversion;
+
+namespace {
+
+const TextureFormat kFormats[] = {
+    TextureFormat::k_8,           // 1 byte per block.
+    TextureFormat::k_5_6_5,       // 2 bytes per block.
+    TextureFormat::k_8_8_8_8,     // 4 bytes per block.
+    TextureFormat::k_DXT1,        // 8 bytes per block.
+    TextureFormat::k_DXT4_5,      // 16 bytes per block.
+};
+
+const Endian kEndians[] = {Endian::kNone, Endian::k8in16, Endian::k8in32,
+                           Endian::k16in32};
+
+struct UntileTest {
+  UntileInfo info;
+  std::vector<uint8_t> input;
+};
+
+UntileTest CreateUntileTest(const FormatInfo* format_info, Endian endian,
+                            uint32_t width, uint32_t height, uint32_t offset_x,
+                            uint32_t offset_y, std::mt19937& random) {
+  UntileTest test;
+  std::memset(&test.info, 0, sizeof(test.info));
+  test.info.offset_x = offset_x;
+  test.info.offset_y = offset_y;
+  test.info.width = width;
+  test.info.height = height;
+  test.info.input_pitch = xe::round_up(offset_x + width, 32);
+  test.info.output_pitch = width;
+  test.info.input_format_info = format_info;
+  test.info.output_format_info = format_info;
+  test.info.endian = endian;
+  // Tiled surfaces are laid out in 4 KB units. The generic path may also
+  // access a bit past the blocks with swapping callbacks.
+  test.input.resize(xe::round_up(size_t(test.info.input_pitch) *
+                                     xe::round_up(offset_y + height, 32) *
+                                     format_info->bytes_per_block(),
+                                 size_t(4096)) +
+                    256);
+  for (auto& byte : test.input) {
+    byte = uint8_t(random());
+  }
+  return test;
+}
+
+// Untiles with the generic per-block path, like callers providing a copy
+// callback get.
+std::vector<uint8_t> UntileGeneric(const UntileTest& test) {
+  UntileInfo info = test.info;
+  Endian endian = info.endian;
+  info.copy_callback = [endian](void* output, const void* input,
+                                size_t length) {
+    CopySwapBlock(endian, output, input, length);
+  };
+  std::vector<uint8_t> output(
+      size_t(info.output_pitch) * info.height *
+          info.output_format_info->bytes_per_block() +
+      256);
+  Untile(output.data(), test.input.data(), &info);
+  return output;
+}
+
+std::vector<uint8_t> UntileSpecialized(const UntileTest& test) {
+  std::vector<uint8_t> output(
+      size_t(test.info.output_pitch) * test.info.height *
+          test.info.output_format_info->bytes_per_block() +
+      256);
+  Untile(output.data(), test.input.data(), &test.info);
+  return output;
+}
+
+// Only the blocks of the region are defined - the generic path may write past
+// them when swapping.
+bool RegionsEqual(const UntileInfo& info, const std::vector<uint8_t>& a,
+                  const std::vector<uint8_t>& b) {
+  uint32_t bytes_per_block = info.output_format_info->bytes_per_block();
+  size_t pitch = size_t(info.output_pitch) * bytes_per_block;
+  for (uint32_t y = 0; y < info.height; ++y) {
+    if (std::memcmp(&a[y * pitch], &b[y * pitch],
+                    info.width * bytes_per_block)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("UNTILE_SPECIALIZED_MATCHES_GENERIC", "[texture_conversion]") {
+  std::mt19937 random(0x360);
+  for (TextureFormat format : kFormats) {
+    const FormatInfo* format_info = FormatInfo::Get(format);
+    for (Endian endian : kEndians) {
+      for (uint32_t i = 0; i < 64; ++i) {
+        // Small and unaligned regions, like mips packed into a tile.
+        uint32_t width = random() % 80 + 1;
+        uint32_t height = random() % 80 + 1;
+        uint32_t offset_x = (i & 1) ? random() % 40 : 0;
+        uint32_t offset_y = (i & 2) ? random() % 40 : 0;
+        auto test = CreateUntileTest(format_info, endian, width, height,
+                                     offset_x, offset_y, random);
+        INFO("format " << format_info->name << ", endian "
+                       << uint32_t(endian) << ", " << width << "x" << height
+                       << " at " << offset_x << "," << offset_y);
+        REQUIRE(RegionsEqual(test.info, UntileGeneric(test),
+                             UntileSpecialized(test)));
+      }
+    }
+  }
+}
+
+// Hidden by default, run with "[.benchmark]" or "[untile_benchmark]".
+TEST_CASE("UNTILE_BENCHMARK", "[.benchmark][untile_benchmark]") {
+  std::mt19937 random(0x360);
+  for (TextureFormat format : kFormats) {
+    const FormatInfo* format_info = FormatInfo::Get(format);
+    for (Endian endian : {Endian::kNone, Endian::k8in32}) {
+      if (endian != Endian::kNone && format_info->bytes_per_block() < 4) {
+        continue;
+      }
+      // 2048x2048 texels.
+      uint32_t size = 2048 / format_info->block_width;
+      auto test = CreateUntileTest(format_info, endian, size, size, 0, 0,
+                                   random);
+      const uint32_t kIterations = 8;
+
+      std::vector<uint8_t> generic_output, specialized_output;
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < kIterations; ++i) {
+        generic_output = UntileGeneric(test);
+      }
+      auto generic_time = std::chrono::steady_clock::now() - start;
+
+      start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < kIterations; ++i) {
+        specialized_output = UntileSpecialized(test);
+      }
+      auto specialized_time = std::chrono::steady_clock::now() - start;
+
+      REQUIRE(RegionsEqual(test.info, generic_output, specialized_output));
+      double generic_ms =
+          std::chrono::duration<double, std::milli>(generic_time).count() /
+          kIterations;
+      double specialized_ms =
+          std::chrono::duration<double, std::milli>(specialized_time)
+              .count() /
+          kIterations;
+      std::printf(
+          "%s, endian %u: generic %.2f ms, specialized %.2f ms (%.1fx)\n",
+          format_info->name, uint32_t(endian), generic_ms, specialized_ms,
+          generic_ms / specialized_ms);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
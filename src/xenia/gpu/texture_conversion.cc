@@ -17,10 +17,15 @@
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/platform.h"
 #include "xenia/base/profiling.h"
 
 #include "third_party/xxhash/xxhash.h"
 
+#if XE_ARCH_AMD64
+#include <tmmintrin.h>
+#endif  // XE_ARCH_AMD64
+
 namespace xe {
 namespace gpu {
 namespace texture_conversion {
@@ -108,6 +113,144 @@ static uint32_t TiledOffset2DColumn(uint32_t x, uint32_t y, uint32_t log2_bpp,
          ((y & 16) << 7) + (((((y & 8) >> 2) + (x >> 3)) & 3) << 6);
 }
 
+static uint32_t GetLog2BytesPerBlock(uint32_t bytes_per_block) {
+  return (bytes_per_block / 4) +
+         ((bytes_per_block / 2) >> (bytes_per_block / 4));
+}
+
+// Copies 16 bytes, swapping them as CopySwapBlock would.
+template <Endian kEndian>
+static void CopySwap16Bytes(uint8_t* output, const uint8_t* input) {
+#if XE_ARCH_AMD64
+  __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+  switch (kEndian) {
+    case Endian::k8in16:
+      data = _mm_shuffle_epi8(
+          data, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15,
+                              14));
+      break;
+    case Endian::k8in32:
+      data = _mm_shuffle_epi8(
+          data, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+                              12));
+      break;
+    case Endian::k16in32:
+      data = _mm_shuffle_epi8(
+          data, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12,
+                              13));
+      break;
+    default:
+      break;
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), data);
+#else
+  uint32_t words[4];
+  std::memcpy(words, input, sizeof(words));
+  for (uint32_t i = 0; i < 4; ++i) {
+    switch (kEndian) {
+      case Endian::k8in16:
+        words[i] = ((words[i] & 0x00FF00FF) << 8) |
+                   ((words[i] >> 8) & 0x00FF00FF);
+        break;
+      case Endian::k8in32:
+        words[i] = xe::byte_swap(words[i]);
+        break;
+      case Endian::k16in32:
+        words[i] = (words[i] << 16) | (words[i] >> 16);
+        break;
+      default:
+        break;
+    }
+  }
+  std::memcpy(output, words, sizeof(words));
+#endif  // XE_ARCH_AMD64
+}
+
+// In the tiled layout, horizontally adjacent blocks are stored contiguously in
+// runs of 16 bytes (8 bytes for 8bpp), aligned to the run size in the row, so
+// whole runs can be copied and swapped at once instead of calling a copy
+// function for every block.
+template <uint32_t kBytesPerBlock, Endian kEndian>
+static void UntileCopySwap(uint8_t* output_buffer, const uint8_t* input_buffer,
+                           const UntileInfo* untile_info) {
+  const uint32_t log2_bpp = GetLog2BytesPerBlock(kBytesPerBlock);
+  const uint32_t run_blocks = kBytesPerBlock == 1 ? 8 : 16 / kBytesPerBlock;
+  const uint32_t output_pitch = untile_info->output_pitch * kBytesPerBlock;
+  const uint32_t offset_x = untile_info->offset_x;
+
+  uint8_t* output_row = output_buffer;
+  for (uint32_t y = 0; y < untile_info->height; y++) {
+    uint32_t tiled_y = untile_info->offset_y + y;
+    auto input_row_offset =
+        TiledOffset2DRow(tiled_y, untile_info->input_pitch, log2_bpp);
+
+    uint8_t* output = output_row;
+    uint32_t x = 0;
+    while (x < untile_info->width) {
+      uint32_t tiled_x = offset_x + x;
+      uint32_t count = std::min(run_blocks - (tiled_x & (run_blocks - 1)),
+                                untile_info->width - x);
+      auto input_offset =
+          TiledOffset2DColumn(tiled_x, tiled_y, log2_bpp, input_row_offset);
+      input_offset >>= log2_bpp;
+      const uint8_t* input = &input_buffer[input_offset * kBytesPerBlock];
+      uint32_t length = count * kBytesPerBlock;
+      if (length == 16) {
+        CopySwap16Bytes<kEndian>(output, input);
+      } else if (kEndian == Endian::kNone) {
+        std::memcpy(output, input, length);
+      } else {
+        // Partial run at the edge of the region - don't access the memory
+        // around it.
+        uint8_t run[16];
+        std::memcpy(run, input, length);
+        CopySwap16Bytes<kEndian>(run, run);
+        std::memcpy(output, run, length);
+      }
+      output += length;
+      x += count;
+    }
+
+    output_row += output_pitch;
+  }
+}
+
+template <uint32_t kBytesPerBlock>
+static bool TryUntileCopySwap(uint8_t* output_buffer,
+                              const uint8_t* input_buffer,
+                              const UntileInfo* untile_info) {
+  // Swapped units crossing block boundaries are left to the generic path.
+  switch (untile_info->endian) {
+    case Endian::kNone:
+      UntileCopySwap<kBytesPerBlock, Endian::kNone>(
+          output_buffer, input_buffer, untile_info);
+      return true;
+    case Endian::k8in16:
+      if (kBytesPerBlock < 2) {
+        return false;
+      }
+      UntileCopySwap<kBytesPerBlock, Endian::k8in16>(
+          output_buffer, input_buffer, untile_info);
+      return true;
+    case Endian::k8in32:
+      if (kBytesPerBlock < 4) {
+        return false;
+      }
+      UntileCopySwap<kBytesPerBlock, Endian::k8in32>(
+          output_buffer, input_buffer, untile_info);
+      return true;
+    case Endian::k16in32:
+      if (kBytesPerBlock < 4) {
+        return false;
+      }
+      UntileCopySwap<kBytesPerBlock, Endian::k16in32>(
+          output_buffer, input_buffer, untile_info);
+      return true;
+    default:
+      return false;
+  }
+}
+
 void Untile(uint8_t* output_buffer, const uint8_t* input_buffer,
             const UntileInfo* untile_info) {
   SCOPE_profile_cpu_f("gpu");
@@ -119,11 +262,41 @@ void Untile(uint8_t* output_buffer, const uint8_t* input_buffer,
       untile_info->input_format_info->bytes_per_block();
   uint32_t output_bytes_per_block =
       untile_info->output_format_info->bytes_per_block();
+
+  if (!untile_info->copy_callback) {
+    assert_true(input_bytes_per_block == output_bytes_per_block);
+    bool untiled = false;
+    switch (input_bytes_per_block) {
+      case 1:
+        untiled =
+            TryUntileCopySwap<1>(output_buffer, input_buffer, untile_info);
+        break;
+      case 2:
+        untiled =
+            TryUntileCopySwap<2>(output_buffer, input_buffer, untile_info);
+        break;
+      case 4:
+        untiled =
+            TryUntileCopySwap<4>(output_buffer, input_buffer, untile_info);
+        break;
+      case 8:
+        untiled =
+            TryUntileCopySwap<8>(output_buffer, input_buffer, untile_info);
+        break;
+      case 16:
+        untiled =
+            TryUntileCopySwap<16>(output_buffer, input_buffer, untile_info);
+        break;
+    }
+    if (untiled) {
+      return;
+    }
+  }
+
   uint32_t output_pitch = untile_info->output_pitch * output_bytes_per_block;
 
   // Bytes per pixel
-  auto log2_bpp = (input_bytes_per_block / 4) +
-                  ((input_bytes_per_block / 2) >> (input_bytes_per_block / 4));
+  auto log2_bpp = GetLog2BytesPerBlock(input_bytes_per_block);
 
   // Offset to the current row, in bytes.
   uint32_t output_row_offset = 0;
@@ -140,10 +313,16 @@ void Untile(uint8_t* output_buffer, const uint8_t* input_buffer,
                                               log2_bpp, input_row_offset);
       input_offset >>= log2_bpp;
 
-      untile_info->copy_callback(
-          &output_buffer[output_offset],
-          &input_buffer[input_offset * input_bytes_per_block],
-          output_bytes_per_block);
+      if (untile_info->copy_callback) {
+        untile_info->copy_callback(
+            &output_buffer[output_offset],
+            &input_buffer[input_offset * input_bytes_per_block],
+            output_bytes_per_block);
+      } else {
+        CopySwapBlock(untile_info->endian, &output_buffer[output_offset],
+                      &input_buffer[input_offset * input_bytes_per_block],
+                      output_bytes_per_block);
+      }
 
       output_offset += output_bytes_per_block;
     }
@@ -43,6 +43,10 @@ typedef struct UntileInfo {
   uint32_t output_pitch;
   const FormatInfo* input_format_info;
   const FormatInfo* output_format_info;
+  // Used by the specialized kernels copying blocks with CopySwapBlock.
+  Endian endian;
+  // Called for each block if the blocks need to be converted. If not set, the
+  // input and output formats must have the same block size.
   UntileCopyBlockCallback copy_callback;
 } UntileInfo;
 
@@ -1038,9 +1038,13 @@ bool TextureCache::ConvertTexture(uint8_t* dest, VkBufferImageCopy* copy_region,
       untile_info.output_pitch = dst_extent.block_pitch_h;
       untile_info.input_format_info = src.format_info();
       untile_info.output_format_info = GetFormatInfo(src.format);
-      untile_info.copy_callback = [=](auto o, auto i, auto l) {
-        copy_block(src.endianness, o, i, l);
-      };
+      untile_info.endian = src.endianness;
+      // Plain copies are done by the specialized untiling kernels.
+      if (untile_info.input_format_info != untile_info.output_format_info) {
+        untile_info.copy_callback = [=](auto o, auto i, auto l) {
+          copy_block(src.endianness, o, i, l);
+        };
+      }
       texture_conversion::Untile(dest, src_mem, &untile_info);
       src_mem += src_pitch * src_extent.block_pitch_v;
       dest += dst_pitch * dst_extent.block_pitch_v;
@@ -14,3 +14,7 @@ DEFINE_bool(headless, false,
             "UI");
 DEFINE_bool(log_high_frequency_kernel_calls, false,
             "Log kernel calls with the kHighFrequency tag.", "Kernel");
+DEFINE_int32(async_file_io_threads, 2,
+             "Number of host threads completing overlapped file reads and "
+             "writes (0 to complete them on the calling guest thread).",
+             "Kernel");
@@ -17,6 +17,7 @@
 #include "xenia/base/string.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/emulator.h"
+#include "xenia/kernel/kernel_flags.h"
 #include "xenia/kernel/user_module.h"
 #include "xenia/kernel/util/shim_utils.h"
 #include "xenia/kernel/xam/xam_module.h"
@@ -72,6 +73,8 @@ KernelState::~KernelState() {
     dispatch_thread_->Wait(0, 0, 0, nullptr);
   }
 
+  ShutdownAsyncIO();
+
   executable_module_.reset();
   user_modules_.clear();
   kernel_modules_.clear();
@@ -440,6 +443,12 @@ void KernelState::UnloadUserModule(const object_ref<UserModule>& module,
 
 void KernelState::TerminateTitle() {
   XELOGD("KernelState::TerminateTitle");
+
+  // Don't complete I/O for threads that are about to be killed. The I/O threads
+  // take the global lock to complete requests, so stop them before acquiring
+  // it.
+  ShutdownAsyncIO();
+
   auto global_lock = global_critical_region_.Acquire();
 
   // Call terminate routines.
@@ -713,6 +722,67 @@ void KernelState::CompleteOverlappedDeferredEx(
   dispatch_cond_.notify_all();
 }
 
+bool KernelState::has_async_io() const {
+  return cvars::async_file_io_threads > 0;
+}
+
+void KernelState::QueueAsyncIO(std::function<void()> request) {
+  assert_true(has_async_io());
+  {
+    std::lock_guard<std::mutex> lock(async_io_mutex_);
+    if (!async_io_running_) {
+      async_io_running_ = true;
+      for (int32_t i = 0; i < cvars::async_file_io_threads; ++i) {
+        auto thread =
+            xe::threading::Thread::Create({}, [this]() { AsyncIOThread(); });
+        thread->set_name("Kernel I/O Thread");
+        async_io_threads_.push_back(std::move(thread));
+      }
+    }
+    async_io_queue_.push_back(std::move(request));
+  }
+  async_io_cond_.notify_one();
+}
+
+void KernelState::AsyncIOThread() {
+  while (true) {
+    std::function<void()> request;
+    {
+      std::unique_lock<std::mutex> lock(async_io_mutex_);
+      async_io_cond_.wait(lock, [this]() {
+        return !async_io_running_ || !async_io_queue_.empty();
+      });
+      if (!async_io_running_) {
+        break;
+      }
+      request = std::move(async_io_queue_.front());
+      async_io_queue_.pop_front();
+    }
+    request();
+  }
+}
+
+void KernelState::ShutdownAsyncIO() {
+  std::list<std::function<void()>> dropped_requests;
+  {
+    std::lock_guard<std::mutex> lock(async_io_mutex_);
+    if (!async_io_running_) {
+      return;
+    }
+    async_io_running_ = false;
+    dropped_requests.swap(async_io_queue_);
+  }
+  async_io_cond_.notify_all();
+  for (auto& thread : async_io_threads_) {
+    xe::threading::Wait(thread.get(), false);
+  }
+  async_io_threads_.clear();
+  if (!dropped_requests.empty()) {
+    XELOGW("Dropped %zu pending asynchronous I/O requests",
+           dropped_requests.size());
+  }
+}
+
 bool KernelState::Save(ByteStream* stream) {
   XELOGD("Serializing the kernel...");
   stream->Write('KRNL');
@@ -15,11 +15,13 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "xenia/base/bit_map.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/mutex.h"
+#include "xenia/base/threading.h"
 #include "xenia/cpu/export_resolver.h"
 #include "xenia/kernel/util/native_list.h"
 #include "xenia/kernel/util/object_table.h"
@@ -175,10 +177,20 @@ class KernelState {
                                     uint32_t overlapped_ptr, X_RESULT result,
                                     uint32_t extended_error, uint32_t length);
 
+  // Whether overlapped file I/O can be performed with QueueAsyncIO.
+  bool has_async_io() const;
+  // Runs a file I/O request on one of the host I/O threads. The request must
+  // complete the guest-visible state (status block, events, APCs) itself, and
+  // must not take the global critical region while doing the actual I/O.
+  void QueueAsyncIO(std::function<void()> request);
+
   bool Save(ByteStream* stream);
   bool Restore(ByteStream* stream);
 
  private:
+  void AsyncIOThread();
+  void ShutdownAsyncIO();
+
   void LoadKernelModule(object_ref<KernelModule> kernel_module);
 
   Emulator* emulator_;
@@ -213,6 +225,12 @@ class KernelState {
   std::condition_variable_any dispatch_cond_;
   std::list<std::function<void()>> dispatch_queue_;
 
+  std::mutex async_io_mutex_;
+  std::condition_variable async_io_cond_;
+  std::list<std::function<void()>> async_io_queue_;
+  bool async_io_running_ = false;
+  std::vector<std::unique_ptr<xe::threading::Thread>> async_io_threads_;
+
   BitMap tls_bitmap_;
 
   friend class XObject;
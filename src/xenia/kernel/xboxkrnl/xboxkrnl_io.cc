@@ -150,6 +150,60 @@ dword_result_t NtOpenFile(lpdword_t handle_out, dword_t desired_access,
 }
 DECLARE_XBOXKRNL_EXPORT1(NtOpenFile, kFileSystem, kImplemented);
 
+// Performs an overlapped read or write on one of the kernel I/O threads. The
+// status block is filled, the event is set and the APC is queued to the calling
+// thread once the request is done - the same steps the synchronous path takes.
+X_STATUS QueueOverlappedFileIO(object_ref<XFile> file, object_ref<XEvent> ev,
+                               uint32_t apc_routine, uint32_t apc_context,
+                               uint32_t io_status_block_ptr,
+                               uint32_t buffer_ptr, uint32_t buffer_length,
+                               uint64_t byte_offset, bool is_write) {
+  if (byte_offset == uint64_t(-1)) {
+    // Resolve now, other requests may be queued before this one is done.
+    byte_offset = file->ReservePosition(buffer_length, is_write);
+  }
+  if (io_status_block_ptr) {
+    auto io_status_block =
+        kernel_memory()->TranslateVirtual<X_IO_STATUS_BLOCK*>(
+            io_status_block_ptr);
+    io_status_block->status = X_STATUS_PENDING;
+    io_status_block->information = 0;
+  }
+  if (ev) {
+    ev->Reset();
+  }
+
+  auto thread = retain_object(XThread::GetCurrentThread());
+  kernel_state()->QueueAsyncIO([file, ev, thread, apc_routine, apc_context,
+                                io_status_block_ptr, buffer_ptr,
+                                buffer_length, byte_offset, is_write]() {
+    auto io_status_block =
+        io_status_block_ptr
+            ? kernel_memory()->TranslateVirtual<X_IO_STATUS_BLOCK*>(
+                  io_status_block_ptr)
+            : nullptr;
+    uint32_t bytes_transferred = 0;
+    if (is_write) {
+      file->Write(buffer_ptr, buffer_length, byte_offset, &bytes_transferred,
+                  apc_context, io_status_block, false);
+    } else {
+      file->Read(buffer_ptr, buffer_length, byte_offset, &bytes_transferred,
+                 apc_context, io_status_block, false);
+    }
+
+    if (ev) {
+      ev->Set(0, false);
+    }
+
+    // Low bit probably means do not queue to IO ports.
+    if ((apc_routine & ~1u) && apc_context) {
+      thread->EnqueueApc(apc_routine & ~1u, apc_context, io_status_block_ptr,
+                         0);
+    }
+  });
+  return X_STATUS_PENDING;
+}
+
 dword_result_t NtReadFile(dword_t file_handle, dword_t event_handle,
                           lpvoid_t apc_routine_ptr, lpvoid_t apc_context,
                           pointer_t<X_IO_STATUS_BLOCK> io_status_block,
@@ -169,7 +223,7 @@ dword_result_t NtReadFile(dword_t file_handle, dword_t event_handle,
   }
 
   if (XSUCCEEDED(result)) {
-    if (true || file->is_synchronous()) {
+    if (file->is_synchronous() || !kernel_state()->has_async_io()) {
       // Synchronous.
       uint32_t bytes_read = 0;
       result = file->Read(
@@ -200,24 +254,13 @@ dword_result_t NtReadFile(dword_t file_handle, dword_t event_handle,
       // we have written the info out.
       signal_event = true;
     } else {
-      // TODO(benvanik): async.
-
-      // X_STATUS_PENDING if not returning immediately.
-      // XFile is waitable and signalled after each async req completes.
-      // reset the input event (->Reset())
-      /*xeNtReadFileState* call_state = new xeNtReadFileState();
-      XAsyncRequest* request = new XAsyncRequest(
-      state, file,
-      (XAsyncRequest::CompletionCallback)xeNtReadFileCompleted,
-      call_state);*/
-      // result = file->Read(buffer.guest_address(), buffer_length, byte_offset,
-      //                     request);
-      if (io_status_block) {
-        io_status_block->status = X_STATUS_PENDING;
-        io_status_block->information = 0;
-      }
-
-      result = X_STATUS_PENDING;
+      // Completed by an I/O thread, which also signals the event.
+      result = QueueOverlappedFileIO(
+          file, ev, apc_routine_ptr.guest_address(), apc_context,
+          io_status_block.guest_address(), buffer.guest_address(),
+          buffer_length,
+          byte_offset_ptr ? static_cast<uint64_t>(*byte_offset_ptr) : -1,
+          false);
     }
   }
 
@@ -239,9 +282,6 @@ dword_result_t NtWriteFile(dword_t file_handle, dword_t event_handle,
                            pointer_t<X_IO_STATUS_BLOCK> io_status_block,
                            lpvoid_t buffer, dword_t buffer_length,
                            lpqword_t byte_offset_ptr) {
-  // Async not supported yet.
-  assert_zero(apc_routine);
-
   X_STATUS result = X_STATUS_SUCCESS;
   uint32_t info = 0;
 
@@ -260,8 +300,7 @@ dword_result_t NtWriteFile(dword_t file_handle, dword_t event_handle,
 
   // Execute write.
   if (XSUCCEEDED(result)) {
-    // TODO(benvanik): async path.
-    if (true || file->is_synchronous()) {
+    if (file->is_synchronous() || !kernel_state()->has_async_io()) {
       // Synchronous request.
       uint32_t bytes_written = 0;
       result = file->Write(
@@ -272,27 +311,35 @@ dword_result_t NtWriteFile(dword_t file_handle, dword_t event_handle,
         info = bytes_written;
       }
 
-      if (!file->is_synchronous()) {
-        result = X_STATUS_PENDING;
-      }
-
       if (io_status_block) {
-        io_status_block->status = X_STATUS_SUCCESS;
+        io_status_block->status = result;
         io_status_block->information = info;
       }
 
+      // Same as for reads, the APC must be queued even though the request has
+      // already been completed.
+      if ((uint32_t)apc_routine & ~1) {
+        if (apc_context) {
+          auto thread = XThread::GetCurrentThread();
+          thread->EnqueueApc(static_cast<uint32_t>(apc_routine) & ~1u,
+                             apc_context, io_status_block, 0);
+        }
+      }
+
+      if (!file->is_synchronous()) {
+        result = X_STATUS_PENDING;
+      }
+
       // Mark that we should signal the event now. We do this after
       // we have written the info out.
       signal_event = true;
     } else {
-      // X_STATUS_PENDING if not returning immediately.
-      result = X_STATUS_PENDING;
-      info = 0;
-
-      if (io_status_block) {
-        io_status_block->status = X_STATUS_SUCCESS;
-        io_status_block->information = info;
-      }
+      // Completed by an I/O thread, which also signals the event.
+      result = QueueOverlappedFileIO(
+          file, ev, apc_routine, apc_context, io_status_block.guest_address(),
+          buffer.guest_address(), buffer_length,
+          byte_offset_ptr ? static_cast<uint64_t>(*byte_offset_ptr) : -1,
+          true);
     }
   }
 
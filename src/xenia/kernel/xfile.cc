@@ -10,6 +10,8 @@
 #include "xenia/kernel/xfile.h"
 #include "xenia/vfs/virtual_file_system.h"
 
+#include <algorithm>
+
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
@@ -89,12 +91,25 @@ X_STATUS XFile::QueryDirectory(X_FILE_DIRECTORY_INFORMATION* out_info,
   return X_STATUS_SUCCESS;
 }
 
+uint64_t XFile::ReservePosition(uint32_t length, bool is_write) {
+  std::lock_guard<std::mutex> lock(position_lock_);
+  uint64_t offset = position_;
+  uint64_t advance = length;
+  if (!is_write) {
+    uint64_t size = file_->entry()->size();
+    advance = offset < size ? std::min(advance, size - offset) : 0;
+  }
+  position_ = offset + advance;
+  return offset;
+}
+
 X_STATUS XFile::Read(uint32_t buffer_guest_address, uint32_t buffer_length,
                      uint64_t byte_offset, uint32_t* out_bytes_read,
-                     uint32_t apc_context) {
+                     uint32_t apc_context, X_IO_STATUS_BLOCK* io_status_block,
+                     bool advance_position) {
   if (byte_offset == uint64_t(-1)) {
     // Read from current position.
-    byte_offset = position_;
+    byte_offset = position();
   }
 
   size_t bytes_read = 0;
@@ -151,13 +166,21 @@ X_STATUS XFile::Read(uint32_t buffer_guest_address, uint32_t buffer_length,
                   xe::global_critical_region::AcquireDirect(),
                   buffer_guest_address, buffer_length, true, true);
             }
-            position_ += bytes_read;
+            if (advance_position) {
+              std::lock_guard<std::mutex> lock(position_lock_);
+              position_ += bytes_read;
+            }
           }
         }
       }
     }
   }
 
+  if (io_status_block) {
+    io_status_block->status = result;
+    io_status_block->information = uint32_t(bytes_read);
+  }
+
   XIOCompletion::IONotification notify;
   notify.apc_context = apc_context;
   notify.num_bytes = uint32_t(bytes_read);
@@ -175,20 +198,27 @@ X_STATUS XFile::Read(uint32_t buffer_guest_address, uint32_t buffer_length,
 
 X_STATUS XFile::Write(uint32_t buffer_guest_address, uint32_t buffer_length,
                       uint64_t byte_offset, uint32_t* out_bytes_written,
-                      uint32_t apc_context) {
+                      uint32_t apc_context, X_IO_STATUS_BLOCK* io_status_block,
+                      bool advance_position) {
   if (byte_offset == uint64_t(-1)) {
     // Write from current position.
-    byte_offset = position_;
+    byte_offset = position();
   }
 
   size_t bytes_written = 0;
   X_STATUS result =
       file_->WriteSync(memory()->TranslateVirtual(buffer_guest_address),
                        buffer_length, size_t(byte_offset), &bytes_written);
-  if (XSUCCEEDED(result)) {
+  if (XSUCCEEDED(result) && advance_position) {
+    std::lock_guard<std::mutex> lock(position_lock_);
     position_ += bytes_written;
   }
 
+  if (io_status_block) {
+    io_status_block->status = result;
+    io_status_block->information = uint32_t(bytes_written);
+  }
+
   XIOCompletion::IONotification notify;
   notify.apc_context = apc_context;
   notify.num_bytes = uint32_t(bytes_written);
@@ -233,7 +263,7 @@ bool XFile::Save(ByteStream* stream) {
   }
 
   stream->Write(file_->entry()->absolute_path());
-  stream->Write<uint64_t>(position_);
+  stream->Write<uint64_t>(position());
   stream->Write(file_access());
   stream->Write<bool>(
       (file_->entry()->attributes() & vfs::kFileAttributeDirectory) != 0);
@@ -10,6 +10,7 @@
 #ifndef XENIA_KERNEL_XFILE_H_
 #define XENIA_KERNEL_XFILE_H_
 
+#include <mutex>
 #include <string>
 
 #include "xenia/base/filesystem.h"
@@ -92,8 +93,20 @@ class XFile : public XObject {
   const std::string& path() const { return file_->entry()->path(); }
   const std::string& name() const { return file_->entry()->name(); }
 
-  uint64_t position() const { return position_; }
-  void set_position(uint64_t value) { position_ = value; }
+  // The position may be used by guest threads and I/O threads at once.
+  uint64_t position() const {
+    std::lock_guard<std::mutex> lock(position_lock_);
+    return position_;
+  }
+  void set_position(uint64_t value) {
+    std::lock_guard<std::mutex> lock(position_lock_);
+    position_ = value;
+  }
+  // Claims the range of an overlapped request at the current position and
+  // moves the position past it, so that requests queued before this one is
+  // done don't get the same offset. Reads are clamped to the end of the file.
+  // Returns the offset of the range.
+  uint64_t ReservePosition(uint32_t length, bool is_write);
 
   X_STATUS QueryDirectory(X_FILE_DIRECTORY_INFORMATION* out_info, size_t length,
                           const char* file_name, bool restart);
@@ -101,13 +114,21 @@ class XFile : public XObject {
   // Don't do within the global critical region because invalidation callbacks
   // may be triggered (as per the usual rule of not doing I/O within the global
   // critical region).
+  // If io_status_block is provided it's filled before the completion ports and
+  // waiters on the file are notified, as required for overlapped requests.
+  // Overlapped requests don't advance the position when they complete, they
+  // take their range with ReservePosition when they're queued.
   X_STATUS Read(uint32_t buffer_guess_address, uint32_t buffer_length,
                 uint64_t byte_offset, uint32_t* out_bytes_read,
-                uint32_t apc_context);
+                uint32_t apc_context,
+                X_IO_STATUS_BLOCK* io_status_block = nullptr,
+                bool advance_position = true);
 
   X_STATUS Write(uint32_t buffer_guess_address, uint32_t buffer_length,
                  uint64_t byte_offset, uint32_t* out_bytes_written,
-                 uint32_t apc_context);
+                 uint32_t apc_context,
+                 X_IO_STATUS_BLOCK* io_status_block = nullptr,
+                 bool advance_position = true);
 
   X_STATUS SetLength(size_t length);
 
@@ -138,6 +159,7 @@ class XFile : public XObject {
 
   // TODO(benvanik): create flags, open state, etc.
 
+  mutable std::mutex position_lock_;
   uint64_t position_ = 0;
 
   xe::filesystem::WildcardEngine find_engine_;
@@ -22,6 +22,9 @@
 #include "xenia/base/threading.h"
 #include "xenia/cpu/mmio_handler.h"
 
+#include "third_party/snappy/snappy.h"
+#include "third_party/xxhash/xxhash.h"
+
 // TODO(benvanik): move xbox.h out
 #include "xenia/xbox.h"
 
@@ -177,6 +180,8 @@ bool Memory::Initialize() {
   heaps_.vE0000000.Initialize(this, virtual_membase_, 0xE0000000, 0x1FD00000,
                               4096, &heaps_.physical);
 
+  system_heap_pool_.Initialize(LookupHeapByType(false, 4096));
+
   // Protect the first and last 64kb of memory.
   heaps_.v00000000.AllocFixed(
       0x00000000, 0x10000, 0x10000,
@@ -288,6 +293,25 @@ int Memory::MapViews(uint8_t* mapping_base) {
       return 1;
     }
   }
+
+  if (cvars::huge_pages) {
+    // Heaps still protect and watch single 4 KB pages, the system splits the
+    // huge pages involved as needed.
+    size_t advised_count = 0;
+    for (size_t n = 0; n < xe::countof(map_info); n++) {
+      size_t length = map_info[n].virtual_address_end -
+                      map_info[n].virtual_address_start + 1;
+      if (xe::memory::AdviseHugePages(views_.all_views[n], length)) {
+        ++advised_count;
+      }
+    }
+    if (advised_count) {
+      XELOGI("Guest memory: %zu of %zu views advised to use huge pages",
+             advised_count, xe::countof(map_info));
+    } else {
+      XELOGW("Guest memory: huge pages are not available on the host");
+    }
+  }
   return 0;
 }
 
@@ -307,6 +331,7 @@ void Memory::Reset() {
   heaps_.v80000000.Reset();
   heaps_.v90000000.Reset();
   heaps_.physical.Reset();
+  system_heap_pool_.Reset();
 }
 
 const BaseHeap* Memory::LookupHeap(uint32_t address) const {
@@ -526,10 +551,19 @@ void Memory::EnablePhysicalMemoryAccessCallbacks(
 
 uint32_t Memory::SystemHeapAlloc(uint32_t size, uint32_t alignment,
                                  uint32_t system_heap_flags) {
-  // TODO(benvanik): lightweight pool.
   bool is_physical = !!(system_heap_flags & kSystemHeapPhysical);
-  auto heap = LookupHeapByType(is_physical, 4096);
   uint32_t address;
+  if (!is_physical) {
+    // Physical allocations are usually accessed by the GPU or audio hardware,
+    // which watch and invalidate whole pages, so only virtual ones are pooled.
+    auto global_lock = global_critical_region_.Acquire();
+    address = system_heap_pool_.Alloc(size, alignment);
+    if (address) {
+      Zero(address, size);
+      return address;
+    }
+  }
+  auto heap = LookupHeapByType(is_physical, 4096);
   if (!heap->Alloc(size, alignment,
                    kMemoryAllocationReserve | kMemoryAllocationCommit,
                    kMemoryProtectRead | kMemoryProtectWrite, false, &address)) {
@@ -543,7 +577,12 @@ void Memory::SystemHeapFree(uint32_t address) {
   if (!address) {
     return;
   }
-  // TODO(benvanik): lightweight pool.
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    if (system_heap_pool_.Free(address)) {
+      return;
+    }
+  }
   auto heap = LookupHeap(address);
   heap->Release(address);
 }
@@ -579,24 +618,28 @@ void Memory::DumpMap() {
   XELOGE("");
 }
 
-bool Memory::Save(ByteStream* stream) {
+bool Memory::Save(ByteStream* stream, bool incremental) {
   XELOGD("Serializing memory...");
-  heaps_.v00000000.Save(stream);
-  heaps_.v40000000.Save(stream);
-  heaps_.v80000000.Save(stream);
-  heaps_.v90000000.Save(stream);
-  heaps_.physical.Save(stream);
+  heaps_.v00000000.Save(stream, incremental);
+  heaps_.v40000000.Save(stream, incremental);
+  heaps_.v80000000.Save(stream, incremental);
+  heaps_.v90000000.Save(stream, incremental);
+  heaps_.physical.Save(stream, incremental);
+  system_heap_pool_.Save(stream);
 
   return true;
 }
 
-bool Memory::Restore(ByteStream* stream) {
+bool Memory::Restore(ByteStream* stream, ByteStream* base_stream) {
   XELOGD("Restoring memory...");
-  heaps_.v00000000.Restore(stream);
-  heaps_.v40000000.Restore(stream);
-  heaps_.v80000000.Restore(stream);
-  heaps_.v90000000.Restore(stream);
-  heaps_.physical.Restore(stream);
+  if (!heaps_.v00000000.Restore(stream, base_stream) ||
+      !heaps_.v40000000.Restore(stream, base_stream) ||
+      !heaps_.v80000000.Restore(stream, base_stream) ||
+      !heaps_.v90000000.Restore(stream, base_stream) ||
+      !heaps_.physical.Restore(stream, base_stream)) {
+    return false;
+  }
+  system_heap_pool_.Restore(stream);
 
   return true;
 }
@@ -644,6 +687,7 @@ void BaseHeap::Initialize(Memory* memory, uint8_t* membase, uint32_t heap_base,
   page_size_ = page_size;
   host_address_offset_ = host_address_offset;
   page_table_.resize(heap_size / page_size);
+  reserved_page_map_.Resize(uint32_t(page_table_.size()));
 }
 
 void BaseHeap::Dispose() {
@@ -739,9 +783,19 @@ uint32_t BaseHeap::GetUnreservedPageCount() {
   return count;
 }
 
-bool BaseHeap::Save(ByteStream* stream) {
+bool BaseHeap::Save(ByteStream* stream, bool incremental) {
   XELOGD("Heap %.8X-%.8X", heap_base_, heap_base_ + (heap_size_ - 1));
 
+  // Incremental states are relative to the last full one.
+  if (saved_page_hashes_.size() != page_table_.size()) {
+    incremental = false;
+  }
+  std::vector<uint64_t> page_hashes;
+  if (!incremental) {
+    page_hashes.resize(page_table_.size());
+  }
+  std::vector<char> compressed(snappy::MaxCompressedLength(page_size_));
+
   for (size_t i = 0; i < page_table_.size(); i++) {
     auto& page = page_table_[i];
     stream->Write(page.qword);
@@ -750,7 +804,6 @@ bool BaseHeap::Save(ByteStream* stream) {
       continue;
     }
 
-    // TODO(DrChat): write compressed with snappy.
     if (page.state & kMemoryAllocationCommit) {
       void* addr = TranslateRelative(i * page_size_);
 
@@ -758,25 +811,65 @@ bool BaseHeap::Save(ByteStream* stream) {
       memory::Protect(addr, page_size_, memory::PageAccess::kReadWrite,
                       &old_access);
 
-      stream->Write(addr, page_size_);
+      uint64_t hash = XXH64(addr, page_size_, 0);
+      if (incremental && saved_page_hashes_[i] == hash) {
+        stream->Write(kStoredPageUnchanged);
+      } else if (IsPageZero(addr)) {
+        stream->Write(kStoredPageZero);
+      } else {
+        size_t compressed_length;
+        snappy::RawCompress(reinterpret_cast<const char*>(addr), page_size_,
+                            compressed.data(), &compressed_length);
+        if (compressed_length < page_size_) {
+          stream->Write(uint32_t(compressed_length));
+          stream->Write(compressed.data(), compressed_length);
+        } else {
+          // Incompressible.
+          stream->Write(page_size_);
+          stream->Write(addr, page_size_);
+        }
+      }
+      if (!incremental) {
+        page_hashes[i] = hash;
+      }
 
       memory::Protect(addr, page_size_, old_access, nullptr);
     }
   }
 
+  if (!incremental) {
+    saved_page_hashes_ = std::move(page_hashes);
+  }
   return true;
 }
 
-bool BaseHeap::Restore(ByteStream* stream) {
+bool BaseHeap::Restore(ByteStream* stream, ByteStream* base_stream) {
   XELOGD("Heap %.8X-%.8X", heap_base_, heap_base_ + (heap_size_ - 1));
 
+  reserved_page_map_.Reset();
   for (size_t i = 0; i < page_table_.size(); i++) {
     auto& page = page_table_[i];
     page.qword = stream->Read<uint64_t>();
+
+    // The base state is walked in lockstep, its pages are only read if
+    // unchanged in the incremental one.
+    uint32_t base_stored_size = kStoredPageZero;
+    if (base_stream) {
+      PageEntry base_page;
+      base_page.qword = base_stream->Read<uint64_t>();
+      if (base_page.state & kMemoryAllocationCommit) {
+        base_stored_size = base_stream->Read<uint32_t>();
+      }
+    }
+
     if (!page.state) {
       // Unallocated.
+      if (base_stream) {
+        ReadStoredPage(base_stream, base_stored_size, nullptr);
+      }
       continue;
     }
+    reserved_page_map_.MarkUsed(uint32_t(i), 1);
 
     memory::PageAccess page_access = memory::PageAccess::kNoAccess;
     if ((page.current_protect & kMemoryProtectRead) &&
@@ -796,24 +889,88 @@ bool BaseHeap::Restore(ByteStream* stream) {
 
     // Now read into memory. We'll set R/W protection first, then set the
     // protection back to its previous state.
-    // TODO(DrChat): read compressed with snappy.
+    bool base_page_read = false;
     if (page.state & kMemoryAllocationCommit) {
       void* addr = TranslateRelative(i * page_size_);
       xe::memory::Protect(addr, page_size_, memory::PageAccess::kReadWrite,
                           nullptr);
 
-      stream->Read(addr, page_size_);
+      uint32_t stored_size = stream->Read<uint32_t>();
+      if (stored_size == kStoredPageUnchanged) {
+        if (!base_stream) {
+          XELOGE("BaseHeap::Restore: incremental state without a base state");
+          return false;
+        }
+        if (!ReadStoredPage(base_stream, base_stored_size, addr)) {
+          return false;
+        }
+        base_page_read = true;
+      } else if (!ReadStoredPage(stream, stored_size, addr)) {
+        return false;
+      }
 
       xe::memory::Protect(addr, page_size_, page_access, nullptr);
     }
+    if (base_stream && !base_page_read) {
+      ReadStoredPage(base_stream, base_stored_size, nullptr);
+    }
   }
 
   return true;
 }
 
+bool BaseHeap::IsPageZero(const void* addr) const {
+  auto words = reinterpret_cast<const uint64_t*>(addr);
+  for (uint32_t i = 0; i < page_size_ / sizeof(uint64_t); ++i) {
+    if (words[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BaseHeap::ReadStoredPage(ByteStream* stream, uint32_t stored_size,
+                              void* addr) {
+  if (stored_size == kStoredPageZero) {
+    if (addr) {
+      std::memset(addr, 0, page_size_);
+    }
+    return true;
+  }
+  if (stored_size == page_size_) {
+    if (addr) {
+      stream->Read(addr, page_size_);
+    } else {
+      stream->Advance(page_size_);
+    }
+    return true;
+  }
+  if (stored_size > page_size_) {
+    XELOGE("BaseHeap::Restore: invalid stored page size %u", stored_size);
+    return false;
+  }
+  if (addr) {
+    // Decompressed straight from the mapped file.
+    auto compressed =
+        reinterpret_cast<const char*>(stream->data() + stream->offset());
+    size_t uncompressed_length;
+    if (!snappy::GetUncompressedLength(compressed, stored_size,
+                                       &uncompressed_length) ||
+        uncompressed_length != page_size_ ||
+        !snappy::RawUncompress(compressed, stored_size,
+                               reinterpret_cast<char*>(addr))) {
+      XELOGE("BaseHeap::Restore: failed to decompress a page");
+      return false;
+    }
+  }
+  stream->Advance(stored_size);
+  return true;
+}
+
 void BaseHeap::Reset() {
   // TODO(DrChat): protect pages.
   std::memset(page_table_.data(), 0, sizeof(PageEntry) * page_table_.size());
+  reserved_page_map_.Reset();
   // TODO(Triang3l): Remove access callbacks from pages if this is a physical
   // memory heap.
 }
@@ -904,6 +1061,7 @@ bool BaseHeap::AllocFixed(uint32_t base_address, uint32_t size,
     page_entry.current_protect = protect;
     page_entry.state = kMemoryAllocationReserve | allocation_type;
   }
+  reserved_page_map_.MarkUsed(start_page_number, page_count);
 
   return true;
 }
@@ -933,83 +1091,23 @@ bool BaseHeap::AllocRange(uint32_t low_address, uint32_t high_address,
   auto global_lock = global_critical_region_.Acquire();
 
   // Find a free page range.
-  // The base page must match the requested alignment, so we first scan for
-  // a free aligned page and only then check for continuous free pages.
-  // TODO(benvanik): optimized searching (free list buckets, bitmap, etc).
+  // The base page must match the requested alignment. Bottom-up ranges end
+  // before the (aligned) high page, top-down ones also leave the space up to
+  // the next multiple of the alignment after the range free.
   uint32_t start_page_number = UINT_MAX;
   uint32_t end_page_number = UINT_MAX;
   uint32_t page_scan_stride = alignment / page_size_;
   high_page_number = high_page_number - (high_page_number % page_scan_stride);
-  if (top_down) {
-    for (int64_t base_page_number =
-             high_page_number - xe::round_up(page_count, page_scan_stride);
-         base_page_number >= low_page_number;
-         base_page_number -= page_scan_stride) {
-      if (page_table_[base_page_number].state != 0) {
-        // Base page not free, skip to next usable page.
-        continue;
-      }
-      // Check requested range to ensure free.
-      start_page_number = uint32_t(base_page_number);
-      end_page_number = uint32_t(base_page_number) + page_count - 1;
+  uint32_t high_gap_page_count =
+      top_down ? xe::round_up(page_count, page_scan_stride) : page_count;
+  if (high_page_number >= high_gap_page_count) {
+    start_page_number = reserved_page_map_.FindFreeRange(
+        low_page_number,
+        high_page_number - high_gap_page_count + page_count - 1, page_count,
+        page_scan_stride, top_down);
+    if (start_page_number != RangeBitMap::kInvalidIndex) {
+      end_page_number = start_page_number + page_count - 1;
       assert_true(end_page_number < page_table_.size());
-      bool any_taken = false;
-      for (uint32_t page_number = uint32_t(base_page_number);
-           !any_taken && page_number <= end_page_number; ++page_number) {
-        bool is_free = page_table_[page_number].state == 0;
-        if (!is_free) {
-          // At least one page in the range is used, skip to next.
-          // We know we'll be starting at least before this page.
-          any_taken = true;
-          if (page_count > page_number) {
-            // Not enough space left to fit entire page range. Breaks outer
-            // loop.
-            base_page_number = -1;
-          } else {
-            base_page_number = page_number - page_count;
-            base_page_number -= base_page_number % page_scan_stride;
-            base_page_number += page_scan_stride;  // cancel out loop logic
-          }
-          break;
-        }
-      }
-      if (!any_taken) {
-        // Found our place.
-        break;
-      }
-      // Retry.
-      start_page_number = end_page_number = UINT_MAX;
-    }
-  } else {
-    for (uint32_t base_page_number = low_page_number;
-         base_page_number <= high_page_number - page_count;
-         base_page_number += page_scan_stride) {
-      if (page_table_[base_page_number].state != 0) {
-        // Base page not free, skip to next usable page.
-        continue;
-      }
-      // Check requested range to ensure free.
-      start_page_number = base_page_number;
-      end_page_number = base_page_number + page_count - 1;
-      bool any_taken = false;
-      for (uint32_t page_number = base_page_number;
-           !any_taken && page_number <= end_page_number; ++page_number) {
-        bool is_free = page_table_[page_number].state == 0;
-        if (!is_free) {
-          // At least one page in the range is used, skip to next.
-          // We know we'll be starting at least after this page.
-          any_taken = true;
-          base_page_number = xe::round_up(page_number + 1, page_scan_stride);
-          base_page_number -= page_scan_stride;  // cancel out loop logic
-          break;
-        }
-      }
-      if (!any_taken) {
-        // Found our place.
-        break;
-      }
-      // Retry.
-      start_page_number = end_page_number = UINT_MAX;
     }
   }
   if (start_page_number == UINT_MAX || end_page_number == UINT_MAX) {
@@ -1049,6 +1147,7 @@ bool BaseHeap::AllocRange(uint32_t low_address, uint32_t high_address,
     page_entry.current_protect = protect;
     page_entry.state = kMemoryAllocationReserve | allocation_type;
   }
+  reserved_page_map_.MarkUsed(start_page_number, page_count);
 
   *out_address = heap_base_ + (start_page_number * page_size_);
   return true;
@@ -1139,6 +1238,8 @@ bool BaseHeap::Release(uint32_t base_address, uint32_t* out_region_size) {
     auto& page_entry = page_table_[page_number];
     page_entry.qword = 0;
   }
+  reserved_page_map_.MarkFree(base_page_number,
+                              base_page_entry.region_page_count);
 
   return true;
 }
@@ -1822,4 +1923,111 @@ uint32_t PhysicalHeap::GetPhysicalAddress(uint32_t address) const {
   return address;
 }
 
+SystemHeapPool::SystemHeapPool() = default;
+
+void SystemHeapPool::Initialize(BaseHeap* heap) {
+  heap_ = heap;
+  Reset();
+}
+
+uint32_t SystemHeapPool::Alloc(uint32_t size, uint32_t alignment) {
+  uint32_t block_size_log2 =
+      std::max(uint32_t(kMinBlockSizeLog2),
+               xe::log2_ceil(std::max(std::max(size, alignment), 1u)));
+  if (block_size_log2 > kMaxBlockSizeLog2) {
+    return 0;
+  }
+  uint32_t size_class = block_size_log2 - kMinBlockSizeLog2;
+  auto& free_blocks = free_blocks_[size_class];
+  if (free_blocks.empty()) {
+    // Slabs are aligned to their size, so any address in them can be mapped
+    // to its slab, and blocks are naturally aligned to their size.
+    uint32_t slab_address;
+    if (!heap_->Alloc(kSlabSize, kSlabSize,
+                      kMemoryAllocationReserve | kMemoryAllocationCommit,
+                      kMemoryProtectRead | kMemoryProtectWrite, false,
+                      &slab_address)) {
+      return 0;
+    }
+    Slab& slab = slabs_[slab_address];
+    slab.size_class = size_class;
+    std::memset(slab.allocated, 0, sizeof(slab.allocated));
+    // Reversed, so blocks are handed out from the beginning of the slab.
+    uint32_t block_size = 1u << block_size_log2;
+    for (uint32_t offset = kSlabSize; offset; offset -= block_size) {
+      free_blocks.push_back(slab_address + offset - block_size);
+    }
+  }
+  uint32_t address = free_blocks.back();
+  free_blocks.pop_back();
+  uint32_t index = (address & (kSlabSize - 1)) >> kMinBlockSizeLog2;
+  uint64_t* allocated = slabs_[address & ~(kSlabSize - 1)].allocated;
+  allocated[index >> 6] |= uint64_t(1) << (index & 63);
+  return address;
+}
+
+bool SystemHeapPool::Free(uint32_t address) {
+  auto it = slabs_.find(address & ~(kSlabSize - 1));
+  if (it == slabs_.end()) {
+    return false;
+  }
+  Slab& slab = it->second;
+  uint32_t size_class = slab.size_class;
+  if (address & ((1u << (size_class + kMinBlockSizeLog2)) - 1)) {
+    XELOGE("SystemHeapPool: freeing %.8X, which isn't the start of a block",
+           address);
+    assert_always();
+    return true;
+  }
+  uint32_t index = (address & (kSlabSize - 1)) >> kMinBlockSizeLog2;
+  uint64_t bit = uint64_t(1) << (index & 63);
+  if (!(slab.allocated[index >> 6] & bit)) {
+    XELOGE("SystemHeapPool: freeing %.8X, which is already free", address);
+    assert_always();
+    return true;
+  }
+  slab.allocated[index >> 6] &= ~bit;
+  free_blocks_[size_class].push_back(address);
+  return true;
+}
+
+void SystemHeapPool::Reset() {
+  slabs_.clear();
+  for (uint32_t i = 0; i < kSizeClassCount; ++i) {
+    free_blocks_[i].clear();
+  }
+}
+
+bool SystemHeapPool::Save(ByteStream* stream) {
+  stream->Write(uint32_t(slabs_.size()));
+  for (auto& it : slabs_) {
+    stream->Write(it.first);
+    stream->Write(it.second.size_class);
+    stream->Write(it.second.allocated, sizeof(it.second.allocated));
+  }
+  for (uint32_t i = 0; i < kSizeClassCount; ++i) {
+    auto& free_blocks = free_blocks_[i];
+    stream->Write(uint32_t(free_blocks.size()));
+    stream->Write(free_blocks.data(), free_blocks.size() * sizeof(uint32_t));
+  }
+  return true;
+}
+
+bool SystemHeapPool::Restore(ByteStream* stream) {
+  Reset();
+  uint32_t slab_count = stream->Read<uint32_t>();
+  for (uint32_t i = 0; i < slab_count; ++i) {
+    uint32_t slab_address = stream->Read<uint32_t>();
+    Slab& slab = slabs_[slab_address];
+    slab.size_class = stream->Read<uint32_t>();
+    stream->Read(slab.allocated, sizeof(slab.allocated));
+  }
+  for (uint32_t i = 0; i < kSizeClassCount; ++i) {
+    auto& free_blocks = free_blocks_[i];
+    free_blocks.resize(stream->Read<uint32_t>());
+    stream->Read(free_blocks.data(), free_blocks.size() * sizeof(uint32_t));
+  }
+  return true;
+}
+
 }  // namespace xe
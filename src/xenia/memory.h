@@ -14,11 +14,13 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "xenia/base/memory.h"
 #include "xenia/base/mutex.h"
+#include "xenia/base/range_bit_map.h"
 #include "xenia/cpu/mmio_handler.h"
 
 namespace xe {
@@ -180,8 +182,13 @@ class BaseHeap {
   // Whether the heap is a guest virtual memory mapping of the physical memory.
   virtual bool IsGuestPhysicalHeap() const { return false; }
 
-  bool Save(ByteStream* stream);
-  bool Restore(ByteStream* stream);
+  // Writes the page table and the contents of all committed pages, snappy
+  // compressed, with zero pages stored as just a marker. If incremental, pages
+  // that are the same as in the last full save are stored as unchanged too.
+  bool Save(ByteStream* stream, bool incremental = false);
+  // Reads pages written by Save. Unchanged pages of an incremental state are
+  // read from base_stream, which must be at the same heap in the full state.
+  bool Restore(ByteStream* stream, ByteStream* base_stream = nullptr);
 
   void Reset();
 
@@ -200,6 +207,23 @@ class BaseHeap {
   uint32_t host_address_offset_;
   xe::global_critical_region global_critical_region_;
   std::vector<PageEntry> page_table_;
+  // Pages with a non-zero state in page_table_, for finding free ranges.
+  RangeBitMap reserved_page_map_;
+
+ private:
+  // Stored size values for committed pages in saved states that are not
+  // followed by page data. Other sizes are either page_size_ for raw pages or
+  // snappy compressed lengths.
+  static const uint32_t kStoredPageZero = 0;
+  static const uint32_t kStoredPageUnchanged = UINT32_MAX;
+
+  bool IsPageZero(const void* addr) const;
+  // Reads (or skips, if addr is null) page data stored by Save.
+  bool ReadStoredPage(ByteStream* stream, uint32_t stored_size, void* addr);
+
+  // Content hashes of pages as of the last full save, to find the ones that
+  // have changed since then in incremental saves.
+  std::vector<uint64_t> saved_page_hashes_;
 };
 
 // Normal heap allowing allocations from guest virtual address ranges.
@@ -272,6 +296,56 @@ class PhysicalHeap : public BaseHeap {
   std::vector<SystemPageFlagsBlock> system_page_flags_;
 };
 
+// Pool for small system heap allocations, so kernel structures don't take a
+// whole page each. Blocks of power of two size classes are carved out of
+// slabs of pages allocated from the heap, and freed blocks are kept on per
+// size class free lists for reuse. Slabs are never released, so blocks keep
+// their guest addresses for as long as they're allocated.
+// Not threadsafe, protected by the memory global critical region.
+class SystemHeapPool {
+ public:
+  SystemHeapPool();
+
+  void Initialize(BaseHeap* heap);
+
+  // Allocates a block from the pool. Returns 0 if the allocation is too large
+  // for the pool or the heap is out of memory.
+  uint32_t Alloc(uint32_t size, uint32_t alignment);
+
+  // Frees a block allocated with Alloc. Returns false if the address doesn't
+  // belong to the pool. Addresses in the pool that aren't the start of an
+  // allocated block (double frees, pointers into a block) are logged and
+  // ignored, so that the block isn't handed out twice.
+  bool Free(uint32_t address);
+
+  // Forgets all slabs, for when the heap is reset.
+  void Reset();
+
+  bool Save(ByteStream* stream);
+  bool Restore(ByteStream* stream);
+
+ private:
+  static const uint32_t kSlabSize = 64 * 1024;
+  static const uint32_t kMinBlockSizeLog2 = 4;
+  static const uint32_t kMaxBlockSizeLog2 = 11;
+  static const uint32_t kSizeClassCount =
+      kMaxBlockSizeLog2 - kMinBlockSizeLog2 + 1;
+
+  // Allocated blocks of a slab are tracked at the granularity of the smallest
+  // size class, by the index of the first kMinBlockSize bytes of the block.
+  static const uint32_t kSlabBitmapSize =
+      (kSlabSize >> kMinBlockSizeLog2) / 64;
+  struct Slab {
+    uint32_t size_class;
+    uint64_t allocated[kSlabBitmapSize];
+  };
+
+  BaseHeap* heap_ = nullptr;
+  // Slab base address -> slab.
+  std::unordered_map<uint32_t, Slab> slabs_;
+  std::vector<uint32_t> free_blocks_[kSizeClassCount];
+};
+
 // Models the entire guest memory system on the console.
 // This exposes interfaces to both virtual and physical memory and a TLB and
 // page table for allocation, mapping, and protection.
@@ -468,8 +542,11 @@ class Memory {
   // Dumps a map of all allocated memory to the log.
   void DumpMap();
 
-  bool Save(ByteStream* stream);
-  bool Restore(ByteStream* stream);
+  // Saves all heaps, see BaseHeap::Save.
+  bool Save(ByteStream* stream, bool incremental = false);
+  // Restores all heaps, base_stream must be at the memory of the full state
+  // for incremental states, see BaseHeap::Restore.
+  bool Restore(ByteStream* stream, ByteStream* base_stream = nullptr);
 
  private:
   int MapViews(uint8_t* mapping_base);
@@ -522,6 +599,9 @@ class Memory {
     PhysicalHeap vE0000000;
   } heaps_;
 
+  // Small kSystemHeapVirtual allocations.
+  SystemHeapPool system_heap_pool_;
+
   friend class BaseHeap;
 
   friend class PhysicalHeap;
@@ -9,7 +9,10 @@
 
 #include "xenia/vfs/device.h"
 
+#include <algorithm>
+
 #include "xenia/base/logging.h"
+#include "xenia/base/string.h"
 
 namespace xe {
 namespace vfs {
@@ -17,5 +20,38 @@ namespace vfs {
 Device::Device(const std::string& mount_path) : mount_path_(mount_path) {}
 Device::~Device() = default;
 
+Entry* Device::ResolvePathFromRoot(Entry* root_entry,
+                                   const std::string& path) {
+  auto global_lock = global_critical_region_.Acquire();
+
+  std::string cache_key;
+  if (is_read_only()) {
+    cache_key = path;
+    std::transform(cache_key.begin(), cache_key.end(), cache_key.begin(),
+                   tolower);
+    auto it = resolved_path_cache_.find(cache_key);
+    if (it != resolved_path_cache_.end()) {
+      return it->second;
+    }
+  }
+
+  // Walk the path, one separator at a time.
+  auto entry = root_entry;
+  auto path_parts = xe::split_path(path);
+  for (auto& part : path_parts) {
+    entry = entry->GetChild(part);
+    if (!entry) {
+      // Not found.
+      break;
+    }
+  }
+
+  if (is_read_only()) {
+    // Titles probing for missing files is common, so remember those too.
+    resolved_path_cache_.emplace(std::move(cache_key), entry);
+  }
+  return entry;
+}
+
 }  // namespace vfs
 }  // namespace xe
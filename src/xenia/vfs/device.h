@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "xenia/base/mutex.h"
 #include "xenia/base/string_buffer.h"
@@ -39,8 +40,16 @@ class Device {
   virtual uint32_t bytes_per_sector() const = 0;
 
  protected:
+  // Walks the path from the root one component at a time. Results are cached
+  // on read-only devices, as their entries never change once initialized.
+  Entry* ResolvePathFromRoot(Entry* root_entry, const std::string& path);
+
   xe::global_critical_region global_critical_region_;
   std::string mount_path_;
+
+ private:
+  // Lowercase relative path -> entry, or nullptr if it doesn't exist.
+  std::unordered_map<std::string, Entry*> resolved_path_cache_;
 };
 
 }  // namespace vfs
@@ -61,18 +61,7 @@ Entry* DiscImageDevice::ResolvePath(const std::string& path) {
 
   XELOGFS("DiscImageDevice::ResolvePath(%s)", path.c_str());
 
-  // Walk the path, one separator at a time.
-  auto entry = root_entry_.get();
-  auto path_parts = xe::split_path(path);
-  for (auto& part : path_parts) {
-    entry = entry->GetChild(part);
-    if (!entry) {
-      // Not found.
-      return nullptr;
-    }
-  }
-
-  return entry;
+  return ResolvePathFromRoot(root_entry_.get(), path);
 }
 
 DiscImageDevice::Error DiscImageDevice::Verify(ParseState* state) {
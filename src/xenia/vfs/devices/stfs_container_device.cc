@@ -165,18 +165,7 @@ Entry* StfsContainerDevice::ResolvePath(const std::string& path) {
 
   XELOGFS("StfsContainerDevice::ResolvePath(%s)", path.c_str());
 
-  // Walk the path, one separator at a time.
-  auto entry = root_entry_.get();
-  auto path_parts = xe::split_path(path);
-  for (auto& part : path_parts) {
-    entry = entry->GetChild(part);
-    if (!entry) {
-      // Not found.
-      return nullptr;
-    }
-  }
-
-  return entry;
+  return ResolvePathFromRoot(root_entry_.get(), path);
 }
 
 StfsContainerDevice::Error StfsContainerDevice::ReadPackageType(
@@ -393,8 +382,6 @@ StfsContainerDevice::Error StfsContainerDevice::ReadEntrySVOD(
       uint32_t block_index = data_block;
       size_t remaining_size = xe::round_up(length, 0x800);
 
-      size_t last_record = -1;
-      size_t last_offset = -1;
       while (remaining_size) {
         const size_t BLOCK_SIZE = 0x800;
 
@@ -404,16 +391,8 @@ StfsContainerDevice::Error StfsContainerDevice::ReadEntrySVOD(
         block_index++;
         remaining_size -= BLOCK_SIZE;
 
-        if (offset - last_offset == 0x800) {
-          // Consecutive, so append to last entry.
-          entry->block_list_[last_record].length += BLOCK_SIZE;
-          last_offset = offset;
-          continue;
-        }
-
-        entry->block_list_.push_back({file_index, offset, BLOCK_SIZE});
-        last_record = entry->block_list_.size() - 1;
-        last_offset = offset;
+        // Consecutive sectors are appended to the last record.
+        entry->AddBlockRecord(file_index, offset, BLOCK_SIZE);
       }
     }
   }
@@ -567,7 +546,7 @@ StfsContainerDevice::Error StfsContainerDevice::ReadSTFS() {
           size_t block_size =
               std::min(static_cast<size_t>(0x1000), remaining_size);
           size_t offset = BlockToOffsetSTFS(block_index);
-          entry->block_list_.push_back({0, offset, block_size});
+          entry->AddBlockRecord(0, offset, block_size);
           remaining_size -= block_size;
           auto block_hash = GetBlockHash(data, block_index, 0);
           if (table_size_shift_ && block_hash.info < 0x80) {
@@ -11,6 +11,7 @@
 #include "xenia/base/math.h"
 #include "xenia/vfs/devices/stfs_container_file.h"
 
+#include <algorithm>
 #include <map>
 
 namespace xe {
@@ -34,6 +35,36 @@ std::unique_ptr<StfsContainerEntry> StfsContainerEntry::Create(
   return std::move(entry);
 }
 
+void StfsContainerEntry::AddBlockRecord(size_t file, size_t offset,
+                                        size_t length) {
+  if (!block_list_.empty()) {
+    auto& last_record = block_list_.back();
+    if (last_record.file == file &&
+        last_record.offset + last_record.length == offset) {
+      last_record.length += length;
+      return;
+    }
+  }
+  block_offsets_.push_back(
+      block_list_.empty() ? 0
+                          : block_offsets_.back() + block_list_.back().length);
+  block_list_.push_back({file, offset, length});
+}
+
+size_t StfsContainerEntry::FindBlockRecord(size_t byte_offset) const {
+  // First record starting after the offset, the one before contains it.
+  auto it = std::upper_bound(block_offsets_.cbegin(), block_offsets_.cend(),
+                             byte_offset);
+  if (it == block_offsets_.cbegin()) {
+    return block_list_.size();
+  }
+  size_t index = size_t(it - block_offsets_.cbegin()) - 1;
+  if (byte_offset - block_offsets_[index] >= block_list_[index].length) {
+    return block_list_.size();
+  }
+  return index;
+}
+
 X_STATUS StfsContainerEntry::Open(uint32_t desired_access, File** out_file) {
   *out_file = new StfsContainerFile(desired_access, this);
   return X_STATUS_SUCCESS;
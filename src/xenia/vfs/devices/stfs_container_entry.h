@@ -43,6 +43,7 @@ class StfsContainerEntry : public Entry {
 
   X_STATUS Open(uint32_t desired_access, File** out_file) override;
 
+  // Physically contiguous ranges of the file data, in file order.
   struct BlockRecord {
     size_t file;
     size_t offset;
@@ -50,6 +51,17 @@ class StfsContainerEntry : public Entry {
   };
   const std::vector<BlockRecord>& block_list() const { return block_list_; }
 
+  // Returns the index of the block record containing the given offset in the
+  // file data, or block_list().size() if it's past the last record.
+  size_t FindBlockRecord(size_t byte_offset) const;
+  // Offset in the file data where the given block record starts.
+  size_t block_record_offset(size_t index) const {
+    return block_offsets_[index];
+  }
+  // Appends a range to the block list, merging it into the last record if it
+  // directly follows it in the same file.
+  void AddBlockRecord(size_t file, size_t offset, size_t length);
+
  private:
   friend class StfsContainerDevice;
 
@@ -58,6 +70,8 @@ class StfsContainerEntry : public Entry {
   size_t data_size_;
   size_t block_;
   std::vector<BlockRecord> block_list_;
+  // Prefix sums of the block record lengths, for looking up offsets.
+  std::vector<size_t> block_offsets_;
 };
 
 }  // namespace vfs
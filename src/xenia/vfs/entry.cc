@@ -9,6 +9,8 @@
 
 #include "xenia/vfs/entry.h"
 
+#include <algorithm>
+
 #include "xenia/base/filesystem.h"
 #include "xenia/base/string.h"
 #include "xenia/vfs/device.h"
@@ -48,13 +50,26 @@ bool Entry::is_read_only() const { return device_->is_read_only(); }
 
 Entry* Entry::GetChild(std::string name) {
   auto global_lock = global_critical_region_.Acquire();
-  // TODO(benvanik): a faster search
+  UpdateChildIndex();
+  std::transform(name.begin(), name.end(), name.begin(), tolower);
+  auto it = child_index_.find(name);
+  return it != child_index_.end() ? it->second : nullptr;
+}
+
+void Entry::UpdateChildIndex() {
+  if (indexed_child_count_ == children_.size()) {
+    return;
+  }
+  child_index_.clear();
+  child_index_.reserve(children_.size());
   for (auto& child : children_) {
-    if (strcasecmp(child->name().c_str(), name.c_str()) == 0) {
-      return child.get();
-    }
+    std::string name = child->name();
+    std::transform(name.begin(), name.end(), name.begin(), tolower);
+    // Keep the first of the names differing only in case, like the old linear
+    // search did.
+    child_index_.emplace(std::move(name), child.get());
   }
-  return nullptr;
+  indexed_child_count_ = children_.size();
 }
 
 Entry* Entry::IterateChildren(const xe::filesystem::WildcardEngine& engine,
@@ -84,6 +99,11 @@ Entry* Entry::CreateEntry(std::string name, uint32_t attributes) {
     return nullptr;
   }
   children_.push_back(std::move(entry));
+  if (indexed_child_count_ + 1 == children_.size()) {
+    std::transform(name.begin(), name.end(), name.begin(), tolower);
+    child_index_.emplace(std::move(name), children_.back().get());
+    ++indexed_child_count_;
+  }
   // TODO(benvanik): resort? would break iteration?
   Touch();
   return children_.back().get();
@@ -106,6 +126,8 @@ bool Entry::Delete(Entry* entry) {
       break;
     }
   }
+  child_index_.clear();
+  indexed_child_count_ = 0;
   Touch();
   return true;
 }
@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "xenia/base/filesystem.h"
@@ -131,6 +132,8 @@ class Entry {
   }
   virtual bool DeleteEntryInternal(Entry* entry) { return false; }
 
+  void UpdateChildIndex();
+
   xe::global_critical_region global_critical_region_;
   Device* device_;
   Entry* parent_;
@@ -144,6 +147,11 @@ class Entry {
   uint64_t access_timestamp_;
   uint64_t write_timestamp_;
   std::vector<std::unique_ptr<Entry>> children_;
+  // Lowercase name -> child, built on the first lookup. Devices append to
+  // children_ directly while populating, so the index is stale whenever it
+  // doesn't cover all of them.
+  std::unordered_map<std::string, Entry*> child_index_;
+  size_t indexed_child_count_ = 0;
 };
 
 }  // namespace vfs
@@ -13,7 +13,11 @@ project("xenia-vfs")
   })
   recursive_platform_files()
   removefiles({"vfs_dump.cc"})
+  removefiles({"testing/*"})
 
+include("testing")
+
+group("src")
 project("xenia-vfs-dump")
   uuid("2EF270C7-41A8-4D0E-ACC5-59693A9CCE32")
   kind("ConsoleApp")
@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2020 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "xenia/base/mapped_memory.h"
+#include "xenia/vfs/devices/stfs_container_device.h"
+#include "xenia/vfs/devices/stfs_container_entry.h"
+#include "xenia/vfs/file.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace vfs {
+namespace test {
+
+namespace {
+
+const size_t kBlockSize = 0x1000;
+// Data blocks between two hash blocks.
+const size_t kBlocksPerHashLevel = 170;
+
+// A file laid out in a single data file the way STFS stores it: 4 KB blocks
+// with a hash block in front of every 170 of them.
+class StfsTestFile {
+ public:
+  StfsTestFile(size_t block_count, size_t size)
+      : device_("\\Device\\Test", L"") {
+    size_t physical_block_count =
+        block_count + block_count / kBlocksPerHashLevel + 1;
+    data_.resize(physical_block_count * kBlockSize);
+    std::mt19937 random(0x360);
+    for (auto& value : data_) {
+      value = uint8_t(random());
+    }
+    mmap_[0] = std::make_unique<MappedMemory>(
+        L"", MappedMemory::Mode::kRead, data_.data(), data_.size());
+
+    entry_ = std::make_unique<TestEntry>(&device_, &mmap_);
+    entry_->set_size(size);
+    for (size_t block = 0; block < block_count; ++block) {
+      size_t offset = (block + block / kBlocksPerHashLevel + 1) * kBlockSize;
+      size_t length = std::min(kBlockSize, size - block * kBlockSize);
+      blocks_.push_back({0, offset, length});
+      entry_->AddBlockRecord(0, offset, length);
+    }
+  }
+
+  StfsContainerEntry* entry() const { return entry_.get(); }
+
+  // Reads by walking a record per block from the start, as ReadSync did
+  // before block records were merged and looked up by offset.
+  size_t ReadLinear(uint8_t* buffer, size_t buffer_length,
+                    size_t byte_offset) const {
+    if (byte_offset >= entry_->size()) {
+      return 0;
+    }
+    size_t remaining_length =
+        std::min(buffer_length, entry_->size() - byte_offset);
+    size_t bytes_read = remaining_length;
+    size_t src_offset = 0;
+    for (auto& record : blocks_) {
+      if (!remaining_length) {
+        break;
+      }
+      if (src_offset + record.length <= byte_offset) {
+        src_offset += record.length;
+        continue;
+      }
+      size_t read_offset =
+          byte_offset > src_offset ? byte_offset - src_offset : 0;
+      size_t read_length =
+          std::min(record.length - read_offset, remaining_length);
+      std::memcpy(buffer, mmap_.at(record.file)->data() + record.offset +
+                              read_offset,
+                  read_length);
+      buffer += read_length;
+      remaining_length -= read_length;
+      src_offset += record.length;
+    }
+    return bytes_read;
+  }
+
+ private:
+  // Lets the size be set without parsing a package.
+  class TestEntry : public StfsContainerEntry {
+   public:
+    TestEntry(Device* device, MultifileMemoryMap* mmap)
+        : StfsContainerEntry(device, nullptr, "test", mmap) {}
+    void set_size(size_t size) { size_ = size; }
+  };
+
+  StfsContainerDevice device_;
+  std::vector<uint8_t> data_;
+  MultifileMemoryMap mmap_;
+  std::unique_ptr<TestEntry> entry_;
+  std::vector<StfsContainerEntry::BlockRecord> blocks_;
+};
+
+struct FileDeleter {
+  void operator()(File* file) const { file->Destroy(); }
+};
+
+std::unique_ptr<File, FileDeleter> OpenFile(StfsContainerEntry* entry) {
+  File* file = nullptr;
+  REQUIRE(entry->Open(0, &file) == X_STATUS_SUCCESS);
+  return std::unique_ptr<File, FileDeleter>(file);
+}
+
+}  // namespace
+
+TEST_CASE("STFS_BLOCK_RECORDS", "[stfs]") {
+  // 600 blocks, the last one partial.
+  size_t size = 600 * kBlockSize - 123;
+  StfsTestFile test_file(600, size);
+  auto entry = test_file.entry();
+
+  // One record per run of blocks between hash blocks.
+  REQUIRE(entry->block_list().size() == 4);
+  REQUIRE(entry->block_record_offset(1) == kBlocksPerHashLevel * kBlockSize);
+  REQUIRE(entry->FindBlockRecord(0) == 0);
+  REQUIRE(entry->FindBlockRecord(kBlocksPerHashLevel * kBlockSize - 1) == 0);
+  REQUIRE(entry->FindBlockRecord(kBlocksPerHashLevel * kBlockSize) == 1);
+  REQUIRE(entry->FindBlockRecord(size - 1) == 3);
+  REQUIRE(entry->FindBlockRecord(size) == entry->block_list().size());
+}
+
+TEST_CASE("STFS_READ", "[stfs]") {
+  size_t size = 600 * kBlockSize - 123;
+  StfsTestFile test_file(600, size);
+  auto file = OpenFile(test_file.entry());
+
+  std::mt19937 random(0x360);
+  std::vector<uint8_t> expected(0x40000), actual(0x40000);
+  for (uint32_t i = 0; i < 2000; ++i) {
+    size_t offset = random() % (size + kBlockSize);
+    size_t length = random() % expected.size() + 1;
+    size_t expected_read =
+        test_file.ReadLinear(expected.data(), length, offset);
+    size_t actual_read = 0;
+    X_STATUS status = file->ReadSync(actual.data(), length, offset,
+                                     &actual_read);
+    if (offset >= size) {
+      REQUIRE(status == X_STATUS_END_OF_FILE);
+      continue;
+    }
+    REQUIRE(status == X_STATUS_SUCCESS);
+    REQUIRE(actual_read == expected_read);
+    REQUIRE(std::memcmp(actual.data(), expected.data(), actual_read) == 0);
+  }
+}
+
+// Hidden by default, run with "[.benchmark]" or "[stfs_benchmark]".
+TEST_CASE("STFS_READ_BENCHMARK", "[.benchmark][stfs_benchmark]") {
+  // 256 MB.
+  const size_t kBlockCount = 65536;
+  const size_t kReadLength = 0x10000;
+  const size_t kReadCount = 4096;
+  size_t size = kBlockCount * kBlockSize;
+  StfsTestFile test_file(kBlockCount, size);
+  auto file = OpenFile(test_file.entry());
+
+  std::mt19937 random(0x360);
+  std::vector<size_t> random_offsets(kReadCount);
+  for (auto& offset : random_offsets) {
+    offset = random() % (size - kReadLength);
+  }
+
+  std::vector<uint8_t> buffer(kReadLength);
+  for (bool sequential : {true, false}) {
+    auto read_offset = [&](size_t i) {
+      return sequential ? i * kReadLength : random_offsets[i];
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kReadCount; ++i) {
+      test_file.ReadLinear(buffer.data(), kReadLength, read_offset(i));
+    }
+    auto linear_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kReadCount; ++i) {
+      size_t bytes_read = 0;
+      file->ReadSync(buffer.data(), kReadLength, read_offset(i), &bytes_read);
+    }
+    auto read_sync_time = std::chrono::steady_clock::now() - start;
+
+    double gigabytes = double(kReadLength * kReadCount) / 1e9;
+    double linear_gbps =
+        gigabytes / std::chrono::duration<double>(linear_time).count();
+    double read_sync_gbps =
+        gigabytes / std::chrono::duration<double>(read_sync_time).count();
+    std::printf("%s 64 KB reads: linear %.1f GB/s, ReadSync %.1f GB/s\n",
+                sequential ? "sequential" : "random", linear_gbps,
+                read_sync_gbps);
+  }
+}
+
+}  // namespace test
+}  // namespace vfs
+}  // namespace xe